@@ -2,6 +2,21 @@
 #include "../yaml/Yaml.hpp"
 #include <iostream>
 #include <fstream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <map>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+#include <memory>
+#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+#if defined(__linux__)
+    #include <sys/stat.h>
+#endif
 
 /*
 Yaml 1.0 spec notes:
@@ -16,6 +31,26 @@ Yaml 1.0 spec notes:
 
 */
 
+/**
+* Document of nested aliases, each level referencing the previous level 10 times.
+*
+*/
+static std::string AliasBomb(const size_t levels)
+{
+    std::string data = "l0: &l0 [x, x, x, x, x, x, x, x, x, x]\n";
+    for(size_t i = 1; i < levels; i++)
+    {
+        const std::string previous = "*l" + std::to_string(i - 1);
+        data += "l" + std::to_string(i) + ": &l" + std::to_string(i) + " [" + previous;
+        for(size_t j = 1; j < 10; j++)
+        {
+            data += ", " + previous;
+        }
+        data += "]\n";
+    }
+    return data;
+}
+
 TEST(Exception, throw)
 {
     {
@@ -132,6 +167,253 @@ TEST(Node, As)
     }
 }
 
+TEST(Node, AsNumbers)
+{
+    {
+        Yaml::Node node = "0x1F";
+        EXPECT_EQ(node.As<int>(), 31);
+        node = "0o17";
+        EXPECT_EQ(node.As<int>(), 15);
+        node = "0b101";
+        EXPECT_EQ(node.As<int>(), 5);
+        node = "1_000_000";
+        EXPECT_EQ(node.As<int>(), 1000000);
+        node = " 42 ";
+        EXPECT_EQ(node.As<int>(), 42);
+        node = "1__0";
+        EXPECT_EQ(node.As<int>(7), 7);
+        node = "12 apples";
+        EXPECT_EQ(node.As<int>(7), 7);
+        node = "70000";
+        EXPECT_EQ(node.As<unsigned short>(7), 7);
+        EXPECT_EQ(node.As<long>(), 70000);
+        node = "-1";
+        EXPECT_EQ(node.As<unsigned int>(7), 7u);
+        node = "18446744073709551615";
+        EXPECT_EQ(node.As<uint64_t>(), 18446744073709551615ULL);
+        EXPECT_EQ(node.As<int64_t>(7), 7);
+        EXPECT_EQ(node.As<int64_t>(), std::numeric_limits<int64_t>::max());
+        node = "-9223372036854775808";
+        EXPECT_EQ(node.As<int64_t>(), std::numeric_limits<int64_t>::min());
+        node = "1e3";
+        EXPECT_EQ(node.As<int>(), 1000);
+    }
+    {
+        Yaml::Node node = "0.1";
+        EXPECT_EQ(node.As<double>(), 0.1);
+        node = "1_000.5";
+        EXPECT_EQ(node.As<double>(), 1000.5);
+        node = "-2.5e-3";
+        EXPECT_EQ(node.As<double>(), -2.5e-3);
+        node = ".5";
+        EXPECT_EQ(node.As<double>(), 0.5);
+        node = "3.141592653589793238462643383279";
+        EXPECT_EQ(node.As<double>(), 3.141592653589793);
+        node = "2.2250738585072014e-308";
+        EXPECT_EQ(node.As<double>(), 2.2250738585072014e-308);
+        node = "123456789012345678901234567890";
+        EXPECT_EQ(node.As<double>(), 123456789012345678901234567890.0);
+        node = ".inf";
+        EXPECT_EQ(node.As<double>(), std::numeric_limits<double>::infinity());
+        node = "1e400";
+        EXPECT_EQ(node.As<double>(1.0), 1.0);
+        EXPECT_EQ(node.As<double>(), std::numeric_limits<double>::infinity());
+        node = "1e39";
+        EXPECT_EQ(node.As<float>(1.0f), 1.0f);
+        node = "1.";
+        EXPECT_EQ(node.As<double>(), 1.0);
+        node = "1e";
+        EXPECT_EQ(node.As<double>(2.0), 2.0);
+    }
+    {
+        Yaml::Node node = "TRUE";
+        EXPECT_EQ(node.As<bool>(), true);
+        node = "Yes";
+        EXPECT_EQ(node.As<bool>(), true);
+        node = "No";
+        EXPECT_EQ(node.As<bool>(true), false);
+        node = "on";
+        EXPECT_EQ(node.As<bool>(), false);
+        node = "off";
+        EXPECT_EQ(node.As<bool>(), false);
+        EXPECT_EQ(node.As<bool>(true), true);
+        node = "maybe";
+        EXPECT_EQ(node.As<bool>(), false);
+        EXPECT_EQ(node.As<bool>(true), true);
+    }
+}
+
+TEST(Node, AsCache)
+{
+    {
+        Yaml::Node node = "1";
+        EXPECT_EQ(node.As<int>(), 1);
+        EXPECT_EQ(node.As<double>(), 1.0);
+        EXPECT_EQ(node.As<bool>(), true);
+        node = "2.5";
+        EXPECT_EQ(node.As<int>(), 2);
+        EXPECT_EQ(node.As<double>(), 2.5);
+        EXPECT_EQ(node.As<bool>(false), false);
+        node = "no";
+        EXPECT_EQ(node.As<bool>(true), false);
+        EXPECT_EQ(node.As<int>(3), 3);
+
+        // Cached floating point numbers are not used for integers.
+        node = "9007199254740993";
+        EXPECT_EQ(node.As<double>(), 9007199254740992.0);
+        EXPECT_EQ(node.As<long long>(), 9007199254740993LL);
+        EXPECT_EQ(node.As<double>(), 9007199254740992.0);
+        EXPECT_EQ(node.As<bool>(true), true);
+        EXPECT_EQ(node.As<long long>(), 9007199254740993LL);
+        node = "7.9";
+        EXPECT_EQ(node.As<int>(), 7);
+        EXPECT_EQ(node.As<double>(), 7.9);
+        EXPECT_EQ(node.As<int>(), 7);
+    }
+    {
+        Yaml::Node root;
+        Yaml::Parse(root, std::string("limit: 250\nlist: [1, \"2\", 3.5]\n"));
+        EXPECT_EQ(root["limit"].As<int>(), 250);
+        EXPECT_EQ(root["list"][1].As<int>(), 2);
+        root["limit"] = "500";
+        EXPECT_EQ(root["limit"].As<int>(), 500);
+
+        const Yaml::Node & limit = root["limit"];
+        const Yaml::Node & item = root["list"][2];
+        std::vector<std::thread> threads;
+        std::atomic<int> sum(0);
+        for(size_t i = 0; i < 4; i++)
+        {
+            threads.push_back(std::thread([&limit, &item, &sum]()
+            {
+                for(size_t j = 0; j < 1000; j++)
+                {
+                    sum += limit.As<int>() + static_cast<int>(item.As<double>() * 2.0);
+                }
+            }));
+        }
+        for(auto & thread : threads)
+        {
+            thread.join();
+        }
+        EXPECT_EQ(sum.load(), 4 * 1000 * 507);
+    }
+}
+
+TEST(Node, AsContainers)
+{
+    Yaml::Node root;
+    Yaml::Parse(root, std::string(
+        "weights: [0.5, -1.25, 3, 1e2]\n"
+        "flags:\n"
+        "  - true\n"
+        "  - no\n"
+        "matrix: [[1, 2], [3, 4]]\n"
+        "limits:\n"
+        "  read: 10\n"
+        "  write: 20\n"));
+
+    std::vector<double> weights = root["weights"].AsVector<double>();
+    ASSERT_EQ(weights.size(), 4);
+    EXPECT_EQ(weights[0], 0.5);
+    EXPECT_EQ(weights[1], -1.25);
+    EXPECT_EQ(weights[2], 3.0);
+    EXPECT_EQ(weights[3], 100.0);
+    EXPECT_EQ(root["weights"].As<std::vector<int> >()[1], -1);
+
+    float buffer[8] = {0.0f};
+    EXPECT_EQ(root["weights"].CopyTo(buffer, 8), 4);
+    EXPECT_EQ(buffer[1], -1.25f);
+    EXPECT_EQ(buffer[4], 0.0f);
+    EXPECT_EQ(root["weights"].CopyTo(buffer, 2), 2);
+
+    std::vector<bool> flags = root["flags"].As<std::vector<bool> >();
+    ASSERT_EQ(flags.size(), 2);
+    EXPECT_EQ(flags[0], true);
+    EXPECT_EQ(flags[1], false);
+
+    std::vector<std::vector<int> > matrix = root["matrix"].As<std::vector<std::vector<int> > >();
+    ASSERT_EQ(matrix.size(), 2);
+    EXPECT_EQ(matrix[1][0], 3);
+
+    std::map<std::string, int> limits = root["limits"].As<std::map<std::string, int> >();
+    ASSERT_EQ(limits.size(), 2);
+    EXPECT_EQ(limits["read"], 10);
+    EXPECT_EQ(limits["write"], 20);
+
+    // Bulk conversion matches conversion of single elements.
+    Yaml::Node mixed;
+    Yaml::Parse(mixed, std::string("[1, \"2.7\", x, -5, 99999999999, yes, 0x10, [1], 1e400, ~]"));
+    const std::vector<int> ints = mixed.AsVector<int>();
+    const std::vector<unsigned int> uints = mixed.AsVector<unsigned int>();
+    const std::vector<double> doubles = mixed.AsVector<double>();
+    const std::vector<bool> bools = mixed.AsVector<bool>();
+    ASSERT_EQ(ints.size(), mixed.Size());
+    ASSERT_EQ(bools.size(), mixed.Size());
+    for(size_t i = 0; i < mixed.Size(); i++)
+    {
+        EXPECT_EQ(ints[i], mixed[i].As<int>());
+        EXPECT_EQ(uints[i], mixed[i].As<unsigned int>());
+        EXPECT_EQ(doubles[i], mixed[i].As<double>());
+        EXPECT_EQ(bools[i], mixed[i].As<bool>());
+    }
+    EXPECT_EQ(ints[1], 2);
+    EXPECT_EQ(ints[4], std::numeric_limits<int>::max());
+    EXPECT_EQ(ints[6], 16);
+    EXPECT_EQ(bools[5], true);
+
+    EXPECT_EQ(root["limits"].AsVector<int>().size(), 0);
+    EXPECT_EQ(root["limits"].CopyTo(buffer, 8), 0);
+    EXPECT_EQ(root["limits"].As<std::vector<int> >().size(), 0);
+    EXPECT_EQ(root["missing"].AsVector<int>().size(), 0);
+    EXPECT_EQ((root["weights"].As<std::map<std::string, int> >().size()), 0);
+    const std::vector<int> defaultValue(3, 7);
+    EXPECT_EQ(root["limits"]["read"].As<std::vector<int> >(defaultValue).size(), 3);
+}
+
+TEST(Node, SetNumbers)
+{
+    Yaml::Node node;
+    node = 42;
+    EXPECT_TRUE(node.IsScalar());
+    EXPECT_EQ(node.DataType(), Yaml::Node::IntegerData);
+    EXPECT_EQ(node.As<std::string>(), "42");
+    EXPECT_EQ(node.As<int>(), 42);
+    node = -9223372036854775807LL - 1;
+    EXPECT_EQ(node.As<std::string>(), "-9223372036854775808");
+    node = 18446744073709551615ULL;
+    EXPECT_EQ(node.DataType(), Yaml::Node::StringData);
+    EXPECT_EQ(node.As<uint64_t>(), 18446744073709551615ULL);
+    node = 0.1;
+    EXPECT_EQ(node.DataType(), Yaml::Node::FloatData);
+    EXPECT_EQ(node.As<std::string>(), "0.1");
+    EXPECT_EQ(node.As<double>(), 0.1);
+    node = 1.0 / 3.0;
+    EXPECT_EQ(node.As<std::string>().size(), 18);
+    EXPECT_EQ(node.As<double>(), 1.0 / 3.0);
+    node = 2.5f;
+    EXPECT_EQ(node.As<std::string>(), "2.5");
+    node = 100.0;
+    EXPECT_EQ(node.As<std::string>(), "100.0");
+    node = -std::numeric_limits<double>::infinity();
+    EXPECT_EQ(node.As<std::string>(), "-.inf");
+    node = true;
+    EXPECT_EQ(node.DataType(), Yaml::Node::BooleanData);
+    EXPECT_EQ(node.As<std::string>(), "true");
+    node.Set(static_cast<unsigned short>(7));
+    EXPECT_EQ(node.As<std::string>(), "7");
+    node.Set("text");
+    EXPECT_EQ(node.DataType(), Yaml::Node::StringData);
+
+    Yaml::Node root;
+    root["count"] = 3;
+    root["ratio"] = 0.25;
+    root["list"].PushBack() = false;
+    std::string output;
+    Yaml::Serialize(root, output);
+    EXPECT_EQ(output, "count: 3\nlist: \n  - false\nratio: 0.25\n");
+}
+
 TEST(Node, Size)
 {
     {
@@ -630,6 +912,1705 @@ TEST(Parse, Valid)
     }
 }
 
+TEST(Parse, Utf8)
+{
+    {
+        const std::string data =
+            "\xEF\xBB\xBF"
+            "greeting: Gr\xC3\xBC\xC3\x9F Gott, \xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF\r\n"
+            "emoji: \"\xF0\x9F\x98\x80\"\r\n"
+            "home: ~/config # Comment \x01\r\n"
+            "long_key_exceeding_sixteen_characters: a value long enough to be scanned in several blocks\n";
+
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, data));
+        EXPECT_EQ(root["greeting"].As<std::string>(), "Gr\xC3\xBC\xC3\x9F Gott, \xE3\x81\x93\xE3\x82\x93\xE3\x81\xAB\xE3\x81\xA1\xE3\x81\xAF");
+        EXPECT_EQ(root["emoji"].As<std::string>(), "\xF0\x9F\x98\x80");
+        EXPECT_EQ(root["home"].As<std::string>(), "~/config");
+        EXPECT_EQ(root["long_key_exceeding_sixteen_characters"].As<std::string>(), "a value long enough to be scanned in several blocks");
+    }
+    {
+        const char * invalid[] =
+        {
+            "key: \xC0\xAF",                 // Overlong encoding.
+            "key: \xED\xA0\x80",             // Surrogate.
+            "key: \xF4\x90\x80\x80",         // Out of range.
+            "key: \x80",                     // Lone continuation byte.
+            "key: \xE3\x81",                 // Truncated sequence.
+            "key: value\x7F",                // Delete.
+            "key: val\rue",                  // Carriage return.
+            "sixteen_characters_key: value \x02 and more text after it"
+        };
+
+        for(size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+        {
+            Yaml::Node root;
+            EXPECT_THROW(Yaml::Parse(root, std::string(invalid[i])), Yaml::ParsingException);
+        }
+    }
+    {
+        Yaml::Node root;
+        try
+        {
+            Yaml::Parse(root, std::string("key: value\nother: ab\x01"));
+            FAIL();
+        }
+        catch(const Yaml::ParsingException & e)
+        {
+            EXPECT_STREQ(e.what(), "Invalid character found. Line 2 column 10");
+        }
+    }
+}
+
+/**
+* @breif Stream buffer that cannot be repositioned, like pipes and std::cin.
+*
+*/
+class UnseekableBuffer : public std::streambuf
+{
+
+public:
+
+    UnseekableBuffer(const std::string & data) :
+        m_Data(data)
+    {
+        char * pData = &m_Data[0];
+        setg(pData, pData, pData + m_Data.size());
+    }
+
+private:
+
+    std::string m_Data;
+
+};
+
+/**
+* @breif Seekable stream buffer, counting bytes handed out to readers.
+*
+*/
+class CountingBuffer : public std::streambuf
+{
+
+public:
+
+    CountingBuffer(const std::string & data) :
+        m_Data(data),
+        m_Read(0)
+    {
+        char * pData = &m_Data[0];
+        setg(pData, pData, pData);
+    }
+
+    size_t Read() const
+    {
+        return m_Read;
+    }
+
+protected:
+
+    virtual int_type underflow()
+    {
+        char * pData = &m_Data[0];
+        const size_t position = static_cast<size_t>(gptr() - pData);
+        if(position >= m_Data.size())
+        {
+            return traits_type::eof();
+        }
+        const size_t size = std::min<size_t>(m_Data.size() - position, 4096);
+        m_Read += size;
+        setg(pData, pData + position, pData + position + size);
+        return traits_type::to_int_type(*gptr());
+    }
+
+    virtual pos_type seekoff(off_type offset, std::ios_base::seekdir dir, std::ios_base::openmode)
+    {
+        char * pData = &m_Data[0];
+        const off_type position = offset + (dir == std::ios_base::beg ? 0 :
+                                            (dir == std::ios_base::cur ? gptr() - pData : static_cast<off_type>(m_Data.size())));
+        if(position < 0 || position > static_cast<off_type>(m_Data.size()))
+        {
+            return pos_type(off_type(-1));
+        }
+        setg(pData, pData + position, pData + position);
+        return pos_type(position);
+    }
+
+    virtual pos_type seekpos(pos_type position, std::ios_base::openmode mode)
+    {
+        return seekoff(off_type(position), std::ios_base::beg, mode);
+    }
+
+private:
+
+    std::string m_Data;
+    size_t      m_Read;
+
+};
+
+TEST(Parse, SeekableStream)
+{
+    // Documents are read up to their end, not to the end of the stream.
+    std::string data = "---\nfirst: 1\n---\nsecond: 2\n...\nthird:\n";
+    for(size_t i = 0; i < 100000; i++)
+    {
+        data += "  - item " + std::to_string(i) + "\n";
+    }
+
+    CountingBuffer buffer(data);
+    std::iostream stream(&buffer);
+
+    Yaml::Node root;
+    EXPECT_NO_THROW(Yaml::Parse(root, stream));
+    EXPECT_EQ(root["first"].As<int>(), 1);
+    EXPECT_NO_THROW(Yaml::Parse(root, stream));
+    EXPECT_EQ(root["second"].As<int>(), 2);
+    EXPECT_LT(buffer.Read(), size_t(262144));
+
+    EXPECT_NO_THROW(Yaml::Parse(root, stream));
+    EXPECT_EQ(root["third"].Size(), 100000);
+    EXPECT_EQ(root["third"][99999].As<std::string>(), "item 99999");
+    EXPECT_TRUE(stream.eof());
+    EXPECT_FALSE(stream.fail());
+}
+
+TEST(Parse, UnseekableStream)
+{
+    const std::string data =
+        "---\n"
+        "first: 1\n"
+        "---\n"
+        "second: 2\n"
+        "...\n"
+        "third: |\n"
+        "  text\n";
+
+    UnseekableBuffer buffer(data);
+    std::iostream stream(&buffer);
+    EXPECT_EQ(stream.tellg(), std::streampos(-1));
+
+    Yaml::Node root;
+    EXPECT_NO_THROW(Yaml::Parse(root, stream));
+    EXPECT_EQ(root.Size(), 1);
+    EXPECT_EQ(root["first"].As<int>(), 1);
+
+    EXPECT_NO_THROW(Yaml::Parse(root, stream));
+    EXPECT_EQ(root.Size(), 1);
+    EXPECT_EQ(root["second"].As<int>(), 2);
+
+    EXPECT_NO_THROW(Yaml::Parse(root, stream));
+    EXPECT_EQ(root.Size(), 1);
+    EXPECT_EQ(root["third"].As<std::string>(), "text\n");
+
+    EXPECT_NO_THROW(Yaml::Parse(root, stream));
+    EXPECT_TRUE(root.IsNone());
+}
+
+TEST(Parse, Anchors)
+{
+    {
+        const std::string data =
+            "anchored: &anchor_name This string will appear as the value of two keys.\n"
+            "other: *anchor_name\n"
+            "base: &base\n"
+            "    name: Everyone has same name\n"
+            "    age: 5\n"
+            "foo:\n"
+            "    <<: *base\n"
+            "    age: 10\n"
+            "list:\n"
+            "    - &item first\n"
+            "    - *item\n"
+            "    - *base\n";
+
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, data));
+        EXPECT_EQ(root["anchored"].As<std::string>(), "This string will appear as the value of two keys.");
+        EXPECT_EQ(root["other"].As<std::string>(), "This string will appear as the value of two keys.");
+
+        Yaml::Node & foo = root["foo"];
+        EXPECT_TRUE(foo.IsMap());
+        EXPECT_EQ(foo.Size(), 2);
+        EXPECT_EQ(foo["name"].As<std::string>(), "Everyone has same name");
+        EXPECT_EQ(foo["age"].As<int>(), 10);
+        EXPECT_EQ(root["base"]["age"].As<int>(), 5);
+
+        Yaml::Node & list = root["list"];
+        EXPECT_EQ(list.Size(), 3);
+        EXPECT_EQ(list[0].As<std::string>(), "first");
+        EXPECT_EQ(list[1].As<std::string>(), "first");
+        EXPECT_TRUE(list[2].IsMap());
+        EXPECT_EQ(list[2]["name"].As<std::string>(), "Everyone has same name");
+
+        // Aliases are sharing content with anchored node.
+        list[2]["name"] = "changed";
+        EXPECT_EQ(root["base"]["name"].As<std::string>(), "changed");
+
+        // Copies are not.
+        Yaml::Node copy = root;
+        copy["list"][2]["name"] = "copied";
+        EXPECT_EQ(root["base"]["name"].As<std::string>(), "changed");
+        EXPECT_EQ(copy["base"]["name"].As<std::string>(), "changed");
+
+        // Clearing an alias does not affect the anchored node.
+        root["other"].Clear();
+        EXPECT_TRUE(root["other"].IsNone());
+        EXPECT_EQ(root["anchored"].As<std::string>(), "This string will appear as the value of two keys.");
+    }
+    {
+        const std::string data =
+            "a: &a [x]\n"
+            "b: &b\n"
+            "  - *a\n"
+            "  - *a\n"
+            "c: &c\n"
+            "  - *b\n"
+            "  - *b\n"
+            "d:\n"
+            "  - *c\n"
+            "  - *c\n";
+
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, data));
+        EXPECT_EQ(root["d"][1][1][0][0].As<std::string>(), "x");
+    }
+    {
+        Yaml::Node root;
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: *unknown")), Yaml::ParsingException);
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: & value")), Yaml::ParsingException);
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: &a\n  sub: *a")), Yaml::ParsingException);
+    }
+}
+
+TEST(Parse, Flow)
+{
+    {
+        const std::string data =
+            "json_map: {\"key\": \"value\", other: [1, 2]}\n"
+            "json_seq: [3, 2, 1, \"takeoff\", 'it''s']\n"
+            "multi_line: [ a,\n"
+            "   b, {c: d}\n"
+            "  ]\n"
+            "empty: []\n"
+            "pairs: [one: 1, two: 2]\n"
+            "urls: [http://example.com, {x: y:z}]\n"
+            "list:\n"
+            "  - {name: foo, id: 1}\n"
+            "  - [nested, [deep]]\n";
+
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, data));
+
+        Yaml::Node & json_map = root["json_map"];
+        EXPECT_TRUE(json_map.IsMap());
+        EXPECT_EQ(json_map.Size(), 2);
+        EXPECT_EQ(json_map["key"].As<std::string>(), "value");
+        EXPECT_EQ(json_map["other"].Size(), 2);
+        EXPECT_EQ(json_map["other"][1].As<int>(), 2);
+
+        Yaml::Node & json_seq = root["json_seq"];
+        EXPECT_TRUE(json_seq.IsSequence());
+        EXPECT_EQ(json_seq.Size(), 5);
+        EXPECT_EQ(json_seq[0].As<int>(), 3);
+        EXPECT_EQ(json_seq[3].As<std::string>(), "takeoff");
+        EXPECT_EQ(json_seq[4].As<std::string>(), "it's");
+
+        Yaml::Node & multi_line = root["multi_line"];
+        EXPECT_EQ(multi_line.Size(), 3);
+        EXPECT_EQ(multi_line[1].As<std::string>(), "b");
+        EXPECT_EQ(multi_line[2]["c"].As<std::string>(), "d");
+
+        EXPECT_TRUE(root["empty"].IsSequence());
+        EXPECT_EQ(root["empty"].Size(), 0);
+
+        EXPECT_EQ(root["pairs"].Size(), 2);
+        EXPECT_EQ(root["pairs"][1]["two"].As<int>(), 2);
+
+        EXPECT_EQ(root["urls"][0].As<std::string>(), "http://example.com");
+        EXPECT_EQ(root["urls"][1]["x"].As<std::string>(), "y:z");
+
+        Yaml::Node & list = root["list"];
+        EXPECT_EQ(list.Size(), 2);
+        EXPECT_EQ(list[0]["name"].As<std::string>(), "foo");
+        EXPECT_EQ(list[0]["id"].As<int>(), 1);
+        EXPECT_EQ(list[1][1][0].As<std::string>(), "deep");
+    }
+    {
+        std::string data = "samples: [";
+        for(size_t i = 0; i < 10000; i++)
+        {
+            data += (i ? ", " : "") + std::to_string(i);
+        }
+        data += "]";
+
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, data));
+        EXPECT_EQ(root["samples"].Size(), 10000);
+        EXPECT_EQ(root["samples"][9999].As<int>(), 9999);
+    }
+    {
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, std::string("[&a {x: 1}, *a]")));
+        EXPECT_EQ(root[1]["x"].As<int>(), 1);
+    }
+    {
+        Yaml::Node root;
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: [1, 2")), Yaml::ParsingException);
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: [1, , 2]")), Yaml::ParsingException);
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: {a: 1} extra")), Yaml::ParsingException);
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: [\"open]")), Yaml::ParsingException);
+    }
+    {
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, std::string("key: [\"a\\\\\", b]")));
+        EXPECT_EQ(root["key"][0].As<std::string>(), "a\\");
+        EXPECT_EQ(root["key"][1].As<std::string>(), "b");
+
+        EXPECT_NO_THROW(Yaml::Parse(root, std::string("key: [\"a\n  \", b]")));
+        EXPECT_EQ(root["key"][1].As<std::string>(), "b");
+
+        EXPECT_NO_THROW(Yaml::Parse(root, std::string("{\"k\":\"x\\\\\"}")));
+        EXPECT_EQ(root["k"].As<std::string>(), "x\\");
+
+        std::string json;
+        Yaml::Serialize(root, json, Yaml::SerializeConfig(2, 64, false, false, Yaml::SerializeConfig::JsonStyle));
+        Yaml::Node parsed;
+        EXPECT_NO_THROW(Yaml::Parse(parsed, json));
+        EXPECT_EQ(parsed["k"].As<std::string>(), "x\\");
+    }
+    {
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, "k: " + std::string(100, '[') + std::string(100, ']')));
+        EXPECT_THROW(Yaml::Parse(root, "k: " + std::string(100000, '[')), Yaml::ParsingException);
+        EXPECT_THROW(Yaml::Parse(root, "k: " + std::string(1000, '[') + std::string(1000, ']')), Yaml::ParsingException);
+    }
+}
+
+TEST(Parse, Document)
+{
+    const std::string data =
+        "# Comment\n"
+        "key: value\n"
+        "list:\n"
+        "  - item\n"
+        "  - nested: [a,\n"
+        "       b]\n";
+
+    {
+        Yaml::Document document;
+        EXPECT_THROW(Yaml::Parse(document, ".", Yaml::ParseConfig()), Yaml::OperationException);
+    }
+    {
+        Yaml::Document document;
+        EXPECT_NO_THROW(Yaml::Parse(document, data, Yaml::ParseConfig(true)));
+        Yaml::Node & root = document.Root();
+        EXPECT_EQ(root["key"].As<std::string>(), "value");
+
+        Yaml::Location location = document.LocationOf(root);
+        EXPECT_EQ(location.Line, 2);
+        EXPECT_EQ(location.Column, 1);
+
+        location = document.LocationOf(root["key"]);
+        EXPECT_EQ(location.Line, 2);
+        EXPECT_EQ(location.Column, 6);
+
+        location = document.LocationOf(root["list"][0]);
+        EXPECT_EQ(location.Line, 4);
+        EXPECT_EQ(location.Column, 5);
+
+        location = document.LocationOf(root["list"][1]["nested"][0]);
+        EXPECT_EQ(location.Line, 5);
+        EXPECT_EQ(location.Column, 14);
+
+        location = document.LocationOf(root["list"][1]["nested"][1]);
+        EXPECT_EQ(location.Line, 6);
+        EXPECT_EQ(location.Column, 8);
+
+        Yaml::Node unknown;
+        location = document.LocationOf(unknown);
+        EXPECT_EQ(location.Line, 0);
+        EXPECT_EQ(location.Column, 0);
+
+        // Added nodes have no location, also if reusing address of erased node.
+        Yaml::Node & list = root["list"];
+        for(size_t i = 0; i < 16; i++)
+        {
+            list.Erase(0);
+            list.PushBack() = "added";
+            EXPECT_EQ(document.LocationOf(list[1]).Line, 0);
+        }
+        root.Erase("key");
+        root["key"] = "added";
+        EXPECT_EQ(document.LocationOf(root["key"]).Line, 0);
+
+        Yaml::Document other;
+        EXPECT_NO_THROW(Yaml::Parse(other, data, Yaml::ParseConfig(true)));
+        EXPECT_EQ(other.LocationOf(other.Root()["key"]).Line, 2);
+        EXPECT_EQ(document.LocationOf(other.Root()["key"]).Line, 0);
+
+        document.Clear();
+        EXPECT_TRUE(document.Root().IsNone());
+        EXPECT_EQ(document.LocationOf(document.Root()).Line, 0);
+    }
+    {
+        Yaml::Document document;
+        EXPECT_NO_THROW(Yaml::Parse(document, std::string(
+            "base: &base\n"
+            "  a: 1\n"
+            "child:\n"
+            "  <<: *base\n"
+            "  b: 2\n"), Yaml::ParseConfig(true)));
+        Yaml::Node & root = document.Root();
+        EXPECT_EQ(root["child"]["a"].As<int>(), 1);
+        EXPECT_EQ(document.LocationOf(root["child"]["a"]).Line, 0);
+        EXPECT_EQ(document.LocationOf(root["child"]["b"]).Line, 5);
+        EXPECT_EQ(document.LocationOf(root["base"]["a"]).Line, 2);
+    }
+    {
+        Yaml::Document document;
+        EXPECT_NO_THROW(Yaml::Parse(document, data));
+        EXPECT_EQ(document.Root()["list"][0].As<std::string>(), "item");
+        EXPECT_EQ(document.LocationOf(document.Root()["key"]).Line, 0);
+    }
+}
+
+TEST(Parse, TypedScalars)
+{
+    const std::string data =
+        "int: 123\n"
+        "negative: -42\n"
+        "hex: 0x1F\n"
+        "octal: 0o17\n"
+        "float: 1.5e3\n"
+        "inf: -.inf\n"
+        "bool: True\n"
+        "null: ~\n"
+        "quoted: \"123\"\n"
+        "text: 12 apples\n"
+        "big: 99999999999999999999\n"
+        "tagged: !!str 456\n"
+        "tagged_int: !!int \"789\"\n"
+        "tagged_float: !!float 2\n"
+        "flow: [1, 2.5, false, !!str 3, x]\n";
+
+    {
+        Yaml::Document document;
+        EXPECT_NO_THROW(Yaml::Parse(document, data, Yaml::ParseConfig(false, true)));
+        Yaml::Node & root = document.Root();
+
+        EXPECT_EQ(root["int"].DataType(), Yaml::Node::IntegerData);
+        EXPECT_EQ(root["int"].As<int>(), 123);
+        EXPECT_EQ(root["int"].As<std::string>(), "123");
+        EXPECT_EQ(root["negative"].As<int>(), -42);
+        EXPECT_EQ(root["hex"].As<int>(), 31);
+        EXPECT_EQ(root["hex"].As<std::string>(), "0x1F");
+        EXPECT_EQ(root["octal"].As<int>(), 15);
+        EXPECT_EQ(root["float"].DataType(), Yaml::Node::FloatData);
+        EXPECT_EQ(root["float"].As<double>(), 1500.0);
+        EXPECT_EQ(root["float"].As<int>(), 1500);
+        EXPECT_EQ(root["inf"].As<double>(), -std::numeric_limits<double>::infinity());
+        EXPECT_EQ(root["bool"].DataType(), Yaml::Node::BooleanData);
+        EXPECT_EQ(root["bool"].As<bool>(), true);
+        EXPECT_EQ(root["null"].DataType(), Yaml::Node::NullData);
+        EXPECT_EQ(root["quoted"].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(root["quoted"].As<int>(), 123);
+        EXPECT_EQ(root["text"].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(root["big"].DataType(), Yaml::Node::FloatData);
+        EXPECT_EQ(root["tagged"].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(root["tagged_int"].DataType(), Yaml::Node::IntegerData);
+        EXPECT_EQ(root["tagged_int"].As<int>(), 789);
+        EXPECT_EQ(root["tagged_float"].DataType(), Yaml::Node::FloatData);
+        EXPECT_EQ(root["flow"][0].DataType(), Yaml::Node::IntegerData);
+        EXPECT_EQ(root["flow"][1].DataType(), Yaml::Node::FloatData);
+        EXPECT_EQ(root["flow"][2].DataType(), Yaml::Node::BooleanData);
+        EXPECT_EQ(root["flow"][2].As<bool>(), false);
+        EXPECT_EQ(root["flow"][3].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(root["flow"][3].As<std::string>(), "3");
+        EXPECT_EQ(root["flow"][4].DataType(), Yaml::Node::StringData);
+
+        Yaml::Node copy = root;
+        EXPECT_EQ(copy["int"].DataType(), Yaml::Node::IntegerData);
+        copy["int"] = "abc";
+        EXPECT_EQ(copy["int"].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(root["int"].DataType(), Yaml::Node::IntegerData);
+
+        std::string output;
+        EXPECT_NO_THROW(Yaml::Serialize(root, output));
+        EXPECT_NE(output.find("int: 123\n"), std::string::npos);
+        EXPECT_NE(output.find("quoted: \"123\"\n"), std::string::npos);
+        EXPECT_NE(output.find("tagged: \"456\"\n"), std::string::npos);
+        EXPECT_NE(output.find("text: 12 apples\n"), std::string::npos);
+
+        // Quoted and "!!str" tagged scalars are parsed back as strings.
+        Yaml::Document parsed;
+        EXPECT_NO_THROW(Yaml::Parse(parsed, output, Yaml::ParseConfig(false, true)));
+        EXPECT_EQ(parsed.Root()["quoted"].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(parsed.Root()["tagged"].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(parsed.Root()["tagged_int"].DataType(), Yaml::Node::IntegerData);
+        EXPECT_EQ(parsed.Root()["negative"].DataType(), Yaml::Node::IntegerData);
+        EXPECT_EQ(parsed.Root()["bool"].DataType(), Yaml::Node::BooleanData);
+        EXPECT_NO_THROW(Yaml::Serialize(copy, output));
+        EXPECT_NE(output.find("quoted: \"123\"\n"), std::string::npos);
+    }
+    {
+        // Plain scalars are written plain, in default mode as well.
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, std::string("a: 1\nb: true\nc: 1.5\nd: \"42\"\ne: \"text\"\n")));
+        std::string output;
+        EXPECT_NO_THROW(Yaml::Serialize(root, output));
+        EXPECT_EQ(output, "a: 1\nb: true\nc: 1.5\nd: \"42\"\ne: text\n");
+        root["d"] = "43";
+        EXPECT_NO_THROW(Yaml::Serialize(root, output));
+        EXPECT_NE(output.find("d: 43\n"), std::string::npos);
+    }
+    {
+        Yaml::Node root;
+        EXPECT_NO_THROW(Yaml::Parse(root, data));
+        EXPECT_EQ(root["int"].DataType(), Yaml::Node::StringData);
+        EXPECT_EQ(root["int"].As<int>(), 123);
+        EXPECT_EQ(root["tagged_int"].DataType(), Yaml::Node::IntegerData);
+    }
+    {
+        Yaml::Node root;
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: !!int abc\n")), Yaml::ParsingException);
+        EXPECT_THROW(Yaml::Parse(root, std::string("key: [!!bool 1]\n")), Yaml::ParsingException);
+        EXPECT_NO_THROW(Yaml::Parse(root, std::string("key: !custom abc\n")));
+        EXPECT_EQ(root["key"].As<std::string>(), "abc");
+    }
+}
+
+namespace BindTest
+{
+    struct Endpoint
+    {
+        std::string host;
+        int port = 80;
+    };
+
+    struct Config
+    {
+        std::string name;
+        double rate = 1.0;
+        bool enabled = false;
+        Endpoint primary;
+        std::vector<Endpoint> replicas;
+        std::vector<float> weights;
+        std::vector<bool> flags;
+        std::map<std::string, int> limits;
+        int untouched = 42;
+    };
+}
+
+YAML_BIND(BindTest::Endpoint, host, port)
+YAML_BIND(BindTest::Config, name, rate, enabled, primary, replicas, weights, flags, limits, untouched)
+
+TEST(Decode, Binding)
+{
+    const std::string data =
+        "name: service\n"
+        "rate: 2.5\n"
+        "enabled: true\n"
+        "unknown: ignored\n"
+        "primary:\n"
+        "  host: example.com\n"
+        "  port: 8080\n"
+        "replicas:\n"
+        "  - host: a.example.com\n"
+        "  - {host: b.example.com, port: 81}\n"
+        "weights: [0.5, 1.5]\n"
+        "flags: [true, false, yes]\n"
+        "limits:\n"
+        "  read: 10\n"
+        "  write: 20\n";
+
+    BindTest::Config config;
+    EXPECT_NO_THROW(Yaml::Decode(data, config));
+    EXPECT_EQ(config.name, "service");
+    EXPECT_EQ(config.rate, 2.5);
+    EXPECT_EQ(config.enabled, true);
+    EXPECT_EQ(config.primary.host, "example.com");
+    EXPECT_EQ(config.primary.port, 8080);
+    ASSERT_EQ(config.replicas.size(), 2);
+    EXPECT_EQ(config.replicas[0].host, "a.example.com");
+    EXPECT_EQ(config.replicas[0].port, 80);
+    EXPECT_EQ(config.replicas[1].port, 81);
+    ASSERT_EQ(config.weights.size(), 2);
+    EXPECT_EQ(config.weights[1], 1.5f);
+    ASSERT_EQ(config.flags.size(), 3);
+    EXPECT_TRUE(config.flags[0]);
+    EXPECT_FALSE(config.flags[1]);
+    EXPECT_TRUE(config.flags[2]);
+    EXPECT_EQ(config.limits["write"], 20);
+    EXPECT_EQ(config.untouched, 42);
+
+    // Present values override fields, missing keys leave them untouched.
+    EXPECT_NO_THROW(Yaml::Decode(std::string("name: other\nrate: 3\n"), config));
+    EXPECT_EQ(config.name, "other");
+    EXPECT_EQ(config.rate, 3.0);
+    EXPECT_EQ(config.primary.host, "example.com");
+    EXPECT_EQ(config.untouched, 42);
+
+    Yaml::Node root;
+    Yaml::Parse(root, std::string("host: h\n"));
+    BindTest::Endpoint endpoint;
+    Yaml::Decode(root, endpoint);
+    EXPECT_EQ(endpoint.host, "h");
+    EXPECT_EQ(endpoint.port, 80);
+    Yaml::Parse(root, std::string("port: invalid\n"));
+    Yaml::Decode(root, endpoint);
+    EXPECT_EQ(endpoint.port, 80);
+    EXPECT_EQ(endpoint.host, "h");
+
+    EXPECT_THROW(Yaml::Decode(std::string("name: [\n"), config), Yaml::ParsingException);
+}
+
+TEST(Serialize, Sinks)
+{
+    Yaml::Node root;
+    Yaml::Parse(root, std::string("name: \"a: b\"\nlist:\n  - 1\n  - 2.5\ntext: |\n  line1\n  line2\n"));
+    root["count"] = 42;
+
+    std::string expected;
+    Yaml::Serialize(root, expected);
+
+    std::string reserved;
+    Yaml::StringSink stringSink(reserved, 1024);
+    EXPECT_GE(reserved.capacity(), size_t(1024));
+    Yaml::Serialize(root, stringSink);
+    EXPECT_EQ(reserved, expected);
+
+    char buffer[256];
+    Yaml::BufferSink bufferSink(buffer, sizeof(buffer));
+    Yaml::Serialize(root, bufferSink);
+    EXPECT_FALSE(bufferSink.Overflow());
+    EXPECT_EQ(std::string(buffer, bufferSink.Size()), expected);
+
+    char small[8];
+    Yaml::BufferSink smallSink(small, sizeof(small));
+    Yaml::Serialize(root, smallSink);
+    EXPECT_TRUE(smallSink.Overflow());
+    EXPECT_EQ(smallSink.Size(), expected.size());
+    EXPECT_EQ(std::string(small, sizeof(small)), expected.substr(0, sizeof(small)));
+
+    FILE * pFile = std::tmpfile();
+    ASSERT_NE(pFile, nullptr);
+    {
+        Yaml::FileSink fileSink(fileno(pFile), 16);
+        Yaml::Serialize(root, fileSink);
+        fileSink.Write(std::string(40, 'x'));
+    }
+    std::string written(expected.size() + 40, '\0');
+    std::rewind(pFile);
+    EXPECT_EQ(std::fread(&written[0], 1, written.size(), pFile), written.size());
+    EXPECT_EQ(std::fgetc(pFile), EOF);
+    EXPECT_EQ(written, expected + std::string(40, 'x'));
+    std::fclose(pFile);
+
+    Yaml::FileSink badSink(-1, 4);
+    badSink.Write("data", 4);
+    EXPECT_THROW(badSink.Write("more", 4), Yaml::OperationException);
+}
+
+TEST(Serialize, File)
+{
+    Yaml::Node root;
+    for(int i = 0; i < 1000; i++)
+    {
+        Yaml::Node & item = root["items"].PushBack();
+        item["id"] = i;
+        item["name"] = "item " + std::to_string(i);
+    }
+
+    std::string expected;
+    Yaml::Serialize(root, expected);
+
+    const char * filename = "test_serialize_file.yaml";
+    Yaml::Serialize(root, filename, Yaml::SerializeConfig(), Yaml::FileConfig(64));
+    std::ifstream plainFile(filename, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(plainFile)), std::istreambuf_iterator<char>());
+    plainFile.close();
+    EXPECT_EQ(written, expected);
+
+    // Overwriting in place truncates remaining data of longer file.
+    Yaml::Node small;
+    small["key"] = "value";
+    Yaml::Serialize(small, filename);
+    std::ifstream shorterFile(filename, std::ios::binary);
+    written.assign((std::istreambuf_iterator<char>(shorterFile)), std::istreambuf_iterator<char>());
+    shorterFile.close();
+    EXPECT_EQ(written, "key: value\n");
+
+    Yaml::Serialize(root, filename);
+#if defined(__linux__)
+    ASSERT_EQ(chmod(filename, 0640), 0);
+#endif
+    Yaml::Serialize(small, filename, Yaml::SerializeConfig(), Yaml::FileConfig(4096, true));
+    std::ifstream atomicFile(filename, std::ios::binary);
+    written.assign((std::istreambuf_iterator<char>(atomicFile)), std::istreambuf_iterator<char>());
+    atomicFile.close();
+    EXPECT_EQ(written, "key: value\n");
+#if defined(__linux__)
+    struct stat status;
+    ASSERT_EQ(stat(filename, &status), 0);
+    EXPECT_EQ(status.st_mode & 0777, 0640);
+#endif
+
+    // Invalid configurations leave the existing file untouched.
+    EXPECT_THROW(Yaml::Serialize(root, filename, Yaml::SerializeConfig(1)), Yaml::OperationException);
+    Yaml::Node parsed;
+    Yaml::Parse(parsed, filename);
+    EXPECT_EQ(parsed["key"].As<std::string>(), "value");
+    std::remove(filename);
+
+    EXPECT_THROW(Yaml::Serialize(root, "missing_directory/file.yaml"), Yaml::OperationException);
+    EXPECT_THROW(Yaml::Serialize(root, "missing_directory/file.yaml", Yaml::SerializeConfig(), Yaml::FileConfig(4096, true)),
+                 Yaml::OperationException);
+}
+
+TEST(Serialize, SerializedSize)
+{
+    Yaml::Node root;
+    Yaml::Parse(root, std::string(
+        "name: \"quoted: value\"\n"
+        "text: |\n  line one\n  line two\n"
+        "list:\n  - 1\n  - 2.5\n  - {a: true, b: ~}\n  - [x, y]\n"));
+    root["long"] = std::string(100, 'w') + " " + std::string(100, 'v') + " tail";
+
+    const Yaml::SerializeConfig configs[] =
+    {
+        Yaml::SerializeConfig(),
+        Yaml::SerializeConfig(4, 0, true, true),
+        Yaml::SerializeConfig(3, 20, false, true)
+    };
+    for(const Yaml::SerializeConfig & config : configs)
+    {
+        std::string data;
+        Yaml::Serialize(root, data, config);
+        const size_t size = Yaml::SerializedSize(root, config);
+        EXPECT_EQ(size, data.size());
+
+        std::vector<char> buffer(size);
+        Yaml::BufferSink sink(buffer.data(), buffer.size());
+        Yaml::Serialize(root, sink, config);
+        EXPECT_FALSE(sink.Overflow());
+        EXPECT_EQ(std::string(buffer.data(), buffer.size()), data);
+    }
+
+    EXPECT_EQ(Yaml::SerializedSize(Yaml::Node()), size_t(0));
+    EXPECT_THROW(Yaml::SerializedSize(root, Yaml::SerializeConfig(1)), Yaml::OperationException);
+
+    const size_t size = Yaml::SerializedSize(root);
+    EXPECT_EQ(Yaml::SerializedSize(root, Yaml::SerializeConfig(), size), size);
+    EXPECT_EQ(Yaml::SerializedSize(root, Yaml::SerializeConfig(), size - 1), size);
+    EXPECT_EQ(Yaml::SerializedSize(root, Yaml::SerializeConfig(), 1), size_t(2));
+
+    Yaml::Node aliased;
+    Yaml::Parse(aliased, AliasBomb(9));
+    EXPECT_EQ(Yaml::SerializedSize(aliased, Yaml::SerializeConfig(), 1048576), size_t(1048577));
+    const Yaml::SerializeConfig flowConfig(2, 64, false, false, Yaml::SerializeConfig::FlowStyle);
+    EXPECT_EQ(Yaml::SerializedSize(aliased, flowConfig, 1048576), size_t(1048577));
+}
+
+TEST(Serialize, Parallel)
+{
+    Yaml::Node root;
+    root["none"];
+    for(int i = 0; i < 50; i++)
+    {
+        Yaml::Node & item = root["items"].PushBack();
+        if(i % 7 == 3)
+        {
+            continue;
+        }
+        item["id"] = i;
+        item["text"] = i % 5 ? std::string("plain") : std::string("multi\nline\n");
+        if(i % 10 == 0)
+        {
+            for(int j = 0; j < 9; j++)
+            {
+                item["values"].PushBack() = j;
+                item["nested"][std::to_string(j)]["x"] = j;
+            }
+        }
+        root["map"]["key" + std::to_string(i)] = i % 3 ? Yaml::Node() : item;
+    }
+    Yaml::Node & deep = root["deep"].PushBack().PushBack();
+    for(int i = 0; i < 20; i++)
+    {
+        deep.PushBack() = i;
+    }
+    root["scalar"] = "value";
+    Yaml::Node & sparse = root["sparse"].PushBack();
+    for(int i = 0; i < 10; i++)
+    {
+        sparse["a" + std::to_string(i)];
+        if(i >= 5)
+        {
+            sparse["a" + std::to_string(i)] = i;
+        }
+    }
+
+    const Yaml::SerializeConfig configs[] =
+    {
+        Yaml::SerializeConfig(),
+        Yaml::SerializeConfig(4, 0, true, true),
+        Yaml::SerializeConfig(3, 8, false, true)
+    };
+    for(const Yaml::SerializeConfig & config : configs)
+    {
+        std::string expected;
+        Yaml::Serialize(root, expected, config);
+
+        for(size_t chunkSize : {1, 2, 3, 8, 16, 0})
+        {
+            std::string parallel;
+            Yaml::Serialize(root, parallel, config, Yaml::ParallelConfig(4, chunkSize));
+            EXPECT_EQ(parallel, expected);
+        }
+    }
+
+    // Leading empty entries, split from the first serialized entry.
+    std::string expected;
+    std::string parallel;
+    Yaml::Serialize(root["sparse"], expected);
+    Yaml::Serialize(root["sparse"], parallel, Yaml::SerializeConfig(), Yaml::ParallelConfig(2, 2));
+    EXPECT_EQ(parallel, expected);
+
+    std::string scalarOutput;
+    Yaml::Serialize(root["scalar"], scalarOutput, Yaml::SerializeConfig(), Yaml::ParallelConfig(2, 1));
+    EXPECT_EQ(scalarOutput, "value\n");
+    Yaml::Serialize(Yaml::Node(), scalarOutput, Yaml::SerializeConfig(), Yaml::ParallelConfig(2, 1));
+    EXPECT_EQ(scalarOutput, "");
+    EXPECT_THROW(Yaml::Serialize(root, scalarOutput, Yaml::SerializeConfig(1), Yaml::ParallelConfig()), Yaml::OperationException);
+}
+
+TEST(Serialize, FlowStyle)
+{
+    const std::string data =
+        "name: \"a, b\"\n"
+        "list: [1, 2.5, true, ~, 0x1F, .inf, text]\n"
+        "map: {x: 1, 'y z': \"q\\\"t\"}\n"
+        "quoted: \"42\"\n";
+    Yaml::Document document;
+    Yaml::Parse(document, data, Yaml::ParseConfig(false, true));
+    Yaml::Node & root = document.Root();
+    root["text"] = "line1\n\tline2\n";
+    root["empty"]["nested"].PushBack();
+
+    const Yaml::SerializeConfig flowConfig(2, 64, false, false, Yaml::SerializeConfig::FlowStyle);
+    std::string flow;
+    Yaml::Serialize(root, flow, flowConfig);
+    EXPECT_EQ(flow, "{empty: {nested: []}, list: [1, 2.5, true, ~, 0x1F, .inf, text], map: {x: 1, y z: \"q\\\"t\"}, "
+                    "name: \"a, b\", quoted: \"42\", text: \"line1\\n\\tline2\\n\"}\n");
+    EXPECT_EQ(Yaml::SerializedSize(root, flowConfig), flow.size());
+
+    // Flow output is parsed back to equal nodes.
+    Yaml::Document parsedDocument;
+    Yaml::Parse(parsedDocument, flow, Yaml::ParseConfig(false, true));
+    Yaml::Node & parsed = parsedDocument.Root();
+    EXPECT_EQ(parsed["text"].As<std::string>(), "line1\n\tline2\n");
+    EXPECT_EQ(parsed["map"]["y z"].As<std::string>(), "q\"t");
+    EXPECT_EQ(parsed["list"][4].As<int>(), 31);
+    EXPECT_EQ(parsed["list"][2].DataType(), Yaml::Node::BooleanData);
+    EXPECT_EQ(parsed["quoted"].DataType(), Yaml::Node::StringData);
+    EXPECT_EQ(parsed["quoted"].As<std::string>(), "42");
+    std::string reserialized;
+    Yaml::Serialize(parsed, reserialized, flowConfig);
+    EXPECT_EQ(reserialized, flow);
+
+    const Yaml::SerializeConfig jsonConfig(2, 64, false, false, Yaml::SerializeConfig::JsonStyle);
+    std::string json;
+    Yaml::Serialize(root, json, jsonConfig, Yaml::ParallelConfig(2, 1));
+    EXPECT_EQ(json, "{\"empty\":{\"nested\":[]},\"list\":[1,2.5,true,null,31,\".inf\",\"text\"],\"map\":{\"x\":1,\"y z\":\"q\\\"t\"},"
+                    "\"name\":\"a, b\",\"quoted\":\"42\",\"text\":\"line1\\n\\tline2\\n\"}\n");
+    Yaml::Serialize(Yaml::Node(), json, jsonConfig);
+    EXPECT_EQ(json, "null\n");
+
+    // Plain scalars of default mode are written plain, quoted ones stay strings.
+    Yaml::Node untyped;
+    Yaml::Parse(untyped, std::string("a: 1\nb: true\nc: [1.5, ~]\nd: \"42\"\ne: text\n"));
+    Yaml::Serialize(untyped, flow, flowConfig);
+    EXPECT_EQ(flow, "{a: 1, b: true, c: [1.5, ~], d: \"42\", e: text}\n");
+    Yaml::Serialize(untyped, json, jsonConfig);
+    EXPECT_EQ(json, "{\"a\":1,\"b\":true,\"c\":[1.5,null],\"d\":\"42\",\"e\":\"text\"}\n");
+    Yaml::Parse(untyped, flow);
+    Yaml::Serialize(untyped, reserialized, flowConfig);
+    EXPECT_EQ(reserialized, flow);
+
+    // Encode of C++ types.
+    std::map<std::string, std::vector<int> > values = { {"a", {1, 2}}, {"b", {}} };
+    std::string encoded;
+    Yaml::StringSink sink(encoded);
+    Yaml::Encode(values, sink, jsonConfig);
+    EXPECT_EQ(encoded, "{\"a\":[1,2],\"b\":[]}\n");
+    encoded.clear();
+    Yaml::Encode(std::vector<std::string>{"x", "y: z", ""}, sink, flowConfig);
+    EXPECT_EQ(encoded, "[x, \"y: z\", \"\"]\n");
+
+    // Block style with flow sequences of short scalars.
+    std::string block;
+    Yaml::Serialize(root, block, Yaml::SerializeConfig(2, 64, false, false, Yaml::SerializeConfig::BlockStyle, 40));
+    EXPECT_NE(block.find("list: [1, 2.5, true, ~, 0x1F, .inf, text]\n"), std::string::npos);
+    EXPECT_NE(block.find("nested: []\n"), std::string::npos);
+    Yaml::Serialize(root, block, Yaml::SerializeConfig(2, 64, false, false, Yaml::SerializeConfig::BlockStyle, 20));
+    EXPECT_NE(block.find("list: \n  - 1\n"), std::string::npos);
+}
+
+TEST(Emitter, Emitter)
+{
+    Yaml::Node root;
+    root["name"] = "emitter";
+    root["count"] = 3;
+    root["ratio"] = 0.5;
+    root["text"] = "line1\nline2\n";
+    for(int i = 0; i < 3; i++)
+    {
+        Yaml::Node & record = root["records"].PushBack();
+        record["id"] = i;
+        record["tags"].PushBack() = "a";
+        record["tags"].PushBack() = "b";
+        record["nested"].PushBack().PushBack() = i;
+    }
+    root["node"]["x"] = true;
+
+    auto emit = [](Yaml::Emitter & emitter, const Yaml::Node & node)
+    {
+        emitter.BeginMap();
+        emitter.Key("count");
+        emitter.Value(3);
+        emitter.Key("name");
+        emitter.Value("emitter");
+        emitter.Key(std::string("node"));
+        emitter.Value(node);
+        emitter.Key("ratio");
+        emitter.Value(0.5);
+        emitter.Key("records");
+        emitter.BeginSeq();
+        for(int i = 0; i < 3; i++)
+        {
+            emitter.BeginMap();
+            emitter.Key("id");
+            emitter.Value(i);
+            emitter.Key("nested");
+            emitter.BeginSeq();
+            emitter.BeginSeq();
+            emitter.Value(i);
+            emitter.End();
+            emitter.End();
+            emitter.Key("tags");
+            emitter.Value(std::vector<std::string>{"a", "b"});
+            emitter.End();
+        }
+        emitter.End();
+        emitter.Key("text");
+        emitter.Value(std::string("line1\nline2\n"));
+        EXPECT_EQ(emitter.Depth(), size_t(1));
+        EXPECT_FALSE(emitter.IsComplete());
+        emitter.End();
+        EXPECT_TRUE(emitter.IsComplete());
+    };
+
+    const Yaml::SerializeConfig configs[] =
+    {
+        Yaml::SerializeConfig(),
+        Yaml::SerializeConfig(4, 0, true, true),
+        Yaml::SerializeConfig(3, 4, false, true),
+        Yaml::SerializeConfig(2, 64, false, false, Yaml::SerializeConfig::FlowStyle),
+        Yaml::SerializeConfig(2, 64, false, false, Yaml::SerializeConfig::JsonStyle)
+    };
+    for(const Yaml::SerializeConfig & config : configs)
+    {
+        std::string expected;
+        Yaml::Serialize(root, expected, config);
+
+        std::string emitted;
+        Yaml::StringSink sink(emitted);
+        Yaml::Emitter emitter(sink, config);
+        emit(emitter, root["node"]);
+        EXPECT_EQ(emitted, expected);
+    }
+
+    // Values of None type are written as null.
+    std::string emitted;
+    Yaml::StringSink sink(emitted);
+    Yaml::Emitter emitter(sink, Yaml::SerializeConfig(2, 64, false, false, Yaml::SerializeConfig::JsonStyle));
+    emitter.BeginSeq();
+    emitter.Value(std::unique_ptr<int>());
+    emitter.Value(std::unique_ptr<int>(new int(5)));
+    emitter.End();
+    EXPECT_EQ(emitted, "[null,5]\n");
+
+    Yaml::Emitter invalid(sink);
+    EXPECT_THROW(invalid.End(), Yaml::OperationException);
+    EXPECT_THROW(invalid.Key("key"), Yaml::OperationException);
+    invalid.BeginMap();
+    EXPECT_THROW(invalid.Value(1), Yaml::OperationException);
+    EXPECT_THROW(invalid.BeginSeq(), Yaml::OperationException);
+    invalid.Key("key");
+    EXPECT_THROW(invalid.Key("key"), Yaml::OperationException);
+    EXPECT_THROW(invalid.End(), Yaml::OperationException);
+    invalid.Value(1);
+    invalid.End();
+    EXPECT_THROW(invalid.Value(2), Yaml::OperationException);
+    EXPECT_THROW(Yaml::Emitter(sink, Yaml::SerializeConfig(1)), Yaml::OperationException);
+}
+
+TEST(Binary, SaveLoad)
+{
+    const std::string data =
+        "int: 123\n"
+        "negative: -42\n"
+        "hex: 0x1F\n"
+        "float: 1.5e3\n"
+        "half: 0.5\n"
+        "inf: -.inf\n"
+        "bool: True\n"
+        "null: ~\n"
+        "text: some text\n"
+        "multi: |\n"
+        "  line1\n"
+        "  line2\n"
+        "list:\n"
+        "  - name: a\n"
+        "    value: 1\n"
+        "  - name: b\n"
+        "    value: 2\n"
+        "  - [1, 2.5, false, x]\n";
+
+    Yaml::Document document;
+    ASSERT_NO_THROW(Yaml::Parse(document, data, Yaml::ParseConfig(false, true)));
+    const Yaml::Node & source = document.Root();
+
+    std::string binary;
+    Yaml::SaveBinary(source, binary);
+    EXPECT_EQ(binary.compare(0, 4, "YAMB"), 0);
+    EXPECT_EQ(binary.find("value"), binary.rfind("value"));
+
+    Yaml::Node root;
+    ASSERT_NO_THROW(Yaml::LoadBinary(root, binary));
+
+    std::string expected;
+    std::string actual;
+    Yaml::Serialize(source, expected);
+    Yaml::Serialize(root, actual);
+    EXPECT_EQ(actual, expected);
+
+    EXPECT_EQ(root["int"].DataType(), Yaml::Node::IntegerData);
+    EXPECT_EQ(root["int"].As<int>(), 123);
+    EXPECT_EQ(root["negative"].As<int>(), -42);
+    EXPECT_EQ(root["hex"].DataType(), Yaml::Node::IntegerData);
+    EXPECT_EQ(root["hex"].As<std::string>(), "0x1F");
+    EXPECT_EQ(root["float"].DataType(), Yaml::Node::FloatData);
+    EXPECT_EQ(root["float"].As<double>(), 1500.0);
+    EXPECT_EQ(root["float"].As<std::string>(), "1.5e3");
+    EXPECT_EQ(root["half"].As<std::string>(), "0.5");
+    EXPECT_EQ(root["inf"].As<double>(), -std::numeric_limits<double>::infinity());
+    EXPECT_EQ(root["bool"].DataType(), Yaml::Node::BooleanData);
+    EXPECT_EQ(root["bool"].As<std::string>(), "True");
+    EXPECT_EQ(root["null"].DataType(), Yaml::Node::NullData);
+    EXPECT_EQ(root["text"].DataType(), Yaml::Node::StringData);
+    EXPECT_EQ(root["multi"].As<std::string>(), "line1\nline2\n");
+    EXPECT_EQ(root["list"].Size(), 3);
+    EXPECT_EQ(root["list"][1]["name"].As<std::string>(), "b");
+    EXPECT_EQ(root["list"][2][1].As<double>(), 2.5);
+
+    Yaml::Node tree;
+    tree["none"].PushBack();
+    tree["none"].PushBack() = "plain";
+    tree["value"] = -1;
+    Yaml::SaveBinary(tree, binary);
+    ASSERT_NO_THROW(Yaml::LoadBinary(root, binary));
+    EXPECT_TRUE(root["none"][0].IsNone());
+    EXPECT_EQ(root["none"][1].As<std::string>(), "plain");
+    EXPECT_EQ(root["value"].As<int>(), -1);
+
+    Yaml::SaveBinary(source, binary);
+    for(size_t i = 0; i < binary.size(); i++)
+    {
+        EXPECT_THROW(Yaml::LoadBinary(root, binary.c_str(), i), Yaml::ParsingException);
+        EXPECT_TRUE(root.IsNone());
+    }
+    std::string invalid = binary;
+    invalid[4] = 3;
+    EXPECT_THROW(Yaml::LoadBinary(root, invalid), Yaml::ParsingException);
+    EXPECT_THROW(Yaml::LoadBinary(root, binary + "x"), Yaml::ParsingException);
+    EXPECT_THROW(Yaml::LoadBinary(root, std::string("YAML\x02\x00\x00")), Yaml::ParsingException);
+    EXPECT_THROW(Yaml::LoadBinary(root, std::string("YAMB\x02\x00\x06", 7)), Yaml::ParsingException);
+    EXPECT_THROW(Yaml::LoadBinary(root, std::string("YAMB\x02\x01\x01k\x02\x02\x00\x00\x00\x00", 14)), Yaml::ParsingException);
+    EXPECT_NO_THROW(Yaml::LoadBinary(root, std::string("YAMB\x02\x01\x01k\x02\x01\x00\x00", 12)));
+    EXPECT_TRUE(root["k"].IsNone());
+
+    std::string nested("YAMB\x02\x00", 6);
+    for(size_t i = 0; i < 100000; i++)
+    {
+        nested.append("\x01\x01", 2);
+    }
+    nested.append(1, '\0');
+    EXPECT_THROW(Yaml::LoadBinary(root, nested), Yaml::ParsingException);
+    EXPECT_TRUE(root.IsNone());
+
+    Yaml::Document aliased;
+    ASSERT_NO_THROW(Yaml::Parse(aliased, AliasBomb(9) + "quoted: [&q \"42\", *q]\n"));
+    Yaml::SaveBinary(aliased.Root(), binary);
+    EXPECT_LT(binary.size(), 1024);
+    ASSERT_NO_THROW(Yaml::LoadBinary(root, binary));
+    EXPECT_EQ(root["l8"].Size(), 10);
+    EXPECT_EQ(root["l8"][9][9][9][9][9][9][9][9][9].As<std::string>(), "x");
+    const Yaml::SerializeConfig flowConfig(2, 64, false, false, Yaml::SerializeConfig::FlowStyle);
+    EXPECT_EQ(Yaml::SerializedSize(root["l2"], flowConfig), Yaml::SerializedSize(aliased.Root()["l2"], flowConfig));
+    Yaml::Serialize(root["quoted"], actual, flowConfig);
+    EXPECT_EQ(actual, "[\"42\", \"42\"]\n");
+
+    EXPECT_THROW(Yaml::LoadBinary(root, std::string("YAMB\x02\x00\x09\x00", 8)), Yaml::ParsingException);
+    EXPECT_THROW(Yaml::LoadBinary(root, std::string("YAMB\x02\x00\x41\x01\x09\x00", 10)), Yaml::ParsingException);
+    EXPECT_NO_THROW(Yaml::LoadBinary(root, std::string("YAMB\x02\x00\x01\x02\x43\x01x\x09\x00", 13)));
+    EXPECT_EQ(root[1].As<std::string>(), "x");
+}
+
+TEST(Mapped, MappedDocument)
+{
+    const std::string data =
+        "int: 123\n"
+        "hex: 0x1F\n"
+        "float: 1.5\n"
+        "bool: true\n"
+        "null: ~\n"
+        "text: some text\n"
+        "list:\n"
+        "  - name: a\n"
+        "    value: 1\n"
+        "  - name: b\n"
+        "    value: 2\n"
+        "  - [1, 2.5, false, x]\n";
+
+    Yaml::Document document;
+    ASSERT_NO_THROW(Yaml::Parse(document, data, Yaml::ParseConfig(false, true)));
+    for(int i = 0; i < 100; i++)
+    {
+        document.Root()["many"]["key " + std::to_string(i)] = i;
+    }
+
+    std::string mapped;
+    Yaml::SaveMapped(document.Root(), mapped);
+
+    Yaml::MappedDocument view;
+    EXPECT_FALSE(view.IsOpen());
+    EXPECT_TRUE(view.Root().IsNone());
+    ASSERT_NO_THROW(view.Open(mapped.c_str(), mapped.size()));
+    EXPECT_TRUE(view.IsOpen());
+
+    const Yaml::NodeView root = view.Root();
+    EXPECT_TRUE(root.IsMap());
+    EXPECT_EQ(root.Size(), 8);
+    EXPECT_EQ(root["int"].As<int>(), 123);
+    EXPECT_EQ(root["int"].NativeValue().Type, Yaml::impl::ScalarValue::IntegerType);
+    EXPECT_EQ(root["hex"].As<int>(), 31);
+    EXPECT_EQ(root["hex"].As<std::string>(), "0x1F");
+    EXPECT_EQ(root["float"].As<double>(), 1.5);
+    EXPECT_EQ(root["bool"].As<bool>(), true);
+    EXPECT_EQ(root["null"].NativeValue().Type, Yaml::impl::ScalarValue::NullType);
+    EXPECT_STREQ(root["text"].Data(), "some text");
+    EXPECT_EQ(root["text"].DataSize(), 9);
+    EXPECT_EQ(root["text"].As<int>(7), 7);
+    EXPECT_TRUE(root["missing"].IsNone());
+    EXPECT_TRUE(root["missing"]["deeper"][3].IsNone());
+    EXPECT_EQ(root["missing"].As<std::string>("default"), "default");
+
+    const Yaml::NodeView list = root["list"];
+    EXPECT_TRUE(list.IsSequence());
+    EXPECT_EQ(list.Size(), 3);
+    EXPECT_EQ(list[1]["name"].As<std::string>(), "b");
+    EXPECT_EQ(list[2][1].As<double>(), 2.5);
+    EXPECT_EQ(list[2][2].As<bool>(true), false);
+    EXPECT_TRUE(list[3].IsNone());
+    EXPECT_TRUE(list["name"].IsNone());
+
+    const Yaml::NodeView many = root["many"];
+    EXPECT_EQ(many.Size(), 100);
+    for(int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(many["key " + std::to_string(i)].As<int>(), i);
+    }
+    std::string previous;
+    for(size_t i = 0; i < many.Size(); i++)
+    {
+        EXPECT_LT(previous, many.Key(i));
+        EXPECT_EQ(many.Value(i).As<int>(), many[many.Key(i)].As<int>());
+        previous = many.Key(i);
+    }
+    EXPECT_THROW(many.Key(100), Yaml::OperationException);
+    EXPECT_THROW(list.Value(0), Yaml::OperationException);
+
+    const char * filename = "test_mapped_document.yamm";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file.write(mapped.c_str(), mapped.size());
+    }
+    Yaml::MappedDocument fileView;
+    ASSERT_NO_THROW(fileView.Open(filename));
+    EXPECT_EQ(fileView.Root()["list"][0]["value"].As<int>(), 1);
+    EXPECT_EQ(fileView.Root()["many"]["key 42"].As<int>(), 42);
+    fileView.Close();
+    EXPECT_FALSE(fileView.IsOpen());
+    std::remove(filename);
+    EXPECT_THROW(fileView.Open(filename), Yaml::OperationException);
+
+    std::string invalid = mapped;
+    invalid[0] = 'X';
+    EXPECT_THROW(view.Open(invalid.c_str(), invalid.size()), Yaml::ParsingException);
+    EXPECT_FALSE(view.IsOpen());
+    EXPECT_THROW(view.Open(mapped.c_str(), mapped.size() - 8), Yaml::ParsingException);
+
+    // Corrupt offset of root payload.
+    invalid = mapped;
+    const uint64_t offset = invalid.size();
+    std::memcpy(&invalid[40], &offset, sizeof(offset));
+    ASSERT_NO_THROW(view.Open(invalid.c_str(), invalid.size()));
+    EXPECT_THROW(view.Root()["int"], Yaml::ParsingException);
+
+    // Misaligned root payload.
+    invalid = mapped;
+    const uint64_t misaligned = 44;
+    std::memcpy(&invalid[40], &misaligned, sizeof(misaligned));
+    ASSERT_NO_THROW(view.Open(invalid.c_str(), invalid.size()));
+    EXPECT_THROW(view.Root()["int"], Yaml::ParsingException);
+
+    // Scalar sizes wrapping around, or without null terminator.
+    Yaml::Node scalar = "text";
+    std::string scalarMapped;
+    Yaml::SaveMapped(scalar, scalarMapped);
+    invalid = scalarMapped;
+    const uint64_t hugeSize = ~static_cast<uint64_t>(0) - 4;
+    std::memcpy(&invalid[32], &hugeSize, sizeof(hugeSize));
+    ASSERT_NO_THROW(view.Open(invalid.c_str(), invalid.size()));
+    EXPECT_THROW(view.Root().AsString(), Yaml::ParsingException);
+    EXPECT_THROW(view.Root().DataSize(), Yaml::ParsingException);
+    invalid = scalarMapped;
+    const uint64_t shortSize = 3;
+    std::memcpy(&invalid[32], &shortSize, sizeof(shortSize));
+    ASSERT_NO_THROW(view.Open(invalid.c_str(), invalid.size()));
+    EXPECT_THROW(view.Root().Data(), Yaml::ParsingException);
+    invalid = scalarMapped;
+    const uint64_t misalignedScalar = 52;
+    std::memcpy(&invalid[40], &misalignedScalar, sizeof(misalignedScalar));
+    ASSERT_NO_THROW(view.Open(invalid.c_str(), invalid.size()));
+    EXPECT_THROW(view.Root().NativeValue(), Yaml::ParsingException);
+}
+
+TEST(Mapped, SharedMemory)
+{
+    const std::string name = "/mini_yaml_test_shared";
+    Yaml::RemoveShared(name.c_str());
+
+    Yaml::MappedDocument reader;
+    EXPECT_EQ(Yaml::SharedGeneration(name.c_str()), 0);
+    EXPECT_THROW(Yaml::AttachShared(reader, name.c_str()), Yaml::OperationException);
+
+    Yaml::Node root;
+    root["version"] = 1;
+    root["name"] = "first";
+    for(int i = 0; i < 10; i++)
+    {
+        root["items"].PushBack() = i;
+    }
+    ASSERT_NO_THROW(Yaml::PublishShared(root, name.c_str()));
+    EXPECT_EQ(Yaml::SharedGeneration(name.c_str()), 1);
+#if defined(__linux__)
+    struct stat status;
+    ASSERT_EQ(stat(("/dev/shm" + name).c_str(), &status), 0);
+    EXPECT_EQ(status.st_mode & 0777, 0600);
+    ASSERT_EQ(stat(("/dev/shm" + name + ".1").c_str(), &status), 0);
+    EXPECT_EQ(status.st_mode & 0777, 0600);
+#endif
+
+    ASSERT_NO_THROW(Yaml::AttachShared(reader, name.c_str()));
+    EXPECT_EQ(reader.Generation(), 1);
+    EXPECT_EQ(reader.Root()["version"].As<int>(), 1);
+    EXPECT_EQ(reader.Root()["items"][9].As<int>(), 9);
+
+    // Readers of the old generation are unaffected by publishing a new one.
+    root["version"] = 2;
+    root["name"] = "second";
+    ASSERT_NO_THROW(Yaml::PublishShared(root, name.c_str()));
+    EXPECT_EQ(Yaml::SharedGeneration(name.c_str()), 2);
+    EXPECT_EQ(reader.Root()["version"].As<int>(), 1);
+    EXPECT_EQ(reader.Root()["name"].As<std::string>(), "first");
+
+    Yaml::MappedDocument current;
+    ASSERT_NO_THROW(Yaml::AttachShared(current, name.c_str()));
+    EXPECT_EQ(current.Generation(), 2);
+    EXPECT_EQ(current.Root()["name"].As<std::string>(), "second");
+
+    EXPECT_NE(reader.Generation(), Yaml::SharedGeneration(name.c_str()));
+    ASSERT_NO_THROW(Yaml::AttachShared(reader, name.c_str()));
+    EXPECT_EQ(reader.Root()["version"].As<int>(), 2);
+
+    // Concurrent publishers never break the current generation.
+    std::vector<std::thread> publishers;
+    for(int i = 0; i < 4; i++)
+    {
+        publishers.push_back(std::thread([&root, &name]()
+        {
+            for(int j = 0; j < 20; j++)
+            {
+                Yaml::PublishShared(root, name.c_str());
+            }
+        }));
+    }
+    for(auto & publisher : publishers)
+    {
+        publisher.join();
+    }
+    EXPECT_EQ(Yaml::SharedGeneration(name.c_str()), 82);
+    ASSERT_NO_THROW(Yaml::AttachShared(reader, name.c_str()));
+    EXPECT_EQ(reader.Generation(), 82);
+    EXPECT_EQ(reader.Root()["name"].As<std::string>(), "second");
+
+    Yaml::RemoveShared(name.c_str());
+    EXPECT_EQ(Yaml::SharedGeneration(name.c_str()), 0);
+    EXPECT_EQ(current.Root()["items"][3].As<int>(), 3);
+    reader.Close();
+    EXPECT_EQ(reader.Generation(), 0);
+}
+
+TEST(Parse, DocumentCache)
+{
+    const char * filename = "test_document_cache.yaml";
+    const char * otherFilename = "test_document_cache_other.yaml";
+    auto writeFile = [](const char * name, const std::string & data)
+    {
+        std::ofstream file(name, std::ios::binary | std::ios::trunc);
+        file.write(data.c_str(), data.size());
+    };
+    writeFile(filename, "key: first\nlist:\n  - 1\n  - 2\n");
+    writeFile(otherFilename, "other: value\n");
+
+    Yaml::DocumentCache cache;
+    std::shared_ptr<const Yaml::Document> first = cache.Get(filename);
+    ASSERT_TRUE(first != nullptr);
+    EXPECT_EQ(first->Root().Find("key")->As<std::string>(), "first");
+    EXPECT_EQ(cache.Get(filename), first);
+    EXPECT_EQ(cache.Parses(), 1);
+    EXPECT_EQ(cache.Hits(), 1);
+    EXPECT_EQ(cache.Size(), 1);
+    EXPECT_GT(cache.MemoryUsage(), 0);
+
+    // Rewriting the same content is detected by content hash.
+    writeFile(filename, "key: first\nlist:\n  - 1\n  - 2\n");
+    EXPECT_EQ(cache.Get(filename), first);
+    EXPECT_EQ(cache.Parses(), 1);
+
+    writeFile(filename, "key: second, changed\n");
+    std::shared_ptr<const Yaml::Document> second = cache.Get(filename);
+    EXPECT_NE(second, first);
+    EXPECT_EQ(second->Root().Find("key")->As<std::string>(), "second, changed");
+    EXPECT_EQ(first->Root().Find("key")->As<std::string>(), "first");
+    EXPECT_EQ(cache.Parses(), 2);
+
+    // Concurrent misses parse once.
+    cache.Get(otherFilename);
+    cache.Clear();
+    EXPECT_EQ(cache.Size(), 0);
+    EXPECT_EQ(cache.MemoryUsage(), 0);
+    const size_t parses = cache.Parses();
+    std::vector<std::thread> threads;
+    std::vector<std::shared_ptr<const Yaml::Document> > results(8);
+    for(size_t i = 0; i < results.size(); i++)
+    {
+        threads.push_back(std::thread([&cache, &results, filename, i]()
+        {
+            results[i] = cache.Get(filename);
+        }));
+    }
+    for(auto & thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(cache.Parses(), parses + 1);
+    for(size_t i = 1; i < results.size(); i++)
+    {
+        EXPECT_EQ(results[i], results[0]);
+    }
+
+    // Least recently used documents are evicted.
+    const size_t memory = cache.MemoryUsage();
+    Yaml::DocumentCache smallCache(memory + 64);
+    smallCache.Get(filename);
+    smallCache.Get(otherFilename);
+    EXPECT_EQ(smallCache.Size(), 1);
+    smallCache.Get(otherFilename);
+    EXPECT_EQ(smallCache.Hits(), 1);
+    smallCache.Erase(otherFilename);
+    EXPECT_EQ(smallCache.Size(), 0);
+
+    // Nodes shared by aliases are counted once.
+    writeFile(filename, AliasBomb(9));
+    Yaml::DocumentCache aliasCache(1048576);
+    std::shared_ptr<const Yaml::Document> aliased = aliasCache.Get(filename);
+    EXPECT_EQ(aliased->Root().Find("l8")->Size(), 10);
+    EXPECT_EQ(aliasCache.Size(), 1);
+    EXPECT_LT(aliasCache.MemoryUsage(), 65536);
+
+    writeFile(filename, "key: [unterminated\n");
+    EXPECT_THROW(cache.Get(filename), Yaml::ParsingException);
+    EXPECT_EQ(cache.Size(), 0);
+    std::remove(filename);
+    std::remove(otherFilename);
+    EXPECT_THROW(cache.Get(filename), Yaml::OperationException);
+    EXPECT_THROW(cache.Get("."), Yaml::OperationException);
+}
+
+TEST(Encode, Encode)
+{
+    BindTest::Config config;
+    config.name = "service: main";
+    config.rate = 0.1;
+    config.enabled = true;
+    config.primary.host = "example.com";
+    config.replicas.resize(2);
+    config.replicas[0].host = "a.example.com";
+    config.replicas[1].host = "b.example.com";
+    config.replicas[1].port = 81;
+    config.weights.push_back(0.5f);
+    config.weights.push_back(2.0f);
+    config.flags.push_back(true);
+    config.flags.push_back(false);
+    config.limits["read"] = 10;
+    config.limits["write"] = -20;
+
+    std::string output;
+    Yaml::StringSink sink(output);
+    EXPECT_NO_THROW(Yaml::Encode(config, sink));
+    EXPECT_EQ(output,
+        "name: \"service: main\"\n"
+        "rate: 0.1\n"
+        "enabled: true\n"
+        "primary: \n"
+        "  host: example.com\n"
+        "  port: 80\n"
+        "replicas: \n"
+        "  - host: a.example.com\n"
+        "    port: 80\n"
+        "  - host: b.example.com\n"
+        "    port: 81\n"
+        "weights: \n"
+        "  - 0.5\n"
+        "  - 2.0\n"
+        "flags: \n"
+        "  - true\n"
+        "  - false\n"
+        "limits: \n"
+        "  read: 10\n"
+        "  write: -20\n"
+        "untouched: 42\n");
+
+    BindTest::Config decoded;
+    EXPECT_NO_THROW(Yaml::Decode(output, decoded));
+    EXPECT_EQ(decoded.name, config.name);
+    EXPECT_EQ(decoded.rate, config.rate);
+    EXPECT_EQ(decoded.replicas[1].port, 81);
+    EXPECT_EQ(decoded.limits["write"], -20);
+
+    // Equal output as Serialize of node tree.
+    Yaml::Node root;
+    root["list"].PushBack() = "a";
+    root["list"].PushBack()["key"] = "multi\nline\n";
+    root["text"] = "plain";
+    std::string serialized;
+    Yaml::Serialize(root, serialized);
+
+    std::map<std::string, std::vector<std::map<std::string, std::string> > > nested;
+    std::map<std::string, std::string> item;
+    item["key"] = "multi\nline\n";
+    nested["list"].push_back(item);
+    std::string encoded;
+    Yaml::StringSink encodedSink(encoded);
+    Yaml::Encode(nested, encodedSink);
+    EXPECT_NE(serialized.find(encoded.substr(encoded.find("  - "))), std::string::npos);
+
+    std::unordered_map<std::string, std::shared_ptr<int> > pointers;
+    pointers["set"] = std::make_shared<int>(5);
+    pointers["empty"] = nullptr;
+    std::string pointerOutput;
+    Yaml::StringSink pointerSink(pointerOutput);
+    Yaml::Encode(pointers, pointerSink);
+    EXPECT_EQ(pointerOutput, "set: 5\n");
+
+    std::stringstream stream;
+    Yaml::StreamSink streamSink(stream);
+    Yaml::Encode(std::vector<double>{1e300, -2.5e-7, 100.0}, streamSink);
+    EXPECT_EQ(stream.str(), "- 1e+300\n- -2.5e-07\n- 100.0\n");
+
+    EXPECT_THROW(Yaml::Encode(config, sink, Yaml::SerializeConfig(1)), Yaml::OperationException);
+}
+
+TEST(Parallel, ForEach)
+{
+    Yaml::Node root;
+    for(size_t i = 0; i < 10000; i++)
+    {
+        root["list"].PushBack() = static_cast<int>(i);
+    }
+    root["map"]["a"] = 1;
+    root["map"]["b"] = 2;
+    root["map"]["c"] = 3;
+
+    std::atomic<int64_t> sum(0);
+    std::vector<char> visited(10000, 0);
+    Yaml::ParallelForEach(root["list"], [&](const size_t index, const std::string & key, const Yaml::Node & element)
+    {
+        EXPECT_TRUE(key.empty());
+        sum += element.As<int>();
+        visited[index] = 1;
+    }, Yaml::ParallelConfig(4, 64));
+    EXPECT_EQ(sum.load(), 49995000);
+    EXPECT_EQ(std::count(visited.begin(), visited.end(), 1), 10000);
+
+    std::atomic<int> mapSum(0);
+    Yaml::ParallelForEach(root["map"], [&](const size_t, const std::string & key, const Yaml::Node & element)
+    {
+        mapSum += element.As<int>() * (key == "c" ? 100 : 1);
+    });
+    EXPECT_EQ(mapSum.load(), 303);
+
+    Yaml::Node output;
+    Yaml::Transform(root["list"], output, [](const size_t, const std::string &, const Yaml::Node & element, Yaml::Node & result)
+    {
+        result = element.As<int>() * 2;
+    }, Yaml::ParallelConfig(3));
+    ASSERT_EQ(output.Size(), 10000);
+    EXPECT_EQ(output[1234].As<int>(), 2468);
+
+    EXPECT_THROW(Yaml::ParallelForEach(root["list"], [](const size_t index, const std::string &, const Yaml::Node &)
+    {
+        if(index == 5000)
+        {
+            throw std::runtime_error("failed");
+        }
+    }, Yaml::ParallelConfig(4)), std::runtime_error);
+}
+
+TEST(Path, Evaluate)
+{
+    Yaml::Node root;
+    Yaml::Parse(root, std::string(
+        "clusters:\n"
+        "  - name: east\n"
+        "    nodes:\n"
+        "      - {role: db, addr: 10.0.0.1}\n"
+        "      - {role: web, addr: 10.0.0.2}\n"
+        "  - name: west\n"
+        "    nodes:\n"
+        "      - {role: db, addr: 10.0.1.1}\n"
+        "      - {role: cache}\n"
+        "\"odd.key\": value\n"));
+    const Yaml::Node & constRoot = root;
+
+    Yaml::Path path = Yaml::Path::Compile("clusters[*].nodes[?role==db].addr");
+    EXPECT_EQ(path.Size(), size_t(5));
+    std::vector<const Yaml::Node *> result = path.Evaluate(constRoot);
+    ASSERT_EQ(result.size(), size_t(2));
+    EXPECT_EQ(result[0]->As<std::string>(), "10.0.0.1");
+    EXPECT_EQ(result[1]->As<std::string>(), "10.0.1.1");
+
+    std::vector<const Yaml::Node *> parallel = path.Evaluate(constRoot, Yaml::ParallelConfig(4, 1));
+    EXPECT_TRUE(parallel == result);
+
+    result = Yaml::Path::Compile("clusters[1].name").Evaluate(constRoot);
+    ASSERT_EQ(result.size(), size_t(1));
+    EXPECT_EQ(result[0]->As<std::string>(), "west");
+
+    result = Yaml::Path::Compile("clusters.*.nodes[?role!=db].role").Evaluate(constRoot);
+    ASSERT_EQ(result.size(), size_t(2));
+    EXPECT_EQ(result[0]->As<std::string>(), "web");
+    EXPECT_EQ(result[1]->As<std::string>(), "cache");
+
+    EXPECT_EQ(Yaml::Path::Compile("clusters[*].nodes[?addr]").Evaluate(constRoot).size(), size_t(3));
+    EXPECT_EQ(Yaml::Path::Compile("[\"odd.key\"]").Evaluate(constRoot).size(), size_t(1));
+
+    Yaml::Node quoted;
+    quoted["a]b"] = "bracket";
+    quoted["tags"].PushBack()["tag"] = "x]y";
+    quoted["tags"].PushBack()["tag"] = "z";
+    const Yaml::Node & constQuoted = quoted;
+    result = Yaml::Path::Compile("[\"a]b\"]").Evaluate(constQuoted);
+    ASSERT_EQ(result.size(), size_t(1));
+    EXPECT_EQ(result[0]->As<std::string>(), "bracket");
+    EXPECT_EQ(Yaml::Path::Compile("['a]b']").Evaluate(constQuoted).size(), size_t(1));
+    result = Yaml::Path::Compile("tags[?tag==\"x]y\"].tag").Evaluate(constQuoted);
+    ASSERT_EQ(result.size(), size_t(1));
+    EXPECT_EQ(result[0]->As<std::string>(), "x]y");
+    EXPECT_THROW(Yaml::Path::Compile("[\"a]b]"), Yaml::OperationException);
+    EXPECT_EQ(Yaml::Path::Compile("clusters[5].name").Evaluate(constRoot).size(), size_t(0));
+    EXPECT_EQ(Yaml::Path::Compile("missing[*]").Evaluate(constRoot, Yaml::ParallelConfig()).size(), size_t(0));
+    result = Yaml::Path::Compile("").Evaluate(constRoot);
+    ASSERT_EQ(result.size(), size_t(1));
+    EXPECT_EQ(result[0], &constRoot);
+
+    // Evaluation never adds keys.
+    EXPECT_EQ(constRoot.Size(), size_t(2));
+    EXPECT_EQ(constRoot.Find("missing"), nullptr);
+    EXPECT_EQ(constRoot.Find(size_t(0)), nullptr);
+
+    EXPECT_THROW(Yaml::Path::Compile("a..b"), Yaml::OperationException);
+    EXPECT_THROW(Yaml::Path::Compile(".a"), Yaml::OperationException);
+    EXPECT_THROW(Yaml::Path::Compile("a."), Yaml::OperationException);
+    EXPECT_THROW(Yaml::Path::Compile("a[1"), Yaml::OperationException);
+    EXPECT_THROW(Yaml::Path::Compile("a[x]"), Yaml::OperationException);
+    EXPECT_THROW(Yaml::Path::Compile("a[?]"), Yaml::OperationException);
+}
+
+TEST(Index, BuildIndex)
+{
+    Yaml::Node root;
+    Yaml::Parse(root, std::string(
+        "- {id: 1, name: alpha, zone: a, tags: [x, y]}\n"
+        "- {id: 2, name: beta, zone: b, tags: [y, y]}\n"
+        "- {id: 3, name: alpha, zone: b}\n"
+        "- {name: gamma}\n"
+        "- scalar\n"));
+
+    Yaml::Index index = Yaml::BuildIndex(root, "id", Yaml::ParallelConfig(4, 1));
+    EXPECT_TRUE(index.IsValid());
+    EXPECT_EQ(index.Size(), size_t(3));
+    ASSERT_NE(index.Find("2"), nullptr);
+    EXPECT_EQ(index.Find("2")->Find("name")->As<std::string>(), "beta");
+    EXPECT_EQ(index.Find("4"), nullptr);
+
+    Yaml::Index names = Yaml::BuildIndex(root, "name");
+    std::vector<const Yaml::Node *> result = names.FindAll("alpha");
+    ASSERT_EQ(result.size(), size_t(2));
+    EXPECT_EQ(result[0], &root[0]);
+    EXPECT_EQ(result[1], &root[2]);
+
+    Yaml::Index tags = Yaml::BuildIndex(root, "tags");
+    EXPECT_EQ(tags.FindAll("x").size(), size_t(1));
+    result = tags.FindAll("y");
+    ASSERT_EQ(result.size(), size_t(2));
+    EXPECT_EQ(result[1], &root[1]);
+
+    Yaml::Index compound = Yaml::BuildIndex(root, std::vector<std::string>{"name", "zone"});
+    EXPECT_EQ(compound.Find(std::vector<std::string>{"alpha", "b"}), &root[2]);
+    EXPECT_EQ(compound.Find(std::vector<std::string>{"alpha", "c"}), nullptr);
+    EXPECT_THROW(compound.Find("alpha"), Yaml::OperationException);
+    EXPECT_THROW(compound.Find(std::vector<std::string>{"alpha"}), Yaml::OperationException);
+
+    // Mutating the sequence makes the index outdated until rebuilt.
+    root.PushBack()["id"] = "4";
+    EXPECT_FALSE(index.IsValid());
+    EXPECT_THROW(index.Find("4"), Yaml::OperationException);
+    index.Rebuild();
+    EXPECT_TRUE(index.IsValid());
+    EXPECT_EQ(index.Find("4"), &root[5]);
+
+    root.Erase(0);
+    EXPECT_FALSE(index.IsValid());
+    index.Rebuild();
+    EXPECT_EQ(index.Find("1"), nullptr);
+    EXPECT_EQ(index.Find("2"), &root[0]);
+
+    EXPECT_THROW(Yaml::BuildIndex(root, std::vector<std::string>()), Yaml::OperationException);
+}
+
 TEST(Iterator, Iterator)
 {
     Yaml::Node root;
@@ -727,6 +2708,72 @@ TEST(Iterator, ConstIterator)
     EXPECT_TRUE(flags[2]);
 }
 
+TEST(Iterator, RangeFor)
+{
+    Yaml::Node root;
+    Yaml::Parse(root, std::string("list: [1, 2, 3, 4, 5]\nmap: {a: 1, b: 2, c: 3}\nscalar: x\n"));
+
+    int sum = 0;
+    for(auto item : root["list"])
+    {
+        sum += item.second.As<int>();
+    }
+    EXPECT_EQ(sum, 15);
+
+    std::string keys;
+    const Yaml::Node & constMap = root["map"];
+    for(auto item : constMap)
+    {
+        keys += item.first;
+    }
+    EXPECT_EQ(keys, "abc");
+
+    size_t loops = 0;
+    for(auto item : root["scalar"])
+    {
+        (void)item;
+        loops++;
+    }
+    EXPECT_EQ(loops, 0);
+
+    // Random access of sequence.
+    Yaml::Node & list = root["list"];
+    Yaml::Iterator it = list.begin();
+    EXPECT_EQ((*(it + 2)).second.As<int>(), 3);
+    EXPECT_EQ(it[4].second.As<int>(), 5);
+    EXPECT_EQ(list.end() - list.begin(), 5);
+    it += 3;
+    EXPECT_EQ((*it).second.As<int>(), 4);
+    EXPECT_EQ((*--it).second.As<int>(), 3);
+    EXPECT_EQ((*it++).second.As<int>(), 3);
+    EXPECT_EQ((*it).second.As<int>(), 4);
+    EXPECT_TRUE(list.begin() < it);
+    EXPECT_TRUE(it <= list.end());
+
+    Yaml::ConstIterator constIt = it;
+    EXPECT_EQ((*constIt).second.As<int>(), 4);
+    EXPECT_EQ(std::distance(constMap.begin(), constMap.end()), 3);
+    EXPECT_EQ((*(constMap.begin() + 1)).first, "b");
+    static_assert(std::is_same<std::iterator_traits<Yaml::ConstIterator>::iterator_category,
+                               std::random_access_iterator_tag>::value, "Random access iterator expected.");
+    Yaml::ConstIterator constEnd = list.end();
+    std::advance(constEnd, -5);
+    EXPECT_EQ((*constEnd).second.As<int>(), 1);
+    EXPECT_TRUE((*Yaml::ConstIterator()).second.IsNone());
+    EXPECT_TRUE((*Yaml::Iterator()).second.IsNone());
+
+    // Insert, push front and erase of sequence.
+    list.Insert(1) = "inserted";
+    list.PushFront() = "front";
+    EXPECT_EQ(list[0].As<std::string>(), "front");
+    EXPECT_EQ(list[2].As<std::string>(), "inserted");
+    EXPECT_EQ(list.Size(), 7);
+    list.Erase(0);
+    EXPECT_EQ(list[1].As<std::string>(), "inserted");
+    list.Insert(100) = "back";
+    EXPECT_EQ(list[6].As<std::string>(), "back");
+}
+
 TEST(Serialize, Serialize)
 {
     Yaml::Node root;
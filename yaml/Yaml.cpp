@@ -29,22 +29,56 @@
 #include <sstream>
 #include <vector>
 #include <list>
+#include <unordered_map>
+#include <unordered_set>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <iterator>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <system_error>
 #include <stdarg.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define YAML_SSE2
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+#include <fcntl.h>
+#include <sys/stat.h>
+#if defined(_WIN32)
+    #include <io.h>
+    #include <process.h>
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <windows.h>
+#else
+    #include <unistd.h>
+    #include <sys/mman.h>
+#endif
+
 
 // Implementation access definitions.
 #define NODE_IMP static_cast<NodeImp*>(m_pImp)
-#define NODE_IMP_EXT(node) static_cast<NodeImp*>(node.m_pImp)
+#define NODE_IMP_EXT(node) NodeImp::Get(node)
 #define TYPE_IMP static_cast<NodeImp*>(m_pImp)->m_pImp
 
 
-#define IT_IMP static_cast<IteratorImp*>(m_pImp)
-
-
 namespace Yaml
 {
     class ReaderLine;
+    class TypeImp;
 
     // Exception message definitions.
     static const std::string g_ErrorInvalidCharacter        = "Invalid character found.";
@@ -61,8 +95,31 @@ namespace Yaml
     static const std::string g_ErrorIndentation             = "Space indentation is less than 2.";
     static const std::string g_ErrorInvalidBlockScalar      = "Invalid block scalar.";
     static const std::string g_ErrorInvalidQuote            = "Invalid quote.";
+    static const std::string g_ErrorInvalidAnchor           = "Invalid anchor.";
+    static const std::string g_ErrorUnknownAlias            = "Unknown alias.";
+    static const std::string g_ErrorInvalidFlowCollection   = "Invalid flow collection.";
+    static const std::string g_ErrorFlowDepth               = "Flow collection is nested too deep.";
+    static const std::string g_ErrorInvalidTaggedValue      = "Invalid value of tagged scalar.";
+    static const std::string g_ErrorInvalidPath             = "Invalid path.";
+    static const std::string g_ErrorIndexOutdated           = "Index is outdated.";
+    static const std::string g_ErrorIndexKey                = "Incorrect number of index key values.";
+    static const std::string g_ErrorWriteFile               = "Cannot write to file.";
+    static const std::string g_ErrorEmitterState            = "Invalid emitter state.";
+    static const std::string g_ErrorInvalidBinary           = "Invalid binary data.";
+    static const std::string g_ErrorInvalidMapped           = "Invalid mapped document.";
+    static const std::string g_ErrorViewIndex               = "View is not a map or index is out of range.";
+    static const std::string g_ErrorMapFile                 = "Cannot map file.";
+    static const std::string g_ErrorSharedMemory            = "Cannot create or map shared memory.";
+    static const std::string g_ErrorNotPublished            = "No document is published.";
     static const std::string g_EmptyString                  = "";
-    static Yaml::Node        g_NoneNode;
+
+    // Nodes of missing items. Mutable accessors return a node per thread, cleared on each use.
+    static thread_local Yaml::Node  g_NoneNode;
+    static const Yaml::Node         g_ConstNoneNode;
+
+    // Nesting limits, avoiding stack overflow on malicious input.
+    static const size_t      g_MaxFlowDepth                 = 512;
+    static const size_t      g_MaxBinaryDepth               = 1024;
 
     // Global function definitions. Implemented at end of this source file.
     static std::string ExceptionMessage(const std::string & message, ReaderLine & line);
@@ -70,14 +127,51 @@ namespace Yaml
     static std::string ExceptionMessage(const std::string & message, const size_t errorLine, const size_t errorPos);
     static std::string ExceptionMessage(const std::string & message, const size_t errorLine, const std::string & data);
 
+    static void ScanCharacters(const char * data, size_t pos, const size_t size, std::vector<size_t> & lineEnds, std::vector<size_t> & invalidPositions);
+    static size_t Utf8SequenceLength(const unsigned char * data, const size_t size);
+    static bool ParseScalarValue(const std::string & data, impl::ScalarValue & value);
+    static bool ParseTaggedScalarValue(const std::string & data, const std::string & tag, impl::ScalarValue & value);
+    static bool ParseIntegerValue(const std::string & data, int64_t & value);
+    static bool ParseFloatValue(const std::string & data, double & value);
     static bool FindQuote(const std::string & input, size_t & start, size_t & end, size_t searchPos = 0);
     static size_t FindNotCited(const std::string & input, char token, size_t & preQuoteCount);
     static size_t FindNotCited(const std::string & input, char token);
     static bool ValidateQuote(const std::string & input);
     static void CopyNode(const Node & from, Node & to);
     static bool ShouldBeCited(const std::string & key);
+    static bool ResolvesToTypedValue(const char * data, const size_t size);
+    static bool IsCitedScalar(const Node & node);
     static void AddEscapeTokens(std::string & input, const std::string & tokens);
     static void RemoveAllEscapeTokens(std::string & input);
+    static size_t FindPathBracketEnd(const std::string & path, const size_t pos);
+    static uint64_t SequenceVersion(const Node & node);
+    static void CollectIndexKeys(const Node & element, const std::vector<std::string> & fields, const size_t field,
+                                 const std::string & prefix, std::vector<std::string> & keys);
+    static void AppendIndexKeyPart(std::string & key, const std::string & part);
+    static void SerializeFlow(const Node & node, Sink & sink, const SerializeConfig & config);
+    static bool IsFlowSequence(const Node & node, const SerializeConfig & config);
+    static bool IsJsonNumber(const char * data, const size_t size);
+    static bool ShouldBeFlowQuoted(const char * data, const size_t size);
+    static void EncodeQuoted(Sink & sink, const char * data, const size_t size, const bool json);
+    static int OpenOutputFile(const char * filename, const bool exclusive);
+    static bool CloseFile(const int fd);
+    static bool TruncateFile(const int fd, const bool onlyIfWritten);
+    static void WriteFileData(const Node & root, const int fd, const SerializeConfig & config, const FileConfig & fileConfig, const bool sync);
+    static void WriteFileAtomic(const Node & root, const char * filename, const SerializeConfig & config, const FileConfig & fileConfig);
+    static void WriteVarint(Sink & sink, uint64_t value);
+    static void CollectBinaryKeys(const Node & node, std::unordered_map<std::string, size_t> & keyMap,
+                                  std::vector<const std::string *> & keys, std::vector<size_t> & keyRefs,
+                                  std::unordered_set<const TypeImp *> & shared);
+    static void SaveBinaryNode(const Node & node, Sink & sink, const std::vector<size_t> & keyRefs, size_t & keyRef,
+                               std::unordered_map<const TypeImp *, size_t> & anchors);
+    static uint64_t MappedHash(const char * data, const size_t size);
+    static void * MapFile(const char * filename, size_t & size);
+    static void UnmapFile(void * pMapping, const size_t size);
+    static std::string SharedSegmentName(const char * name, const uint64_t generation);
+    static void * MapSharedControl(const char * name, const bool create, const unsigned int mode);
+    static uint64_t ContentHash(const char * data, const size_t size);
+    static size_t EstimateMemory(const Node & node);
+    static size_t EstimateMemory(const Node & node, std::unordered_set<const TypeImp *> & shared);
 
     // Exception implementations
     Exception::Exception(const std::string & message, const eType type) :
@@ -120,6 +214,11 @@ namespace Yaml
 
     public:
 
+        TypeImp() :
+            m_RefCount(1)
+        {
+        }
+
         virtual ~TypeImp()
         {
         }
@@ -135,6 +234,8 @@ namespace Yaml
         virtual void Erase(const size_t index) = 0;
         virtual void Erase(const std::string & key) = 0;
 
+        size_t m_RefCount;  ///< Number of nodes sharing this imp, more than 1 if referenced by aliases.
+
     };
 
     class SequenceImp : public TypeImp
@@ -142,11 +243,16 @@ namespace Yaml
 
     public:
 
+        SequenceImp() :
+            m_Version(FirstVersion())
+        {
+        }
+
         ~SequenceImp()
         {
             for(auto it = m_Sequence.begin(); it != m_Sequence.end(); it++)
             {
-                delete it->second;
+                delete *it;
             }
         }
 
@@ -167,10 +273,9 @@ namespace Yaml
 
         virtual Node * GetNode(const size_t index)
         {
-            auto it = m_Sequence.find(index);
-            if(it != m_Sequence.end())
+            if(index < m_Sequence.size())
             {
-                return it->second;
+                return m_Sequence[index];
             }
             return nullptr;
         }
@@ -182,81 +287,58 @@ namespace Yaml
 
         virtual Node * Insert(const size_t index)
         {
-            if(m_Sequence.size() == 0)
-            {
-                Node * pNode = new Node;
-                m_Sequence.insert({0, pNode});
-                return pNode;
-            }
-
-            if(index >= m_Sequence.size())
-            {
-                auto it = m_Sequence.end();
-                --it;
-                Node * pNode = new Node;
-                m_Sequence.insert({it->first, pNode});
-                return pNode;
-            }
-
-            auto it = m_Sequence.cbegin();
-            while(it != m_Sequence.cend())
-            {
-                m_Sequence[it->first+1] = it->second;
-
-                if(it->first == index)
-                {
-                    break;
-                }
-            }
-
+            const size_t position = index < m_Sequence.size() ? index : m_Sequence.size();
             Node * pNode = new Node;
-            m_Sequence.insert({index, pNode});
+            m_Sequence.insert(m_Sequence.begin() + position, pNode);
+            ++m_Version;
             return pNode;
         }
 
         virtual Node * PushFront()
         {
-            for(auto it = m_Sequence.cbegin(); it != m_Sequence.cend(); it++)
-            {
-                m_Sequence[it->first+1] = it->second;
-            }
-
             Node * pNode = new Node;
-            m_Sequence.insert({0, pNode});
+            m_Sequence.insert(m_Sequence.begin(), pNode);
+            ++m_Version;
             return pNode;
         }
 
         virtual Node * PushBack()
         {
-            size_t index = 0;
-            if(m_Sequence.size())
-            {
-                auto it = m_Sequence.end();
-                --it;
-                index = it->first + 1;
-            }
-
             Node * pNode = new Node;
-            m_Sequence.insert({index, pNode});
+            m_Sequence.push_back(pNode);
+            ++m_Version;
             return pNode;
         }
 
         virtual void Erase(const size_t index)
         {
-            auto it = m_Sequence.find(index);
-            if(it == m_Sequence.end())
+            if(index >= m_Sequence.size())
             {
                 return;
             }
-            delete it->second;
-            m_Sequence.erase(index);
+            delete m_Sequence[index];
+            m_Sequence.erase(m_Sequence.begin() + index);
+            ++m_Version;
         }
 
         virtual void Erase(const std::string & key)
         {
         }
 
-        std::map<size_t, Node*> m_Sequence;
+        /**
+        * @breif Get first version of new sequence, never equal to 0 as of nodes not being sequences.
+        *        The upper 32 bits are unique among sequences, the lower 32 bits count modifications.
+        *        Only constructing a sequence touches the shared counter, modifying it does not.
+        *
+        */
+        static uint64_t FirstVersion()
+        {
+            static std::atomic<uint32_t> sequences(0);
+            return (static_cast<uint64_t>(++sequences) << 32) | 1;
+        }
+
+        std::vector<Node*> m_Sequence;
+        uint64_t           m_Version;   ///< Incremented by every insertion or removal of elements.
 
     };
 
@@ -344,6 +426,26 @@ namespace Yaml
 
     public:
 
+        /**
+        * @breif Bits of conversion cache tag, the generation is kept in the upper 32 bits.
+        *
+        */
+        enum eCacheTag
+        {
+            CacheKindMask       = 0x07,
+            CacheResultShift    = 3,
+            CacheResultMask     = 0x03,
+            CacheNegative       = 0x20,
+            CacheBusy           = 0x40
+        };
+
+        ScalarImp() :
+            m_Quoted(false),
+            m_CacheTag(0),
+            m_CacheValue(0)
+        {
+        }
+
         ~ScalarImp()
         {
         }
@@ -356,9 +458,74 @@ namespace Yaml
         virtual bool SetData(const std::string & data)
         {
             m_Value = data;
+            Reset();
             return true;
         }
 
+        /**
+        * @breif Reset natively typed value and conversion cache, required after modifying m_Value.
+        *
+        */
+        void Reset()
+        {
+            m_Native = impl::ScalarValue();
+            m_Quoted = false;
+            m_CacheTag.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+        * @breif Get string value parsed as requested kind of number.
+        *        The cache holds the last parsed number and is read as a sequence lock,
+        *        validated by rereading the tag. Writers racing for the cache skip caching instead of waiting.
+        *
+        */
+        impl::ScalarNumber GetNumber(const impl::ScalarNumber::eKind kind)
+        {
+            impl::ScalarNumber number;
+            const uint64_t tag = m_CacheTag.load(std::memory_order_acquire);
+            if((tag & CacheBusy) == 0 && MatchesKind(static_cast<impl::ScalarNumber::eKind>(tag & CacheKindMask), kind))
+            {
+                const uint64_t value = m_CacheValue.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(m_CacheTag.load(std::memory_order_relaxed) == tag)
+                {
+                    number.Kind = static_cast<impl::ScalarNumber::eKind>(tag & CacheKindMask);
+                    number.Result = static_cast<impl::eNumberResult>((tag >> CacheResultShift) & CacheResultMask);
+                    number.Negative = (tag & CacheNegative) != 0;
+                    number.Magnitude = value;
+                    std::memcpy(&number.Float, &value, sizeof(number.Float));
+                    number.Boolean = value != 0;
+                    return number;
+                }
+            }
+
+            impl::ParseScalarNumber(m_Value.c_str(), m_Value.c_str() + m_Value.size(), kind, number);
+
+            uint64_t current = tag;
+            if((current & CacheBusy) == 0 &&
+               m_CacheTag.compare_exchange_strong(current, current | CacheBusy, std::memory_order_relaxed))
+            {
+                uint64_t value = number.Magnitude;
+                if(number.Kind == impl::ScalarNumber::FloatKind || number.Kind == impl::ScalarNumber::FallbackKind)
+                {
+                    std::memcpy(&value, &number.Float, sizeof(value));
+                }
+                else if(number.Kind == impl::ScalarNumber::BooleanKind)
+                {
+                    value = number.Boolean ? 1 : 0;
+                }
+
+                const uint64_t generation = ((current >> 32) + 1) << 32;
+                std::atomic_thread_fence(std::memory_order_release);
+                m_CacheValue.store(value, std::memory_order_relaxed);
+                m_CacheTag.store(generation | static_cast<uint64_t>(number.Kind) |
+                                 (static_cast<uint64_t>(number.Result) << CacheResultShift) |
+                                 (number.Negative ? CacheNegative : 0), std::memory_order_release);
+            }
+
+            return number;
+        }
+
         virtual size_t GetSize() const
         {
             return 0;
@@ -397,7 +564,31 @@ namespace Yaml
         {
         }
 
-        std::string m_Value;
+        /**
+        * @breif Check if parsed kind of cache can be used for requested kind.
+        *
+        */
+        static bool MatchesKind(const impl::ScalarNumber::eKind cached, const impl::ScalarNumber::eKind kind)
+        {
+            switch(kind)
+            {
+            case impl::ScalarNumber::IntegerKind:
+                return cached == impl::ScalarNumber::IntegerKind || cached == impl::ScalarNumber::FallbackKind;
+            case impl::ScalarNumber::FloatKind:
+                return cached == impl::ScalarNumber::FloatKind || cached == impl::ScalarNumber::FallbackKind;
+            case impl::ScalarNumber::BooleanKind:
+                return cached == impl::ScalarNumber::BooleanKind;
+            default:
+                break;
+            }
+            return false;
+        }
+
+        std::string             m_Value;        ///< String value, kept for typed scalars as well.
+        impl::ScalarValue       m_Native;       ///< Natively typed value, NoneType if string scalar.
+        bool                    m_Quoted;       ///< String scalar quoted or tagged "!!str" in parsed input data.
+        std::atomic<uint64_t>   m_CacheTag;     ///< Kind, result and generation of cached number, see eCacheTag. 0 if empty.
+        std::atomic<uint64_t>   m_CacheValue;   ///< Cached magnitude, floating point bits or boolean.
 
     };
 
@@ -410,6 +601,7 @@ namespace Yaml
 
         NodeImp() :
             m_Type(Node::None),
+            m_LocationId(0),
             m_pImp(nullptr)
         {
         }
@@ -421,11 +613,7 @@ namespace Yaml
 
         void Clear()
         {
-            if(m_pImp != nullptr)
-            {
-                delete m_pImp;
-                m_pImp = nullptr;
-            }
+            Release();
             m_Type = Node::None;
         }
 
@@ -433,10 +621,7 @@ namespace Yaml
         {
             if(m_Type != Node::SequenceType || m_pImp == nullptr)
             {
-                if(m_pImp)
-                {
-                    delete m_pImp;
-                }
+                Release();
                 m_pImp = new SequenceImp;
                 m_Type = Node::SequenceType;
             }
@@ -446,10 +631,7 @@ namespace Yaml
         {
             if(m_Type != Node::MapType || m_pImp == nullptr)
             {
-                if(m_pImp)
-                {
-                    delete m_pImp;
-                }
+                Release();
                 m_pImp = new MapImp;
                 m_Type = Node::MapType;
             }
@@ -459,290 +641,296 @@ namespace Yaml
         {
             if(m_Type != Node::ScalarType || m_pImp == nullptr)
             {
-                if(m_pImp)
-                {
-                    delete m_pImp;
-                }
+                Release();
                 m_pImp = new ScalarImp;
                 m_Type = Node::ScalarType;
             }
 
         }
 
-        Node::eType    m_Type;  ///< Type of node.
-        TypeImp *      m_pImp;  ///< Imp of type.
-
-    };
+        /**
+        * @breif Share type imp of another node, instead of copying it.
+        *        Used by aliases, referencing anchored nodes.
+        *
+        */
+        void Share(NodeImp * pNodeImp)
+        {
+            if(pNodeImp == this)
+            {
+                return;
+            }
 
-    // Iterator implementation class
-    class IteratorImp
-    {
+            if(pNodeImp->m_pImp)
+            {
+                pNodeImp->m_pImp->m_RefCount++;
+            }
+            Release();
+            m_pImp = pNodeImp->m_pImp;
+            m_Type = pNodeImp->m_Type;
+        }
 
-    public:
+        /**
+        * @breif Release type imp. Deleted if no other node is sharing it.
+        *
+        */
+        void Release()
+        {
+            if(m_pImp != nullptr)
+            {
+                if(--m_pImp->m_RefCount == 0)
+                {
+                    delete m_pImp;
+                }
+                m_pImp = nullptr;
+            }
+        }
 
-        virtual ~IteratorImp()
+        /**
+        * @breif Get imp of node.
+        *
+        */
+        static NodeImp * Get(const Node & node)
         {
+            return static_cast<NodeImp*>(node.m_pImp);
         }
 
-        virtual Node::eType GetType() const = 0;
-        virtual void InitBegin(SequenceImp * pSequenceImp) = 0;
-        virtual void InitEnd(SequenceImp * pSequenceImp) = 0;
-        virtual void InitBegin(MapImp * pMapImp) = 0;
-        virtual void InitEnd(MapImp * pMapImp) = 0;
+        Node::eType    m_Type;          ///< Type of node.
+        uint32_t       m_LocationId;    ///< Id of document parse recording location of node, 0 if none.
+        TypeImp *      m_pImp;          ///< Imp of type.
 
     };
 
-    class SequenceIteratorImp : public IteratorImp
+    // Iterator class
+    Iterator::Iterator() :
+        m_Type(None)
     {
+    }
 
-    public:
-
-        virtual Node::eType GetType() const
+    Iterator::reference Iterator::operator *() const
+    {
+        switch(m_Type)
         {
-            return Node::SequenceType;
+        case SequenceType:
+            return { g_EmptyString, **m_SequenceIterator };
+        case MapType:
+            return { m_MapIterator->first, *m_MapIterator->second };
+        default:
+            break;
         }
 
-        virtual void InitBegin(SequenceImp * pSequenceImp)
-        {
-            m_Iterator = pSequenceImp->m_Sequence.begin();
-        }
+        g_NoneNode.Clear();
+        return { g_EmptyString, g_NoneNode };
+    }
 
-        virtual void InitEnd(SequenceImp * pSequenceImp)
-        {
-            m_Iterator = pSequenceImp->m_Sequence.end();
-        }
+    Iterator::reference Iterator::operator [] (const difference_type offset) const
+    {
+        return *(*this + offset);
+    }
 
-        virtual void InitBegin(MapImp * pMapImp)
+    Iterator & Iterator::operator ++ ()
+    {
+        switch(m_Type)
         {
+        case SequenceType:
+            ++m_SequenceIterator;
+            break;
+        case MapType:
+            ++m_MapIterator;
+            break;
+        default:
+            break;
         }
+        return *this;
+    }
+
+    Iterator Iterator::operator ++ (int)
+    {
+        Iterator it = *this;
+        ++(*this);
+        return it;
+    }
 
-        virtual void InitEnd(MapImp * pMapImp)
+    Iterator & Iterator::operator -- ()
+    {
+        switch(m_Type)
         {
+        case SequenceType:
+            --m_SequenceIterator;
+            break;
+        case MapType:
+            --m_MapIterator;
+            break;
+        default:
+            break;
         }
+        return *this;
+    }
+
+    Iterator Iterator::operator -- (int)
+    {
+        Iterator it = *this;
+        --(*this);
+        return it;
+    }
 
-        void Copy(const SequenceIteratorImp & it)
+    Iterator & Iterator::operator += (const difference_type offset)
+    {
+        switch(m_Type)
         {
-            m_Iterator = it.m_Iterator;
+        case SequenceType:
+            m_SequenceIterator += offset;
+            break;
+        case MapType:
+            std::advance(m_MapIterator, offset);
+            break;
+        default:
+            break;
         }
+        return *this;
+    }
 
-        std::map<size_t, Node *>::iterator m_Iterator;
-
-    };
+    Iterator & Iterator::operator -= (const difference_type offset)
+    {
+        return *this += -offset;
+    }
 
-    class MapIteratorImp : public IteratorImp
+    Iterator Iterator::operator + (const difference_type offset) const
     {
+        Iterator it = *this;
+        return it += offset;
+    }
 
-    public:
+    Iterator Iterator::operator - (const difference_type offset) const
+    {
+        Iterator it = *this;
+        return it -= offset;
+    }
 
-        virtual Node::eType GetType() const
+    Iterator::difference_type Iterator::operator - (const Iterator & it) const
+    {
+        switch(m_Type)
         {
-            return Node::MapType;
+        case SequenceType:
+            return m_SequenceIterator - it.m_SequenceIterator;
+        case MapType:
+            return std::distance(it.m_MapIterator, m_MapIterator);
+        default:
+            break;
         }
+        return 0;
+    }
 
-        virtual void InitBegin(SequenceImp * pSequenceImp)
+    bool Iterator::operator == (const Iterator & it) const
+    {
+        if(m_Type != it.m_Type)
         {
+            return false;
         }
 
-        virtual void InitEnd(SequenceImp * pSequenceImp)
+        switch(m_Type)
         {
+        case SequenceType:
+            return m_SequenceIterator == it.m_SequenceIterator;
+        case MapType:
+            return m_MapIterator == it.m_MapIterator;
+        default:
+            break;
         }
 
-        virtual void InitBegin(MapImp * pMapImp)
-        {
-            m_Iterator = pMapImp->m_Map.begin();
-        }
+        return true;
+    }
 
-        virtual void InitEnd(MapImp * pMapImp)
-        {
-            m_Iterator = pMapImp->m_Map.end();
-        }
+    bool Iterator::operator != (const Iterator & it) const
+    {
+        return !(*this == it);
+    }
 
-        void Copy(const MapIteratorImp & it)
-        {
-            m_Iterator = it.m_Iterator;
-        }
+    bool Iterator::operator < (const Iterator & it) const
+    {
+        return (*this - it) < 0;
+    }
 
-        std::map<std::string, Node *>::iterator m_Iterator;
+    bool Iterator::operator > (const Iterator & it) const
+    {
+        return it < *this;
+    }
 
-    };
+    bool Iterator::operator <= (const Iterator & it) const
+    {
+        return !(it < *this);
+    }
 
-    class SequenceConstIteratorImp : public IteratorImp
+    bool Iterator::operator >= (const Iterator & it) const
     {
+        return !(*this < it);
+    }
 
-    public:
 
-        virtual Node::eType GetType() const
-        {
-            return Node::SequenceType;
-        }
+    // Const Iterator class
+    ConstIterator::ConstIterator() :
+        m_Type(None)
+    {
+    }
 
-        virtual void InitBegin(SequenceImp * pSequenceImp)
-        {
-            m_Iterator = pSequenceImp->m_Sequence.begin();
-        }
+    ConstIterator::ConstIterator(const Iterator & it) :
+        m_Type(static_cast<eType>(it.m_Type)),
+        m_SequenceIterator(it.m_SequenceIterator),
+        m_MapIterator(it.m_MapIterator)
+    {
+    }
 
-        virtual void InitEnd(SequenceImp * pSequenceImp)
+    ConstIterator::reference ConstIterator::operator *() const
+    {
+        switch(m_Type)
         {
-            m_Iterator = pSequenceImp->m_Sequence.end();
+        case SequenceType:
+            return { g_EmptyString, **m_SequenceIterator };
+        case MapType:
+            return { m_MapIterator->first, *m_MapIterator->second };
+        default:
+            break;
         }
 
-        virtual void InitBegin(MapImp * pMapImp)
-        {
-        }
+        return { g_EmptyString, g_ConstNoneNode };
+    }
 
-        virtual void InitEnd(MapImp * pMapImp)
-        {
-        }
+    ConstIterator::reference ConstIterator::operator [] (const difference_type offset) const
+    {
+        return *(*this + offset);
+    }
 
-        void Copy(const SequenceConstIteratorImp & it)
-        {
-            m_Iterator = it.m_Iterator;
-        }
-
-        std::map<size_t, Node *>::const_iterator m_Iterator;
-
-    };
-
-    class MapConstIteratorImp : public IteratorImp
-    {
-
-    public:
-
-        virtual Node::eType GetType() const
-        {
-            return Node::MapType;
-        }
-
-        virtual void InitBegin(SequenceImp * pSequenceImp)
-        {
-        }
-
-        virtual void InitEnd(SequenceImp * pSequenceImp)
-        {
-        }
-
-        virtual void InitBegin(MapImp * pMapImp)
-        {
-            m_Iterator = pMapImp->m_Map.begin();
-        }
-
-        virtual void InitEnd(MapImp * pMapImp)
-        {
-            m_Iterator = pMapImp->m_Map.end();
-        }
-
-        void Copy(const MapConstIteratorImp & it)
-        {
-            m_Iterator = it.m_Iterator;
-        }
-
-        std::map<std::string, Node *>::const_iterator m_Iterator;
-
-    };
-
-
-    // Iterator class
-    Iterator::Iterator() :
-        m_Type(None),
-        m_pImp(nullptr)
-    {
-    }
-
-    Iterator::~Iterator()
-    {
-        if(m_pImp)
-        {
-            switch(m_Type)
-            {
-            case SequenceType:
-                delete static_cast<SequenceIteratorImp*>(m_pImp);
-                break;
-            case MapType:
-                delete static_cast<MapIteratorImp*>(m_pImp);
-                break;
-            default:
-                break;
-            }
-
-        }
-    }
-
-    Iterator::Iterator(const Iterator & it) :
-        m_Type(None),
-        m_pImp(nullptr)
-    {
-        *this = it;
-    }
-
-    Iterator & Iterator::operator = (const Iterator & it)
+    ConstIterator & ConstIterator::operator ++ ()
     {
-        if(m_pImp)
-        {
-            switch(m_Type)
-            {
-            case SequenceType:
-                delete static_cast<SequenceIteratorImp*>(m_pImp);
-                break;
-            case MapType:
-                delete static_cast<MapIteratorImp*>(m_pImp);
-                break;
-            default:
-                break;
-            }
-            m_pImp = nullptr;
-            m_Type = None;
-        }
-
-        IteratorImp * pNewImp = nullptr;
-
-        switch(it.m_Type)
+        switch(m_Type)
         {
         case SequenceType:
-            m_Type = SequenceType;
-            pNewImp = new SequenceIteratorImp;
-            static_cast<SequenceIteratorImp*>(pNewImp)->m_Iterator = static_cast<SequenceIteratorImp*>(it.m_pImp)->m_Iterator;
+            ++m_SequenceIterator;
             break;
         case MapType:
-            m_Type = MapType;
-            pNewImp = new MapIteratorImp;
-            static_cast<MapIteratorImp*>(pNewImp)->m_Iterator = static_cast<MapIteratorImp*>(it.m_pImp)->m_Iterator;
+            ++m_MapIterator;
             break;
         default:
             break;
         }
-
-        m_pImp = pNewImp;
         return *this;
     }
 
-    std::pair<const std::string &, Node &> Iterator::operator *()
+    ConstIterator ConstIterator::operator ++ (int)
     {
-        switch(m_Type)
-        {
-        case SequenceType:
-            return { g_EmptyString, *(static_cast<SequenceIteratorImp*>(m_pImp)->m_Iterator->second)};
-            break;
-        case MapType:
-            return {static_cast<MapIteratorImp*>(m_pImp)->m_Iterator->first,
-                    *(static_cast<MapIteratorImp*>(m_pImp)->m_Iterator->second)};
-            break;
-        default:
-            break;
-        }
-
-        g_NoneNode.Clear();
-        return { g_EmptyString, g_NoneNode};
+        ConstIterator it = *this;
+        ++(*this);
+        return it;
     }
 
-    Iterator & Iterator::operator ++ (int dummy)
+    ConstIterator & ConstIterator::operator -- ()
     {
         switch(m_Type)
         {
         case SequenceType:
-            static_cast<SequenceIteratorImp*>(m_pImp)->m_Iterator++;
+            --m_SequenceIterator;
             break;
         case MapType:
-            static_cast<MapIteratorImp*>(m_pImp)->m_Iterator++;
+            --m_MapIterator;
             break;
         default:
             break;
@@ -750,200 +938,103 @@ namespace Yaml
         return *this;
     }
 
-    Iterator & Iterator::operator -- (int dummy)
+    ConstIterator ConstIterator::operator -- (int)
     {
-        switch(m_Type)
-        {
-        case SequenceType:
-            static_cast<SequenceIteratorImp*>(m_pImp)->m_Iterator--;
-            break;
-        case MapType:
-            static_cast<MapIteratorImp*>(m_pImp)->m_Iterator--;
-            break;
-        default:
-            break;
-        }
-        return *this;
+        ConstIterator it = *this;
+        --(*this);
+        return it;
     }
 
-    bool Iterator::operator == (const Iterator & it)
+    ConstIterator & ConstIterator::operator += (const difference_type offset)
     {
-        if(m_Type != it.m_Type)
-        {
-            return false;
-        }
-
         switch(m_Type)
         {
         case SequenceType:
-            return static_cast<SequenceIteratorImp*>(m_pImp)->m_Iterator == static_cast<SequenceIteratorImp*>(it.m_pImp)->m_Iterator;
+            m_SequenceIterator += offset;
             break;
         case MapType:
-            return static_cast<MapIteratorImp*>(m_pImp)->m_Iterator == static_cast<MapIteratorImp*>(it.m_pImp)->m_Iterator;
+            std::advance(m_MapIterator, offset);
             break;
         default:
             break;
         }
-
-        return false;
-    }
-
-    bool Iterator::operator != (const Iterator & it)
-    {
-        return !(*this == it);
+        return *this;
     }
 
-
-    // Const Iterator class
-    ConstIterator::ConstIterator() :
-        m_Type(None),
-        m_pImp(nullptr)
+    ConstIterator & ConstIterator::operator -= (const difference_type offset)
     {
+        return *this += -offset;
     }
 
-    ConstIterator::~ConstIterator()
+    ConstIterator ConstIterator::operator + (const difference_type offset) const
     {
-        if(m_pImp)
-        {
-            switch(m_Type)
-            {
-            case SequenceType:
-                delete static_cast<SequenceConstIteratorImp*>(m_pImp);
-                break;
-            case MapType:
-                delete static_cast<MapConstIteratorImp*>(m_pImp);
-                break;
-            default:
-                break;
-            }
-
-        }
+        ConstIterator it = *this;
+        return it += offset;
     }
 
-    ConstIterator::ConstIterator(const ConstIterator & it) :
-        m_Type(None),
-        m_pImp(nullptr)
+    ConstIterator ConstIterator::operator - (const difference_type offset) const
     {
-        *this = it;
+        ConstIterator it = *this;
+        return it -= offset;
     }
 
-    ConstIterator & ConstIterator::operator = (const ConstIterator & it)
+    ConstIterator::difference_type ConstIterator::operator - (const ConstIterator & it) const
     {
-        if(m_pImp)
-        {
-            switch(m_Type)
-            {
-            case SequenceType:
-                delete static_cast<SequenceConstIteratorImp*>(m_pImp);
-                break;
-            case MapType:
-                delete static_cast<MapConstIteratorImp*>(m_pImp);
-                break;
-            default:
-                break;
-            }
-            m_pImp = nullptr;
-            m_Type = None;
-        }
-
-        IteratorImp * pNewImp = nullptr;
-
-        switch(it.m_Type)
+        switch(m_Type)
         {
         case SequenceType:
-            m_Type = SequenceType;
-            pNewImp = new SequenceConstIteratorImp;
-            static_cast<SequenceConstIteratorImp*>(pNewImp)->m_Iterator = static_cast<SequenceConstIteratorImp*>(it.m_pImp)->m_Iterator;
-            break;
+            return m_SequenceIterator - it.m_SequenceIterator;
         case MapType:
-            m_Type = MapType;
-            pNewImp = new MapConstIteratorImp;
-            static_cast<MapConstIteratorImp*>(pNewImp)->m_Iterator = static_cast<MapConstIteratorImp*>(it.m_pImp)->m_Iterator;
-            break;
+            return std::distance(it.m_MapIterator, m_MapIterator);
         default:
             break;
         }
-
-        m_pImp = pNewImp;
-        return *this;
+        return 0;
     }
 
-    std::pair<const std::string &, const Node &> ConstIterator::operator *()
+    bool ConstIterator::operator == (const ConstIterator & it) const
     {
-        switch(m_Type)
+        if(m_Type != it.m_Type)
         {
-        case SequenceType:
-            return { g_EmptyString, *(static_cast<SequenceConstIteratorImp*>(m_pImp)->m_Iterator->second)};
-            break;
-        case MapType:
-            return {static_cast<MapConstIteratorImp*>(m_pImp)->m_Iterator->first,
-                    *(static_cast<MapConstIteratorImp*>(m_pImp)->m_Iterator->second)};
-            break;
-        default:
-            break;
+            return false;
         }
 
-        g_NoneNode.Clear();
-        return { g_EmptyString, g_NoneNode};
-    }
-
-    ConstIterator & ConstIterator::operator ++ (int dummy)
-    {
         switch(m_Type)
         {
         case SequenceType:
-            static_cast<SequenceConstIteratorImp*>(m_pImp)->m_Iterator++;
-            break;
+            return m_SequenceIterator == it.m_SequenceIterator;
         case MapType:
-            static_cast<MapConstIteratorImp*>(m_pImp)->m_Iterator++;
-            break;
+            return m_MapIterator == it.m_MapIterator;
         default:
             break;
         }
-        return *this;
+
+        return true;
     }
 
-    ConstIterator & ConstIterator::operator -- (int dummy)
+    bool ConstIterator::operator != (const ConstIterator & it) const
     {
-        switch(m_Type)
-        {
-        case SequenceType:
-            static_cast<SequenceConstIteratorImp*>(m_pImp)->m_Iterator--;
-            break;
-        case MapType:
-            static_cast<MapConstIteratorImp*>(m_pImp)->m_Iterator--;
-            break;
-        default:
-            break;
-        }
-        return *this;
+        return !(*this == it);
     }
 
-    bool ConstIterator::operator == (const ConstIterator & it)
+    bool ConstIterator::operator < (const ConstIterator & it) const
     {
-        if(m_Type != it.m_Type)
-        {
-            return false;
-        }
+        return (*this - it) < 0;
+    }
 
-        switch(m_Type)
-        {
-        case SequenceType:
-            return static_cast<SequenceConstIteratorImp*>(m_pImp)->m_Iterator == static_cast<SequenceConstIteratorImp*>(it.m_pImp)->m_Iterator;
-            break;
-        case MapType:
-            return static_cast<MapConstIteratorImp*>(m_pImp)->m_Iterator == static_cast<MapConstIteratorImp*>(it.m_pImp)->m_Iterator;
-            break;
-        default:
-            break;
-        }
+    bool ConstIterator::operator > (const ConstIterator & it) const
+    {
+        return it < *this;
+    }
 
-        return false;
+    bool ConstIterator::operator <= (const ConstIterator & it) const
+    {
+        return !(it < *this);
     }
 
-    bool ConstIterator::operator != (const ConstIterator & it)
+    bool ConstIterator::operator >= (const ConstIterator & it) const
     {
-        return !(*this == it);
+        return !(*this < it);
     }
 
 
@@ -1016,6 +1107,81 @@ namespace Yaml
         return TYPE_IMP->GetSize();
     }
 
+    size_t Node::VisitElements(ElementVisitor visitor, void * pContext, const size_t maxCount) const
+    {
+        size_t count = 0;
+        switch(NODE_IMP->m_Type)
+        {
+        case SequenceType:
+        {
+            const std::vector<Node*> & sequence = static_cast<SequenceImp*>(TYPE_IMP)->m_Sequence;
+            for(auto it = sequence.begin(); it != sequence.end() && count < maxCount; ++it, ++count)
+            {
+                visitor(pContext, count, nullptr, **it);
+            }
+        }
+        break;
+        case MapType:
+        {
+            const std::map<std::string, Node*> & map = static_cast<MapImp*>(TYPE_IMP)->m_Map;
+            for(auto it = map.begin(); it != map.end() && count < maxCount; ++it, ++count)
+            {
+                visitor(pContext, count, &it->first, *it->second);
+            }
+        }
+        break;
+        default:
+            break;
+        }
+
+        return count;
+    }
+
+    template<typename T>
+    size_t Node::ConvertNumbers(T * pOut, const size_t count) const
+    {
+        if(NODE_IMP->m_Type != SequenceType)
+        {
+            return 0;
+        }
+
+        const std::vector<Node*> & sequence = static_cast<SequenceImp*>(TYPE_IMP)->m_Sequence;
+        const size_t size = sequence.size() < count ? sequence.size() : count;
+        for(size_t i = 0; i < size; i++)
+        {
+            const NodeImp * pElementImp = NODE_IMP_EXT(*sequence[i]);
+            T value = T();
+            if(pElementImp->m_Type == ScalarType)
+            {
+                const ScalarImp * pScalarImp = static_cast<const ScalarImp*>(pElementImp->m_pImp);
+                if(impl::ValueConverter<T>::Get(pScalarImp->m_Native, value) == false)
+                {
+                    const std::string & data = pScalarImp->m_Value;
+                    impl::ScalarNumber number;
+                    impl::ParseScalarNumber(data.c_str(), data.c_str() + data.size(), impl::CacheConverter<T>::Kind, number);
+                    value = T();
+                    impl::CacheConverter<T>::Get(number, value);
+                }
+            }
+            pOut[i] = value;
+        }
+
+        return size;
+    }
+
+    template size_t Node::ConvertNumbers<bool>(bool * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<short>(short * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<unsigned short>(unsigned short * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<int>(int * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<unsigned int>(unsigned int * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<long>(long * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<unsigned long>(unsigned long * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<long long>(long long * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<unsigned long long>(unsigned long long * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<float>(float * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<double>(double * pOut, const size_t count) const;
+    template size_t Node::ConvertNumbers<long double>(long double * pOut, const size_t count) const;
+
     Node & Node::Insert(const size_t index)
     {
         NODE_IMP->InitSequence();
@@ -1051,6 +1217,37 @@ namespace Yaml
         return *TYPE_IMP->GetNode(key);
     }
 
+    const Node * Node::Find(const size_t index) const
+    {
+        if(TYPE_IMP == nullptr || NODE_IMP->m_Type != Node::SequenceType)
+        {
+            return nullptr;
+        }
+
+        const std::vector<Node*> & sequence = static_cast<SequenceImp*>(TYPE_IMP)->m_Sequence;
+        if(index >= sequence.size())
+        {
+            return nullptr;
+        }
+        return sequence[index];
+    }
+
+    const Node * Node::Find(const std::string & key) const
+    {
+        if(TYPE_IMP == nullptr || NODE_IMP->m_Type != Node::MapType)
+        {
+            return nullptr;
+        }
+
+        const std::map<std::string, Node*> & map = static_cast<MapImp*>(TYPE_IMP)->m_Map;
+        auto it = map.find(key);
+        if(it == map.end())
+        {
+            return nullptr;
+        }
+        return it->second;
+    }
+
     void Node::Erase(const size_t index)
     {
         if(TYPE_IMP == nullptr || NODE_IMP->m_Type != Node::SequenceType)
@@ -1092,124 +1289,160 @@ namespace Yaml
         return *this;
     }
 
-    Iterator Node::Begin()
+    Node & Node::Set(const std::string & value)
     {
-        Iterator it;
+        return *this = value;
+    }
 
-        if(TYPE_IMP != nullptr)
-        {
-            IteratorImp * pItImp = nullptr;
+    Node & Node::Set(const char * value)
+    {
+        return *this = value;
+    }
 
-            switch(NODE_IMP->m_Type)
-            {
-            case Node::SequenceType:
-                it.m_Type = Iterator::SequenceType;
-                pItImp = new SequenceIteratorImp;
-                pItImp->InitBegin(static_cast<SequenceImp*>(TYPE_IMP));
-                break;
-            case Node::MapType:
-                it.m_Type = Iterator::MapType;
-                pItImp = new MapIteratorImp;
-                pItImp->InitBegin(static_cast<MapImp*>(TYPE_IMP));
-                break;
-            default:
-                break;
-            }
+    Node & Node::SetInteger(const int64_t value)
+    {
+        char buffer[32];
+        const size_t size = impl::FormatInteger(buffer, value);
+        impl::ScalarValue native;
+        native.Type = impl::ScalarValue::IntegerType;
+        native.Integer = value;
+        return SetNative(buffer, size, native);
+    }
 
-            it.m_pImp = pItImp;
+    Node & Node::SetUnsignedInteger(const uint64_t value)
+    {
+        if(value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max()))
+        {
+            return SetInteger(static_cast<int64_t>(value));
         }
 
-        return it;
+        char buffer[32];
+        const size_t size = impl::FormatUnsignedInteger(buffer, value);
+        return SetNative(buffer, size, impl::ScalarValue());
     }
 
-    ConstIterator Node::Begin() const
+    Node & Node::SetFloat(const double value)
     {
-        ConstIterator it;
+        char buffer[32];
+        const size_t size = impl::FormatFloat(buffer, value);
+        impl::ScalarValue native;
+        native.Type = impl::ScalarValue::FloatType;
+        native.Float = value;
+        return SetNative(buffer, size, native);
+    }
 
-        if(TYPE_IMP != nullptr)
-        {
-            IteratorImp * pItImp = nullptr;
+    Node & Node::SetBoolean(const bool value)
+    {
+        impl::ScalarValue native;
+        native.Type = impl::ScalarValue::BooleanType;
+        native.Boolean = value;
+        return SetNative(value ? "true" : "false", value ? 4 : 5, native);
+    }
 
-            switch(NODE_IMP->m_Type)
-            {
-            case Node::SequenceType:
-                it.m_Type = ConstIterator::SequenceType;
-                pItImp = new SequenceConstIteratorImp;
-                pItImp->InitBegin(static_cast<SequenceImp*>(TYPE_IMP));
-                break;
-            case Node::MapType:
-                it.m_Type = ConstIterator::MapType;
-                pItImp = new MapConstIteratorImp;
-                pItImp->InitBegin(static_cast<MapImp*>(TYPE_IMP));
-                break;
-            default:
-                break;
-            }
+    Node & Node::SetNative(const char * data, const size_t size, const impl::ScalarValue & value)
+    {
+        NODE_IMP->InitScalar();
+        ScalarImp * pScalarImp = static_cast<ScalarImp*>(TYPE_IMP);
+        pScalarImp->m_Value.assign(data, size);
+        pScalarImp->Reset();
+        pScalarImp->m_Native = value;
+        return *this;
+    }
 
-            it.m_pImp = pItImp;
+    Iterator Node::Begin()
+    {
+        Iterator it;
+        switch(NODE_IMP->m_Type)
+        {
+        case Node::SequenceType:
+            it.m_Type = Iterator::SequenceType;
+            it.m_SequenceIterator = static_cast<SequenceImp*>(TYPE_IMP)->m_Sequence.begin();
+            break;
+        case Node::MapType:
+            it.m_Type = Iterator::MapType;
+            it.m_MapIterator = static_cast<MapImp*>(TYPE_IMP)->m_Map.begin();
+            break;
+        default:
+            break;
         }
+        return it;
+    }
 
+    ConstIterator Node::Begin() const
+    {
+        ConstIterator it;
+        switch(NODE_IMP->m_Type)
+        {
+        case Node::SequenceType:
+            it.m_Type = ConstIterator::SequenceType;
+            it.m_SequenceIterator = static_cast<const SequenceImp*>(TYPE_IMP)->m_Sequence.begin();
+            break;
+        case Node::MapType:
+            it.m_Type = ConstIterator::MapType;
+            it.m_MapIterator = static_cast<const MapImp*>(TYPE_IMP)->m_Map.begin();
+            break;
+        default:
+            break;
+        }
         return it;
     }
 
     Iterator Node::End()
     {
-       Iterator it;
-
-        if(TYPE_IMP != nullptr)
+        Iterator it;
+        switch(NODE_IMP->m_Type)
         {
-            IteratorImp * pItImp = nullptr;
-
-            switch(NODE_IMP->m_Type)
-            {
-            case Node::SequenceType:
-                it.m_Type = Iterator::SequenceType;
-                pItImp = new SequenceIteratorImp;
-                pItImp->InitEnd(static_cast<SequenceImp*>(TYPE_IMP));
-                break;
-            case Node::MapType:
-                it.m_Type = Iterator::MapType;
-                pItImp = new MapIteratorImp;
-                pItImp->InitEnd(static_cast<MapImp*>(TYPE_IMP));
-                break;
-            default:
-                break;
-            }
-
-            it.m_pImp = pItImp;
+        case Node::SequenceType:
+            it.m_Type = Iterator::SequenceType;
+            it.m_SequenceIterator = static_cast<SequenceImp*>(TYPE_IMP)->m_Sequence.end();
+            break;
+        case Node::MapType:
+            it.m_Type = Iterator::MapType;
+            it.m_MapIterator = static_cast<MapImp*>(TYPE_IMP)->m_Map.end();
+            break;
+        default:
+            break;
         }
-
         return it;
     }
 
     ConstIterator Node::End() const
     {
-       ConstIterator it;
-
-        if(TYPE_IMP != nullptr)
+        ConstIterator it;
+        switch(NODE_IMP->m_Type)
         {
-            IteratorImp * pItImp = nullptr;
+        case Node::SequenceType:
+            it.m_Type = ConstIterator::SequenceType;
+            it.m_SequenceIterator = static_cast<const SequenceImp*>(TYPE_IMP)->m_Sequence.end();
+            break;
+        case Node::MapType:
+            it.m_Type = ConstIterator::MapType;
+            it.m_MapIterator = static_cast<const MapImp*>(TYPE_IMP)->m_Map.end();
+            break;
+        default:
+            break;
+        }
+        return it;
+    }
 
-            switch(NODE_IMP->m_Type)
-            {
-            case Node::SequenceType:
-                it.m_Type = ConstIterator::SequenceType;
-                pItImp = new SequenceConstIteratorImp;
-                pItImp->InitEnd(static_cast<SequenceImp*>(TYPE_IMP));
-                break;
-            case Node::MapType:
-                it.m_Type = ConstIterator::MapType;
-                pItImp = new MapConstIteratorImp;
-                pItImp->InitEnd(static_cast<MapImp*>(TYPE_IMP));
-                break;
-            default:
-                break;
-            }
+    Iterator Node::begin()
+    {
+        return Begin();
+    }
 
-            it.m_pImp = pItImp;
-        }
+    ConstIterator Node::begin() const
+    {
+        return Begin();
+    }
 
-        return it;
+    Iterator Node::end()
+    {
+        return End();
+    }
+
+    ConstIterator Node::end() const
+    {
+        return End();
     }
 
     const std::string & Node::AsString() const
@@ -1222,6 +1455,126 @@ namespace Yaml
         return TYPE_IMP->GetData();
     }
 
+    const impl::ScalarValue & Node::NativeValue() const
+    {
+        static const impl::ScalarValue noneValue;
+        if(NODE_IMP->m_Type != Node::ScalarType)
+        {
+            return noneValue;
+        }
+
+        return static_cast<ScalarImp*>(TYPE_IMP)->m_Native;
+    }
+
+    impl::ScalarNumber Node::CachedValue(const impl::ScalarNumber::eKind kind) const
+    {
+        if(NODE_IMP->m_Type != Node::ScalarType)
+        {
+            impl::ScalarNumber number;
+            impl::ParseScalarNumber(g_EmptyString.c_str(), g_EmptyString.c_str(), kind, number);
+            return number;
+        }
+
+        return static_cast<ScalarImp*>(TYPE_IMP)->GetNumber(kind);
+    }
+
+    Node::eDataType Node::DataType() const
+    {
+        switch(NativeValue().Type)
+        {
+        case impl::ScalarValue::NullType:
+            return NullData;
+        case impl::ScalarValue::BooleanType:
+            return BooleanData;
+        case impl::ScalarValue::IntegerType:
+            return IntegerData;
+        case impl::ScalarValue::FloatType:
+            return FloatData;
+        default:
+            break;
+        }
+        return StringData;
+    }
+
+
+
+    // Document implementations
+    typedef std::unordered_map<const Node *, Location> LocationTable;
+
+    static std::atomic<uint32_t> g_LocationId(0);
+
+    class DocumentImp
+    {
+
+    public:
+
+        DocumentImp() :
+            m_LocationId(0)
+        {
+        }
+
+        /**
+        * @breif Clear locations and get a new id, never equal to 0, for recording locations of next parse.
+        *        Nodes are tagged with the id, entries of nodes at reused addresses are not matching.
+        *
+        */
+        uint32_t ResetLocations()
+        {
+            m_Locations.clear();
+            do
+            {
+                m_LocationId = ++g_LocationId;
+            } while(m_LocationId == 0);
+            return m_LocationId;
+        }
+
+        LocationTable   m_Locations;    ///< Locations of parsed nodes, empty if not recorded.
+        uint32_t        m_LocationId;   ///< Id of last parse, tagged to its recorded nodes.
+
+    };
+
+    Document::Document() :
+        m_pImp(new DocumentImp)
+    {
+    }
+
+    Document::~Document()
+    {
+        delete static_cast<DocumentImp*>(m_pImp);
+    }
+
+    Node & Document::Root()
+    {
+        return m_Root;
+    }
+
+    const Node & Document::Root() const
+    {
+        return m_Root;
+    }
+
+    Location Document::LocationOf(const Node & node) const
+    {
+        const DocumentImp * pImp = static_cast<DocumentImp*>(m_pImp);
+        if(NODE_IMP_EXT(node)->m_LocationId != pImp->m_LocationId)
+        {
+            return Location();
+        }
+
+        const LocationTable & locations = pImp->m_Locations;
+        auto it = locations.find(&node);
+        if(it == locations.end())
+        {
+            return Location();
+        }
+        return it->second;
+    }
+
+    void Document::Clear()
+    {
+        m_Root.Clear();
+        static_cast<DocumentImp*>(m_pImp)->ResetLocations();
+    }
 
 
     // Reader implementations
@@ -1256,7 +1609,8 @@ namespace Yaml
         {
             LiteralScalarFlag,      ///< Literal scalar type, defined as "|".
             FoldedScalarFlag,       ///< Folded scalar type, defined as "<".
-            ScalarNewlineFlag       ///< Scalar ends with a newline.
+            ScalarNewlineFlag,      ///< Scalar ends with a newline.
+            FlowFlag                ///< Flow collection, defined as "[...]" or "{...}".
         };
 
         /**
@@ -1319,20 +1673,35 @@ namespace Yaml
             Flags |= newFlags;
         }
 
-        static const unsigned char FlagMask[3];
+        static const unsigned char FlagMask[4];
 
         std::string     Data;       ///< Data of line.
+        std::string     Anchor;     ///< Anchor name of value, if line is sequence or map.
+        std::string     Tag;        ///< Tag of value, if line is sequence or map.
         size_t          No;         ///< Line number.
         size_t          Offset;     ///< Offset to first character in data.
         Node::eType     Type;       ///< Type of line.
         unsigned char   Flags;      ///< Flags of line.
         ReaderLine *    NextLine;   ///< Pointer to next line.
 
+        /**
+        * @breif Line joined into this line, only used by multi-line flow collections.
+        *
+        */
+        struct Segment
+        {
+            size_t Position;    ///< Start position of joined line in data.
+            size_t No;          ///< Line number of joined line.
+            size_t Offset;      ///< Offset of joined line.
+        };
+
+        std::vector<Segment> Segments;  ///< Joined lines, empty if no lines are joined.
+
 
 
     };
 
-    const unsigned char ReaderLine::FlagMask[3] = { 0x01, 0x02, 0x04 };
+    const unsigned char ReaderLine::FlagMask[4] = { 0x01, 0x02, 0x04, 0x08 };
 
 
     /**
@@ -1349,7 +1718,11 @@ namespace Yaml
         * @breif Default constructor.
         *
         */
-        ParseImp()
+        ParseImp(const bool typedScalars = false, LocationTable * pLocations = nullptr, const uint32_t locationId = 0) :
+            m_TypedScalars(typedScalars),
+            m_pLocations(pLocations),
+            m_LocationId(locationId),
+            m_FlowDepth(0)
         {
         }
 
@@ -1360,6 +1733,14 @@ namespace Yaml
         ~ParseImp()
         {
             ClearLines();
+            for (auto it = m_DetachedNodes.begin(); it != m_DetachedNodes.end(); it++)
+            {
+                if(m_pLocations)
+                {
+                    m_pLocations->erase(*it);
+                }
+                delete *it;
+            }
         }
 
         /**
@@ -1379,6 +1760,10 @@ namespace Yaml
             catch(Exception e)
             {
                 root.Clear();
+                if(m_pLocations)
+                {
+                    m_pLocations->clear();
+                }
                 throw;
             }
         }
@@ -1408,14 +1793,53 @@ namespace Yaml
             size_t          lineNo = 0;
             bool            documentStartFound = false;
             bool            foundFirstNotEmpty = false;
-            std::streampos  streamPos = 0;
 
-            // Read all lines, as long as the stream is ok.
-            while (!stream.eof() && !stream.fail())
+            if (stream.eof() || stream.fail())
+            {
+                return;
+            }
+
+            // Read data of current document.
+            // Seekable streams are read in blocks, possibly past the end of document, and repositioned after it.
+            // Streams that cannot be repositioned, such as pipes, are read line by line.
+            std::streampos streamPos = stream.tellg();
+            if (streamPos != std::streampos(-1) && !stream.seekg(streamPos))
+            {
+                stream.clear();
+                streamPos = std::streampos(-1);
+            }
+
+            std::string data;
+            if (streamPos == std::streampos(-1))
+            {
+                ReadDocumentData(stream, data);
+            }
+            else
+            {
+                ReadDocumentBlocks(stream, data);
+            }
+
+            // Skip byte order mark.
+            size_t lineStart = 0;
+            if (data.size() >= 3 && data[0] == '\xEF' && data[1] == '\xBB' && data[2] == '\xBF')
+            {
+                lineStart = 3;
+            }
+
+            // Validate characters and find all line ends, in a single pass.
+            std::vector<size_t> lineEnds;
+            std::vector<size_t> invalidPositions;
+            ScanCharacters(data.c_str(), lineStart, data.size(), lineEnds, invalidPositions);
+            lineEnds.push_back(data.size());
+            auto invalidIt = invalidPositions.begin();
+
+            // Read all lines.
+            for (auto lineEndIt = lineEnds.begin(); lineEndIt != lineEnds.end(); lineEndIt++)
             {
                 // Read line
-                streamPos = stream.tellg();
-                std::getline(stream, line);
+                const size_t currentLineStart = lineStart;
+                line.assign(data, lineStart, *lineEndIt - lineStart);
+                lineStart = *lineEndIt + 1;
                 lineNo++;
 
                 // Remove comment
@@ -1437,11 +1861,12 @@ namespace Yaml
                 // End of document.
                 if (line == "...")
                 {
+                    SeekStream(stream, streamPos, lineStart);
                     break;
                 }
                 else if(line == "---")
                 {
-                    stream.seekg(streamPos);
+                    SeekStream(stream, streamPos, currentLineStart);
                     break;
                 }
 
@@ -1455,12 +1880,14 @@ namespace Yaml
                 }
 
                 // Validate characters.
-                for (size_t i = 0; i < line.size(); i++)
+                const size_t currentLineEnd = currentLineStart + line.size();
+                while (invalidIt != invalidPositions.end() && *invalidIt < currentLineEnd)
                 {
-                    if (line[i] != '\t' && (line[i] < 32 || line[i] > 125))
+                    if (*invalidIt >= currentLineStart)
                     {
-                        throw ParsingException(ExceptionMessage(g_ErrorInvalidCharacter, lineNo, i + 1));
+                        throw ParsingException(ExceptionMessage(g_ErrorInvalidCharacter, lineNo, *invalidIt - currentLineStart + 1));
                     }
+                    ++invalidIt;
                 }
 
                 // Validate tabs
@@ -1502,6 +1929,141 @@ namespace Yaml
             }
         }
 
+        /**
+        * @breif Read lines of stream up to and including end of document, line by line.
+        *        Used by ReadLines for streams that cannot be repositioned after end of document.
+        *        A consumed document start("---") of the next document is not needed for parsing it.
+        *
+        */
+        static void ReadDocumentData(std::iostream & stream, std::string & data)
+        {
+            std::string line = "";
+            bool        documentStartFound = false;
+
+            while (std::getline(stream, line))
+            {
+                const size_t lineStart = data.size();
+                data += line;
+                if (stream.eof() == false)
+                {
+                    data += '\n';
+                }
+
+                if (IsDocumentEnd(data, lineStart, lineStart + line.size(), documentStartFound))
+                {
+                    break;
+                }
+            }
+        }
+
+        /**
+        * @breif Read blocks of stream until end of document is found, or end of stream.
+        *        Used by ReadLines for seekable streams, data may contain lines past end of document.
+        *
+        */
+        static void ReadDocumentBlocks(std::iostream & stream, std::string & data)
+        {
+            static const size_t blockSize = 65536;
+            bool                documentStartFound = false;
+            size_t              lineStart = 0;
+
+            while (true)
+            {
+                const size_t size = data.size();
+                data.resize(size + blockSize);
+                stream.read(&data[size], blockSize);
+                data.resize(size + static_cast<size_t>(stream.gcount()));
+                const bool endOfStream = data.size() < size + blockSize;
+                if (endOfStream)
+                {
+                    // Short read sets failbit, only end of stream is reported, as by reading all data.
+                    stream.clear(stream.rdstate() & ~std::ios::failbit);
+                }
+
+                // Check complete lines, and the last line at end of stream.
+                while (lineStart < data.size())
+                {
+                    size_t lineEnd = data.find('\n', lineStart);
+                    if (lineEnd == std::string::npos)
+                    {
+                        if (endOfStream == false)
+                        {
+                            break;
+                        }
+                        lineEnd = data.size();
+                    }
+
+                    if (IsDocumentEnd(data, lineStart, lineEnd, documentStartFound))
+                    {
+                        return;
+                    }
+                    lineStart = lineEnd + 1;
+                }
+
+                if (endOfStream)
+                {
+                    return;
+                }
+            }
+        }
+
+        /**
+        * @breif Check if line [lineStart, lineEnd) of data ends the document, by "..." or a second "---".
+        *        Matches lines ending documents in ReadLines.
+        *
+        */
+        static bool IsDocumentEnd(const std::string & data, size_t lineStart, const size_t lineEnd, bool & documentStartFound)
+        {
+            // Skip byte order mark.
+            if (lineStart == 0 && data.compare(0, 3, "\xEF\xBB\xBF") == 0)
+            {
+                lineStart = 3;
+            }
+
+            // Only lines starting with "---" or "..." can match, after removing comments.
+            if (lineEnd < lineStart + 3 ||
+                (data.compare(lineStart, 3, "---") != 0 && data.compare(lineStart, 3, "...") != 0))
+            {
+                return false;
+            }
+
+            std::string line = data.substr(lineStart, lineEnd - lineStart);
+            const size_t commentPos = FindNotCited(line, '#');
+            if(commentPos != std::string::npos)
+            {
+                line.resize(commentPos);
+            }
+
+            if (line == "...")
+            {
+                return true;
+            }
+            else if (line == "---")
+            {
+                if (documentStartFound)
+                {
+                    return true;
+                }
+                documentStartFound = true;
+            }
+            return false;
+        }
+
+        /**
+        * @breif Move stream to position of data read by ReadLines, after end of document.
+        *
+        */
+        static void SeekStream(std::iostream & stream, const std::streampos & streamPos, const size_t position)
+        {
+            if (streamPos == std::streampos(-1))
+            {
+                return;
+            }
+
+            stream.clear();
+            stream.seekg(streamPos + static_cast<std::streamoff>(position));
+        }
+
         /**
         * @breif Run post-processing on all lines.
         *        Basically split lines into multiple lines if needed, to follow the parsing algorithm.
@@ -1552,27 +2114,78 @@ namespace Yaml
         }
 
         /**
-        * @breif Run post-processing and check for sequence.
-        *        Split line into two lines if sequence token is not on it's own line.
+        * @breif Run post-processing and check for flow collection.
+        *        Join following lines into current line if the collection spans multiple lines.
+        *        The collection itself is tokenized by ParseFlow.
         *
-        * @return true if line is sequence, else false.
+        * @return true if line is a flow collection, else false.
         *
         */
-        bool PostProcessSequenceLine(std::list<ReaderLine *>::iterator & it)
+        bool PostProcessFlowLine(std::list<ReaderLine *>::iterator & it)
         {
             ReaderLine * pLine = *it;
-
-            // Sequence split
-            if (IsSequenceStart(pLine->Data) == false)
+            if (IsFlowStart(pLine->Data) == false)
             {
                 return false;
             }
 
-            pLine->Type = Node::SequenceType;
+            pLine->Type = Node::ScalarType;
+            pLine->SetFlag(ReaderLine::FlowFlag);
+
+            size_t depth = 0;
+            char quote = 0;
+            bool escaped = false;
+            char lastToken = 0;
+            ScanFlowDepth(pLine->Data, depth, quote, escaped, lastToken);
+
+            ++it;
+            while (depth > 0)
+            {
+                if (it == m_Lines.end())
+                {
+                    throw ParsingException(ExceptionMessage(g_ErrorInvalidFlowCollection, *pLine));
+                }
+
+                ReaderLine * pNextLine = *it;
+                ScanFlowDepth(pNextLine->Data, depth, quote, escaped, lastToken);
+                pLine->Data += " ";
+                pLine->Segments.push_back({pLine->Data.size(), pNextLine->No, pNextLine->Offset});
+                pLine->Data += pNextLine->Data;
+
+                delete pNextLine;
+                it = m_Lines.erase(it);
+            }
+
+            ClearTrailingEmptyLines(it);
+            return true;
+        }
+
+        /**
+        * @breif Run post-processing and check for sequence.
+        *        Split line into two lines if sequence token is not on it's own line.
+        *
+        * @return true if line is sequence, else false.
+        *
+        */
+        bool PostProcessSequenceLine(std::list<ReaderLine *>::iterator & it)
+        {
+            ReaderLine * pLine = *it;
+
+            // Sequence split
+            if (IsSequenceStart(pLine->Data) == false)
+            {
+                return false;
+            }
+
+            pLine->Type = Node::SequenceType;
 
             ClearTrailingEmptyLines(++it);
 
-            const size_t valueStart = pLine->Data.find_first_not_of(" \t", 1);
+            size_t valueStart = pLine->Data.find_first_not_of(" \t", 1);
+            if (valueStart != std::string::npos)
+            {
+                valueStart = ExtractProperties(pLine, pLine->Data, valueStart);
+            }
             if (valueStart == std::string::npos)
             {
                 return true;
@@ -1597,6 +2210,12 @@ namespace Yaml
         {
             ReaderLine * pLine = *it;
 
+            // Flow collections are handled as scalars.
+            if (IsFlowStart(pLine->Data))
+            {
+                return false;
+            }
+
             // Find map key.
             size_t preKeyQuotes = 0;
             size_t tokenPos = FindNotCited(pLine->Data, ':', preKeyQuotes);
@@ -1639,6 +2258,10 @@ namespace Yaml
             {
                 valueStart = pLine->Data.find_first_not_of(" \t", tokenPos + 1);
                 if (valueStart != std::string::npos)
+                {
+                    valueStart = ExtractProperties(pLine, pLine->Data, valueStart);
+                }
+                if (valueStart != std::string::npos)
                 {
                     value = pLine->Data.substr(valueStart);
                 }
@@ -1694,6 +2317,11 @@ namespace Yaml
         */
         void PostProcessScalarLine(std::list<ReaderLine *>::iterator & it)
         {
+            if (PostProcessFlowLine(it) == true)
+            {
+                return;
+            }
+
             ReaderLine * pLine = *it;
             pLine->Type = Node::ScalarType;
 
@@ -1729,6 +2357,43 @@ namespace Yaml
             ClearTrailingEmptyLines(++lastNotEmpty);
         }
 
+        /**
+        * @breif Extract properties in front of sequence or map value, anchor("&name") and tag("!!type").
+        *        Properties are stored in line.
+        *
+        * @return Start position of value, after properties. std::string::npos if no value is left.
+        *
+        */
+        size_t ExtractProperties(ReaderLine * pLine, const std::string & data, size_t valueStart)
+        {
+            while (valueStart != std::string::npos && (data[valueStart] == '&' || data[valueStart] == '!'))
+            {
+                const size_t propertyEnd = data.find_first_of(" \t", valueStart);
+                const size_t propertySize = (propertyEnd == std::string::npos ? data.size() : propertyEnd) - valueStart;
+
+                if (data[valueStart] == '&')
+                {
+                    if (propertySize == 1)
+                    {
+                        throw ParsingException(ExceptionMessage(g_ErrorInvalidAnchor, *pLine, valueStart));
+                    }
+                    pLine->Anchor = data.substr(valueStart + 1, propertySize - 1);
+                }
+                else
+                {
+                    pLine->Tag = data.substr(valueStart, propertySize);
+                }
+
+                if (propertyEnd == std::string::npos)
+                {
+                    return std::string::npos;
+                }
+                valueStart = data.find_first_not_of(" \t", propertyEnd);
+            }
+
+            return valueStart;
+        }
+
         /**
         * @breif Process root node and start of document.
         *
@@ -1743,6 +2408,7 @@ namespace Yaml
             }
             Node::eType type = (*it)->Type;
             ReaderLine * pLine = *it;
+            RecordLocation(root, pLine);
 
             // Handle next line.
             switch(type)
@@ -1788,6 +2454,7 @@ namespace Yaml
 
                 // Handle value of map
                 Node::eType valueType = (*it)->Type;
+                RecordLocation(childNode, *it);
                 switch(valueType)
                 {
                 case Node::SequenceType:
@@ -1803,6 +2470,15 @@ namespace Yaml
                     break;
                 }
 
+                if(pLine->Tag.size())
+                {
+                    ApplyTag(childNode, pLine->Tag, pLine);
+                }
+                if(pLine->Anchor.size())
+                {
+                    m_Anchors[pLine->Anchor] = &childNode;
+                }
+
                 // Check next line. if sequence and correct level, go on, else exit.
                 // If same level but but of type map = error.
                 if(it == m_Lines.end() || ((pNextLine = *it)->Offset < pLine->Offset))
@@ -1828,10 +2504,15 @@ namespace Yaml
         void ParseMap(Node & node, std::list<ReaderLine *>::iterator & it)
         {
             ReaderLine * pNextLine = nullptr;
+            bool mergeKeyFound = false;
             while(it != m_Lines.end())
             {
                 ReaderLine * pLine = *it;
                 Node & childNode = node[pLine->Data];
+                if(pLine->Data == "<<")
+                {
+                    mergeKeyFound = true;
+                }
 
                 // Move to next line, error check.
                 ++it;
@@ -1842,6 +2523,7 @@ namespace Yaml
 
                 // Handle value of map
                 Node::eType valueType = (*it)->Type;
+                RecordLocation(childNode, *it);
                 switch(valueType)
                 {
                 case Node::SequenceType:
@@ -1857,6 +2539,15 @@ namespace Yaml
                     break;
                 }
 
+                if(pLine->Tag.size())
+                {
+                    ApplyTag(childNode, pLine->Tag, pLine);
+                }
+                if(pLine->Anchor.size())
+                {
+                    m_Anchors[pLine->Anchor] = &childNode;
+                }
+
                 // Check next line. if map and correct level, go on, else exit.
                 // if same level but but of type map = error.
                 if(it == m_Lines.end() || ((pNextLine = *it)->Offset < pLine->Offset))
@@ -1873,6 +2564,66 @@ namespace Yaml
                 }
 
             }
+
+            if(mergeKeyFound)
+            {
+                MergeKeys(node);
+            }
+        }
+
+        /**
+        * @breif Merge maps referenced by merge key("<<") into map node.
+        *        Explicit keys of node are not overridden. Merged values are shared, not copied.
+        *
+        */
+        void MergeKeys(Node & node)
+        {
+            MapImp * pMapImp = static_cast<MapImp*>(NODE_IMP_EXT(node)->m_pImp);
+            auto mergeIt = pMapImp->m_Map.find("<<");
+            Node * pMergeNode = mergeIt->second;
+
+            if(pMergeNode->IsMap())
+            {
+                MergeMap(pMapImp, *pMergeNode);
+            }
+            else if(pMergeNode->IsSequence())
+            {
+                for(auto it = pMergeNode->Begin(); it != pMergeNode->End(); it++)
+                {
+                    if((*it).second.IsMap() == false)
+                    {
+                        return;
+                    }
+                }
+                for(auto it = pMergeNode->Begin(); it != pMergeNode->End(); it++)
+                {
+                    MergeMap(pMapImp, (*it).second);
+                }
+            }
+            else
+            {
+                return;
+            }
+
+            // Merge node might be anchored, keep it alive until parsing is done.
+            pMapImp->m_Map.erase(mergeIt);
+            m_DetachedNodes.push_back(pMergeNode);
+        }
+
+        void MergeMap(MapImp * pMapImp, const Node & merge)
+        {
+            const MapImp * pMergeImp = static_cast<const MapImp*>(NODE_IMP_EXT(merge)->m_pImp);
+            for(auto it = pMergeImp->m_Map.begin(); it != pMergeImp->m_Map.end(); it++)
+            {
+                if(pMapImp->m_Map.find(it->first) != pMapImp->m_Map.end())
+                {
+                    continue;
+                }
+
+                Node * pNode = new Node;
+                NODE_IMP_EXT((*pNode))->Share(NODE_IMP_EXT((*it->second)));
+                pMapImp->m_Map.insert({it->first, pNode});
+            }
         }
 
         /**
@@ -1885,6 +2636,14 @@ namespace Yaml
             ReaderLine * pFirstLine = *it;
             ReaderLine * pLine = *it;
 
+            // Flow collection, tokenized in a single pass.
+            if(pLine->GetFlag(ReaderLine::FlowFlag))
+            {
+                ParseFlow(node, pLine);
+                ++it;
+                return;
+            }
+
             // Check if current line is a block scalar.
             unsigned char blockFlags = 0;
             bool isBlockScalar = IsBlockScalar(pLine->Data, pLine->No, blockFlags);
@@ -2025,207 +2784,816 @@ namespace Yaml
                 }
             }
 
-            if(data.size() && (data[0] == '"' || data[0] == '\''))
+            if(isBlockScalar == false && IsAlias(data))
+            {
+                auto anchorIt = m_Anchors.find(data.substr(1));
+                if(anchorIt == m_Anchors.end())
+                {
+                    throw ParsingException(ExceptionMessage(g_ErrorUnknownAlias, *pFirstLine));
+                }
+                NODE_IMP_EXT(node)->Share(NODE_IMP_EXT((*anchorIt->second)));
+                return;
+            }
+
+            const bool quoted = data.size() && (data[0] == '"' || data[0] == '\'');
+            if(quoted)
             {
                 data = data.substr(1, data.size() - 2 );
             }
 
             node = data;
+
+            ScalarImp * pScalarImp = static_cast<ScalarImp*>(NODE_IMP_EXT(node)->m_pImp);
+            pScalarImp->m_Quoted = quoted;
+            if(m_TypedScalars && isBlockScalar == false && quoted == false)
+            {
+                ParseScalarValue(pScalarImp->m_Value, pScalarImp->m_Native);
+            }
         }
 
         /**
-        * @breif Debug printing.
+        * @breif Apply tag to scalar node, by converting it to the tagged type.
+        *        Unknown tags and tags of sequences and maps are ignored.
         *
         */
-        void Print()
+        void ApplyTag(Node & node, const std::string & tag, ReaderLine * pLine)
         {
-            for (auto it = m_Lines.begin(); it != m_Lines.end(); it++)
+            if(node.IsScalar() == false)
             {
+                return;
+            }
 
-                ReaderLine * pLine = *it;
+            ScalarImp * pScalarImp = static_cast<ScalarImp*>(NODE_IMP_EXT(node)->m_pImp);
+            if(ParseTaggedScalarValue(pScalarImp->m_Value, tag, pScalarImp->m_Native) == false)
+            {
+                throw ParsingException(ExceptionMessage(g_ErrorInvalidTaggedValue, *pLine));
+            }
+            if(tag == "!!str" || tag == "!")
+            {
+                pScalarImp->m_Quoted = true;
+            }
+            else if(pScalarImp->m_Native.Type != impl::ScalarValue::NoneType)
+            {
+                pScalarImp->m_Quoted = false;
+            }
+        }
 
-                // Print type
-                if (pLine->Type == Node::SequenceType)
+        /**
+        * @breif Set plain scalar data of node, typed if enabled.
+        *
+        */
+        void SetPlainScalar(Node & node, const char * pData, const size_t size)
+        {
+            NodeImp * pNodeImp = NODE_IMP_EXT(node);
+            pNodeImp->InitScalar();
+            ScalarImp * pScalarImp = static_cast<ScalarImp*>(pNodeImp->m_pImp);
+            pScalarImp->m_Value.assign(pData, size);
+            pScalarImp->Reset();
+            if(m_TypedScalars)
+            {
+                ParseScalarValue(pScalarImp->m_Value, pScalarImp->m_Native);
+            }
+        }
+
+        /**
+        * @breif Process flow collection line, "[...]" or "{...}".
+        *        Nodes are created directly from the line data, without splitting it into lines.
+        *
+        */
+        void ParseFlow(Node & node, ReaderLine * pLine)
+        {
+            const char * pCur = pLine->Data.c_str();
+            const char * pEnd = pCur + pLine->Data.size();
+
+            m_FlowDepth = 0;
+            ParseFlowValue(node, pCur, pEnd, pLine);
+
+            SkipFlowSpaces(pCur, pEnd);
+            if(pCur != pEnd)
+            {
+                ThrowFlowError(pCur, pLine);
+            }
+        }
+
+        void ParseFlowValue(Node & node, const char * & pCur, const char * pEnd, ReaderLine * pLine)
+        {
+            SkipFlowSpaces(pCur, pEnd);
+            if(pCur == pEnd)
+            {
+                ThrowFlowError(pCur, pLine);
+            }
+
+            // Properties, anchor and tag.
+            const char * pAnchor = nullptr;
+            size_t anchorSize = 0;
+            const char * pTag = nullptr;
+            size_t tagSize = 0;
+            while(*pCur == '&' || *pCur == '!')
+            {
+                const char * pProperty = pCur;
+                const size_t propertySize = FindFlowNameEnd(pCur, pEnd) - pProperty;
+                if(*pProperty == '&')
                 {
-                    std::cout << "seq ";
+                    if(propertySize == 1)
+                    {
+                        throw ParsingException(ExceptionMessage(g_ErrorInvalidAnchor, *pLine, pLine->Offset + (pCur - pLine->Data.c_str())));
+                    }
+                    pAnchor = pProperty + 1;
+                    anchorSize = propertySize - 1;
                 }
-                else if (pLine->Type == Node::MapType)
+                else
                 {
-                    std::cout << "map ";
+                    pTag = pProperty;
+                    tagSize = propertySize;
                 }
-                else if (pLine->Type == Node::ScalarType)
+
+                pCur += propertySize;
+                SkipFlowSpaces(pCur, pEnd);
+                if(pCur == pEnd)
                 {
-                    std::cout << "sca ";
+                    ThrowFlowError(pCur, pLine);
                 }
-                else
+            }
+
+            RecordLocation(node, pLine, pCur);
+
+            switch(*pCur)
+            {
+            case '[':
+                ParseFlowSequence(node, pCur, pEnd, pLine);
+                break;
+            case '{':
+                ParseFlowMap(node, pCur, pEnd, pLine);
+                break;
+            case '*':
+            {
+                const char * pAlias = ++pCur;
+                pCur = FindFlowNameEnd(pCur, pEnd);
+                auto anchorIt = m_Anchors.find(std::string(pAlias, pCur - pAlias));
+                if(anchorIt == m_Anchors.end())
                 {
-                    std::cout << "    ";
+                    throw ParsingException(ExceptionMessage(g_ErrorUnknownAlias, *pLine, pLine->Offset + (pAlias - pLine->Data.c_str())));
                 }
+                NODE_IMP_EXT(node)->Share(NODE_IMP_EXT((*anchorIt->second)));
+            }
+            break;
+            case '"':
+            case '\'':
+            {
+                NodeImp * pNodeImp = NODE_IMP_EXT(node);
+                pNodeImp->InitScalar();
+                ScalarImp * pScalarImp = static_cast<ScalarImp*>(pNodeImp->m_pImp);
+                ParseFlowQuoted(pScalarImp->m_Value, pCur, pEnd, pLine);
+                pScalarImp->Reset();
+                pScalarImp->m_Quoted = true;
+            }
+            break;
+            default:
+            {
+                const char * pStart = pCur;
+                const size_t size = ParseFlowPlain(pCur, pEnd, pLine);
+                SetPlainScalar(node, pStart, size);
+            }
+            break;
+            }
 
-                // Print flags
-                if (pLine->GetFlag(ReaderLine::FoldedScalarFlag))
+            if(pTag)
+            {
+                ApplyTag(node, std::string(pTag, tagSize), pLine);
+            }
+            if(pAnchor)
+            {
+                m_Anchors[std::string(pAnchor, anchorSize)] = &node;
+            }
+        }
+
+        void ParseFlowSequence(Node & node, const char * & pCur, const char * pEnd, ReaderLine * pLine)
+        {
+            NodeImp * pNodeImp = NODE_IMP_EXT(node);
+            pNodeImp->InitSequence();
+            SequenceImp * pSequenceImp = static_cast<SequenceImp*>(pNodeImp->m_pImp);
+
+            EnterFlowCollection(pCur, pLine);
+            ++pCur;
+            while(true)
+            {
+                SkipFlowSpaces(pCur, pEnd);
+                if(pCur == pEnd)
                 {
-                    std::cout << "f";
+                    ThrowFlowError(pCur, pLine);
                 }
-                else
+                if(*pCur == ']')
                 {
-                    std::cout << "-";
+                    ++pCur;
+                    --m_FlowDepth;
+                    return;
                 }
-                if (pLine->GetFlag(ReaderLine::LiteralScalarFlag))
+
+                Node * pNode = pSequenceImp->PushBack();
+
+                // Fast path of plain scalars, appended without any temporary data.
+                switch(*pCur)
                 {
-                    std::cout << "l";
-                }
-                else
+                case '[':
+                case '{':
+                case '&':
+                case '!':
+                case '*':
+                case '"':
+                case '\'':
+                    ParseFlowValue(*pNode, pCur, pEnd, pLine);
+                    break;
+                default:
                 {
-                    std::cout << "-";
+                    RecordLocation(*pNode, pLine, pCur);
+                    const char * pStart = pCur;
+                    const size_t size = ParseFlowPlain(pCur, pEnd, pLine);
+                    SetPlainScalar(*pNode, pStart, size);
                 }
-                if (pLine->GetFlag(ReaderLine::ScalarNewlineFlag))
-                {
-                    std::cout << "n";
+                break;
                 }
-                else
+
+                SkipFlowSpaces(pCur, pEnd);
+
+                // Single pair map, "[key: value]".
+                if(pCur != pEnd && *pCur == ':' && pNode->IsScalar())
                 {
-                    std::cout << "-";
+                    const std::string key = pNode->As<std::string>();
+                    pNode->Clear();
+                    Node & value = (*pNode)[key];
+                    ParseFlowMapValue(value, pCur, pEnd, pLine);
+                    SkipFlowSpaces(pCur, pEnd);
                 }
-                if (pLine->NextLine == nullptr)
+
+                if(pCur == pEnd || (*pCur != ',' && *pCur != ']'))
                 {
-                    std::cout << "e";
+                    ThrowFlowError(pCur, pLine);
                 }
-                else
+                if(*pCur == ',')
                 {
-                    std::cout << "-";
+                    ++pCur;
                 }
+            }
+        }
 
+        void ParseFlowMap(Node & node, const char * & pCur, const char * pEnd, ReaderLine * pLine)
+        {
+            NodeImp * pNodeImp = NODE_IMP_EXT(node);
+            pNodeImp->InitMap();
 
-                std::cout << "| ";
-                std::cout << pLine->No << " ";
-                std::cout << std::string(pLine->Offset, ' ');
+            bool mergeKeyFound = false;
+            std::string key;
 
-                if (pLine->Type == Node::ScalarType)
+            EnterFlowCollection(pCur, pLine);
+            ++pCur;
+            while(true)
+            {
+                SkipFlowSpaces(pCur, pEnd);
+                if(pCur == pEnd)
                 {
-                    std::string scalarValue = pLine->Data;
-                    for (size_t i = 0; (i = scalarValue.find("\n", i)) != std::string::npos;)
-                    {
-                        scalarValue.replace(i, 1, "\\n");
-                        i += 2;
-                    }
-                    std::cout << scalarValue << std::endl;
+                    ThrowFlowError(pCur, pLine);
                 }
-                else if (pLine->Type == Node::MapType)
+                if(*pCur == '}')
                 {
-                    std::cout << pLine->Data + ":" << std::endl;
+                    ++pCur;
+                    break;
                 }
-                else if (pLine->Type == Node::SequenceType)
+
+                // Key
+                if(*pCur == '"' || *pCur == '\'')
                 {
-                    std::cout << "-" << std::endl;
+                    ParseFlowQuoted(key, pCur, pEnd, pLine);
                 }
                 else
                 {
-                    std::cout << "> UNKOWN TYPE <" << std::endl;
+                    const char * pStart = pCur;
+                    const size_t size = ParseFlowPlain(pCur, pEnd, pLine);
+                    key.assign(pStart, size);
+                    if(key == "<<")
+                    {
+                        mergeKeyFound = true;
+                    }
                 }
-            }
-        }
 
-        /**
-        * @breif Clear all read lines.
+                Node & value = node[key];
+
+                // Value
+                SkipFlowSpaces(pCur, pEnd);
+                if(pCur != pEnd && *pCur == ':')
+                {
+                    ParseFlowMapValue(value, pCur, pEnd, pLine);
+                    SkipFlowSpaces(pCur, pEnd);
+                }
+                else
+                {
+                    value = "";
+                }
+
+                if(pCur == pEnd || (*pCur != ',' && *pCur != '}'))
+                {
+                    ThrowFlowError(pCur, pLine);
+                }
+                if(*pCur == ',')
+                {
+                    ++pCur;
+                }
+            }
+
+            if(mergeKeyFound)
+            {
+                MergeKeys(node);
+            }
+            --m_FlowDepth;
+        }
+
+        /**
+        * @breif Increment nesting depth of flow collections, limited to avoid stack overflow.
         *
         */
-        void ClearLines()
+        void EnterFlowCollection(const char * pCur, ReaderLine * pLine)
         {
-            for (auto it = m_Lines.begin(); it != m_Lines.end(); it++)
+            if(++m_FlowDepth > g_MaxFlowDepth)
             {
-                delete *it;
+                throw ParsingException(ExceptionMessage(g_ErrorFlowDepth, *pLine, pLine->Offset + (pCur - pLine->Data.c_str())));
             }
-            m_Lines.clear();
         }
 
-        void ClearTrailingEmptyLines(std::list<ReaderLine *>::iterator & it)
+        void ParseFlowMapValue(Node & node, const char * & pCur, const char * pEnd, ReaderLine * pLine)
         {
-            while(it != m_Lines.end())
+            ++pCur;
+            SkipFlowSpaces(pCur, pEnd);
+            if(pCur == pEnd || *pCur == ',' || *pCur == '}' || *pCur == ']')
             {
-                ReaderLine * pLine = *it;
-                if(pLine->Data.size() == 0)
+                node = "";
+                return;
+            }
+
+            ParseFlowValue(node, pCur, pEnd, pLine);
+        }
+
+        /**
+        * @breif Find end of plain flow scalar and move cursor to it.
+        *
+        * @return Size of scalar, trailing spaces excluded.
+        *
+        */
+        size_t ParseFlowPlain(const char * & pCur, const char * pEnd, ReaderLine * pLine)
+        {
+            const char * pStart = pCur;
+            const char * pLast = pCur;
+
+            while(pCur != pEnd)
+            {
+                const char c = *pCur;
+                if(c == ',' || c == '[' || c == ']' || c == '{' || c == '}')
                 {
-                    delete *it;
-                    it = m_Lines.erase(it);
+                    break;
                 }
-                else
+                if(c == ':' && (pCur + 1 == pEnd || pCur[1] == ' ' || pCur[1] == '\t' ||
+                   pCur[1] == ',' || pCur[1] == ']' || pCur[1] == '}'))
                 {
-                    return;
+                    break;
+                }
+                ++pCur;
+                if(c != ' ' && c != '\t')
+                {
+                    pLast = pCur;
                 }
+            }
 
+            if(pLast == pStart)
+            {
+                ThrowFlowError(pStart, pLine);
             }
+
+            return pLast - pStart;
         }
 
-        static bool IsSequenceStart(const std::string & data)
+        /**
+        * @breif Parse escape sequence of double quoted scalar, following the backslash.
+        *        Unknown escape sequences result in the escaped character.
+        *
+        */
+        static void ParseFlowEscape(std::string & value, const char * & pCur, const char * pEnd)
         {
-            if (data.size() == 0 || data[0] != '-')
+            const char c = *pCur++;
+            size_t digits = 0;
+            switch(c)
             {
-                return false;
+            case 'n':
+                value += '\n';
+                return;
+            case 't':
+                value += '\t';
+                return;
+            case 'r':
+                value += '\r';
+                return;
+            case '0':
+                value += '\0';
+                return;
+            case 'x':
+                digits = 2;
+                break;
+            case 'u':
+                digits = 4;
+                break;
+            default:
+                value += c;
+                return;
             }
 
-            if (data.size() >= 2 && data[1] != ' ')
+            uint32_t code = 0;
+            for(size_t i = 0; i < digits; i++)
             {
-                return false;
+                const char digit = pCur != pEnd ? *pCur : '\0';
+                const char * pHex = std::strchr("0123456789abcdef", digit >= 'A' && digit <= 'F' ? digit - 'A' + 'a' : digit);
+                if(digit == '\0' || pHex == nullptr)
+                {
+                    value += c;
+                    return;
+                }
+                ++pCur;
+                code = (code << 4) | static_cast<uint32_t>(pHex - "0123456789abcdef");
             }
 
-            return true;
+            // UTF-8 encoding of code point.
+            if(code < 0x80)
+            {
+                value += static_cast<char>(code);
+            }
+            else if(code < 0x800)
+            {
+                value += static_cast<char>(0xC0 | (code >> 6));
+                value += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else
+            {
+                value += static_cast<char>(0xE0 | (code >> 12));
+                value += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                value += static_cast<char>(0x80 | (code & 0x3F));
+            }
         }
 
-        static bool IsBlockScalar(const std::string & data, const size_t line, unsigned char & flags)
+        void ParseFlowQuoted(std::string & value, const char * & pCur, const char * pEnd, ReaderLine * pLine)
         {
-            flags = 0;
-            if(data.size() == 0)
-            {
-                return false;
-            }
+            const char quote = *pCur;
+            const char * pStart = pCur++;
 
-            if(data[0] == '|')
+            value.clear();
+            while(pCur != pEnd)
             {
-                if(data.size() >= 2)
+                const char c = *pCur++;
+                if(c == quote)
                 {
-                    if(data[1] != '-' && data[1] != ' ' && data[1] != '\t')
+                    // Escaped single quote, ''.
+                    if(quote == '\'' && pCur != pEnd && *pCur == '\'')
                     {
-                        throw ParsingException(ExceptionMessage(g_ErrorInvalidBlockScalar, line, data));
+                        value += '\'';
+                        ++pCur;
+                        continue;
                     }
+                    return;
                 }
-                else
+                if(c == '\\' && quote == '"' && pCur != pEnd)
                 {
-                    flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::ScalarNewlineFlag)];
+                    ParseFlowEscape(value, pCur, pEnd);
+                    continue;
                 }
-                flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::LiteralScalarFlag)];
-                return true;
+                value += c;
             }
 
-            if(data[0] == '>')
+            throw ParsingException(ExceptionMessage(g_ErrorInvalidQuote, *pLine, pLine->Offset + (pStart - pLine->Data.c_str())));
+        }
+
+        static const char * FindFlowNameEnd(const char * pCur, const char * pEnd)
+        {
+            while(pCur != pEnd && *pCur != ' ' && *pCur != '\t' && *pCur != ',' &&
+                  *pCur != '[' && *pCur != ']' && *pCur != '{' && *pCur != '}')
             {
-                if(data.size() >= 2)
+                ++pCur;
+            }
+            return pCur;
+        }
+
+        static void SkipFlowSpaces(const char * & pCur, const char * pEnd)
+        {
+            while(pCur != pEnd && (*pCur == ' ' || *pCur == '\t'))
+            {
+                ++pCur;
+            }
+        }
+
+        static void ThrowFlowError(const char * pCur, ReaderLine * pLine)
+        {
+            throw ParsingException(ExceptionMessage(g_ErrorInvalidFlowCollection, *pLine, pLine->Offset + (pCur - pLine->Data.c_str())));
+        }
+
+        /**
+        * @breif Record location of node, if enabled.
+        *
+        */
+        void RecordLocation(const Node & node, const ReaderLine * pLine)
+        {
+            if(m_pLocations)
+            {
+                (*m_pLocations)[&node] = Location(pLine->No, pLine->Offset + 1);
+                NODE_IMP_EXT(node)->m_LocationId = m_LocationId;
+            }
+        }
+
+        void RecordLocation(const Node & node, const ReaderLine * pLine, const char * pCur)
+        {
+            if(m_pLocations == nullptr)
+            {
+                return;
+            }
+
+            size_t position = pCur - pLine->Data.c_str();
+            size_t no = pLine->No;
+            size_t offset = pLine->Offset;
+            for(auto it = pLine->Segments.rbegin(); it != pLine->Segments.rend(); it++)
+            {
+                if(position >= it->Position)
                 {
-                    if(data[1] != '-' && data[1] != ' ' && data[1] != '\t')
+                    position -= it->Position;
+                    no = it->No;
+                    offset = it->Offset;
+                    break;
+                }
+            }
+
+            (*m_pLocations)[&node] = Location(no, offset + position + 1);
+            NODE_IMP_EXT(node)->m_LocationId = m_LocationId;
+        }
+
+        /**
+        * @breif Debug printing.
+        *
+        */
+        void Print()
+        {
+            for (auto it = m_Lines.begin(); it != m_Lines.end(); it++)
+            {
+
+                ReaderLine * pLine = *it;
+
+                // Print type
+                if (pLine->Type == Node::SequenceType)
+                {
+                    std::cout << "seq ";
+                }
+                else if (pLine->Type == Node::MapType)
+                {
+                    std::cout << "map ";
+                }
+                else if (pLine->Type == Node::ScalarType)
+                {
+                    std::cout << "sca ";
+                }
+                else
+                {
+                    std::cout << "    ";
+                }
+
+                // Print flags
+                if (pLine->GetFlag(ReaderLine::FoldedScalarFlag))
+                {
+                    std::cout << "f";
+                }
+                else
+                {
+                    std::cout << "-";
+                }
+                if (pLine->GetFlag(ReaderLine::LiteralScalarFlag))
+                {
+                    std::cout << "l";
+                }
+                else
+                {
+                    std::cout << "-";
+                }
+                if (pLine->GetFlag(ReaderLine::ScalarNewlineFlag))
+                {
+                    std::cout << "n";
+                }
+                else
+                {
+                    std::cout << "-";
+                }
+                if (pLine->NextLine == nullptr)
+                {
+                    std::cout << "e";
+                }
+                else
+                {
+                    std::cout << "-";
+                }
+
+
+                std::cout << "| ";
+                std::cout << pLine->No << " ";
+                std::cout << std::string(pLine->Offset, ' ');
+
+                if (pLine->Type == Node::ScalarType)
+                {
+                    std::string scalarValue = pLine->Data;
+                    for (size_t i = 0; (i = scalarValue.find("\n", i)) != std::string::npos;)
                     {
-                        throw ParsingException(ExceptionMessage(g_ErrorInvalidBlockScalar, line, data));
+                        scalarValue.replace(i, 1, "\\n");
+                        i += 2;
                     }
+                    std::cout << scalarValue << std::endl;
+                }
+                else if (pLine->Type == Node::MapType)
+                {
+                    std::cout << pLine->Data + ":" << std::endl;
+                }
+                else if (pLine->Type == Node::SequenceType)
+                {
+                    std::cout << "-" << std::endl;
                 }
                 else
                 {
-                    flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::ScalarNewlineFlag)];
+                    std::cout << "> UNKOWN TYPE <" << std::endl;
                 }
-                flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::FoldedScalarFlag)];
-                return true;
             }
+        }
 
-            return false;
+        /**
+        * @breif Clear all read lines.
+        *
+        */
+        void ClearLines()
+        {
+            for (auto it = m_Lines.begin(); it != m_Lines.end(); it++)
+            {
+                delete *it;
+            }
+            m_Lines.clear();
         }
 
-        std::list<ReaderLine *> m_Lines;    ///< List of lines.
+        void ClearTrailingEmptyLines(std::list<ReaderLine *>::iterator & it)
+        {
+            while(it != m_Lines.end())
+            {
+                ReaderLine * pLine = *it;
+                if(pLine->Data.size() == 0)
+                {
+                    delete *it;
+                    it = m_Lines.erase(it);
+                }
+                else
+                {
+                    return;
+                }
 
-    };
+            }
+        }
 
-    // Parsing functions
-    void Parse(Node & root, const char * filename)
-    {
-        std::ifstream f(filename, std::ifstream::binary);
-        if (f.is_open() == false)
+        static bool IsSequenceStart(const std::string & data)
+        {
+            if (data.size() == 0 || data[0] != '-')
+            {
+                return false;
+            }
+
+            if (data.size() >= 2 && data[1] != ' ')
+            {
+                return false;
+            }
+
+            return true;
+        }
+
+        /**
+        * @breif Update nesting depth of flow collection, by scanning next line of collection.
+        *        Quote state, escape state and last found token are carried between lines.
+        *
+        */
+        static void ScanFlowDepth(const std::string & data, size_t & depth, char & quote, bool & escaped, char & lastToken)
+        {
+            for (size_t i = 0; i < data.size(); i++)
+            {
+                const char c = data[i];
+                if (quote)
+                {
+                    if (escaped)
+                    {
+                        escaped = false;
+                    }
+                    else if (c == '\\' && quote == '"')
+                    {
+                        escaped = true;
+                    }
+                    else if (c == quote)
+                    {
+                        quote = 0;
+                    }
+                    continue;
+                }
+
+                switch (c)
+                {
+                case '[':
+                case '{':
+                    depth++;
+                    break;
+                case ']':
+                case '}':
+                    if (depth)
+                    {
+                        depth--;
+                    }
+                    break;
+                case '"':
+                case '\'':
+                    if (lastToken == '[' || lastToken == '{' || lastToken == ',' || lastToken == ':')
+                    {
+                        quote = c;
+                    }
+                    break;
+                case ' ':
+                case '\t':
+                    continue;
+                default:
+                    break;
+                }
+
+                lastToken = c;
+            }
+        }
+
+        static bool IsFlowStart(const std::string & data)
+        {
+            return data.size() && (data[0] == '[' || data[0] == '{');
+        }
+
+        static bool IsAlias(const std::string & data)
+        {
+            return data.size() >= 2 && data[0] == '*' && data.find_first_of(" \t") == std::string::npos;
+        }
+
+        static bool IsBlockScalar(const std::string & data, const size_t line, unsigned char & flags)
+        {
+            flags = 0;
+            if(data.size() == 0)
+            {
+                return false;
+            }
+
+            if(data[0] == '|')
+            {
+                if(data.size() >= 2)
+                {
+                    if(data[1] != '-' && data[1] != ' ' && data[1] != '\t')
+                    {
+                        throw ParsingException(ExceptionMessage(g_ErrorInvalidBlockScalar, line, data));
+                    }
+                }
+                else
+                {
+                    flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::ScalarNewlineFlag)];
+                }
+                flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::LiteralScalarFlag)];
+                return true;
+            }
+
+            if(data[0] == '>')
+            {
+                if(data.size() >= 2)
+                {
+                    if(data[1] != '-' && data[1] != ' ' && data[1] != '\t')
+                    {
+                        throw ParsingException(ExceptionMessage(g_ErrorInvalidBlockScalar, line, data));
+                    }
+                }
+                else
+                {
+                    flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::ScalarNewlineFlag)];
+                }
+                flags |= ReaderLine::FlagMask[static_cast<size_t>(ReaderLine::FoldedScalarFlag)];
+                return true;
+            }
+
+            return false;
+        }
+
+        std::list<ReaderLine *> m_Lines;    ///< List of lines.
+        std::unordered_map<std::string, Node *> m_Anchors; ///< Anchored nodes, by anchor name.
+        std::vector<Node *> m_DetachedNodes; ///< Nodes removed from tree while parsing, deleted at destruction.
+        bool m_TypedScalars;                ///< Detect natively typed values of plain scalars.
+        LocationTable * m_pLocations;       ///< Location table of parsed nodes, nullptr if not recorded.
+        uint32_t        m_LocationId;       ///< Id tagged to nodes with recorded location.
+        size_t m_FlowDepth;                 ///< Nesting depth of currently parsed flow collection.
+
+    };
+
+    // Parsing functions
+    void Parse(Node & root, const char * filename)
+    {
+        std::ifstream f(filename, std::ifstream::binary);
+        if (f.is_open() == false)
         {
             throw OperationException(g_ErrorCannotOpenFile);
         }
@@ -2245,528 +3613,4976 @@ namespace Yaml
     {
         ParseImp * pImp = nullptr;
 
-        try
+        try
+        {
+            pImp = new ParseImp;
+            pImp->Parse(root, stream);
+            delete pImp;
+        }
+        catch (const Exception e)
+        {
+            delete pImp;
+            throw;
+        }
+    }
+
+    void Parse(Node & root, const std::string & string)
+    {
+        std::stringstream ss(string);
+        Parse(root, ss);
+    }
+
+    void Parse(Node & root, const char * buffer, const size_t size)
+    {
+        std::stringstream ss(std::string(buffer, size));
+        Parse(root, ss);
+    }
+
+
+    // Parsing functions of documents.
+    void Parse(Document & document, const char * filename, const ParseConfig & config)
+    {
+        std::ifstream f(filename, std::ifstream::binary);
+        if (f.is_open() == false)
+        {
+            throw OperationException(g_ErrorCannotOpenFile);
+        }
+
+        f.seekg(0, f.end);
+        const std::streamoff end = f.tellg();
+        f.seekg(0, f.beg);
+
+        // Size is unknown, or file is not readable, such as directories.
+        if (end < 0 || (end > 0 && f.peek() == std::ifstream::traits_type::eof()))
+        {
+            throw OperationException(g_ErrorCannotOpenFile);
+        }
+
+        std::unique_ptr<char[]> data(new char[end ? static_cast<size_t>(end) : 1]);
+        f.read(data.get(), end);
+        const size_t fileSize = static_cast<size_t>(f.gcount());
+        f.close();
+
+        Parse(document, data.get(), fileSize, config);
+    }
+
+    void Parse(Document & document, std::iostream & stream, const ParseConfig & config)
+    {
+        DocumentImp * pDocumentImp = static_cast<DocumentImp*>(document.m_pImp);
+        const uint32_t locationId = pDocumentImp->ResetLocations();
+
+        ParseImp * pImp = nullptr;
+
+        try
+        {
+            pImp = new ParseImp(config.TypedScalars, config.SourceLocations ? &pDocumentImp->m_Locations : nullptr, locationId);
+            pImp->Parse(document.Root(), stream);
+            delete pImp;
+        }
+        catch (const Exception &)
+        {
+            delete pImp;
+            throw;
+        }
+    }
+
+    void Parse(Document & document, const std::string & string, const ParseConfig & config)
+    {
+        std::stringstream ss(string);
+        Parse(document, ss, config);
+    }
+
+    void Parse(Document & document, const char * buffer, const size_t size, const ParseConfig & config)
+    {
+        std::stringstream ss(std::string(buffer, size));
+        Parse(document, ss, config);
+    }
+
+
+    // Document cache implementations.
+    /**
+    * @breif Identity of file, compared before rereading it.
+    *
+    */
+    struct FileIdentity
+    {
+        FileIdentity() :
+            Device(0),
+            Inode(0),
+            ModifiedTime(0),
+            Size(0)
+        {
+        }
+
+        bool operator == (const FileIdentity & identity) const
+        {
+            return Device == identity.Device && Inode == identity.Inode &&
+                   ModifiedTime == identity.ModifiedTime && Size == identity.Size;
+        }
+
+        uint64_t Device;        ///< Device of file.
+        uint64_t Inode;         ///< Inode of file.
+        int64_t  ModifiedTime;  ///< Modification time, in nanoseconds if available.
+        uint64_t Size;          ///< Size of file.
+    };
+
+    /**
+    * @breif Get identity of file.
+    *
+    * @return false if file cannot be stat'ed or is not a regular file.
+    *
+    */
+    static bool GetFileIdentity(const char * filename, FileIdentity & identity)
+    {
+    #if defined(_WIN32)
+        struct _stat64 status;
+        if(_stat64(filename, &status) != 0 || (status.st_mode & _S_IFMT) != _S_IFREG)
+        {
+            return false;
+        }
+        identity.ModifiedTime = static_cast<int64_t>(status.st_mtime) * 1000000000;
+    #else
+        struct stat status;
+        if(stat(filename, &status) != 0 || S_ISREG(status.st_mode) == false)
+        {
+            return false;
+        }
+        #if defined(__APPLE__)
+            identity.ModifiedTime = static_cast<int64_t>(status.st_mtimespec.tv_sec) * 1000000000 + status.st_mtimespec.tv_nsec;
+        #else
+            identity.ModifiedTime = static_cast<int64_t>(status.st_mtim.tv_sec) * 1000000000 + status.st_mtim.tv_nsec;
+        #endif
+    #endif
+        identity.Device = static_cast<uint64_t>(status.st_dev);
+        identity.Inode = static_cast<uint64_t>(status.st_ino);
+        identity.Size = static_cast<uint64_t>(status.st_size);
+        return true;
+    }
+
+    class DocumentCacheImp
+    {
+
+    public:
+
+        typedef std::shared_ptr<const Document> DocumentPtr;
+
+        /**
+        * @breif Cache entry. Loading entries have a future, waited for by concurrent callers.
+        *
+        */
+        struct Entry
+        {
+            Entry() :
+                Loading(false),
+                Hash(0),
+                Memory(0)
+            {
+            }
+
+            bool                                Loading;    ///< Document is being loaded.
+            std::shared_future<DocumentPtr>     Future;     ///< Result of loading document.
+            DocumentPtr                         pDocument;  ///< Loaded document.
+            FileIdentity                        Identity;   ///< Identity of file when loaded.
+            uint64_t                            Hash;       ///< Content hash of file.
+            size_t                              Memory;     ///< Estimated memory usage of document.
+            std::list<std::string>::iterator    Lru;        ///< Position in LRU list, if loaded.
+        };
+
+        DocumentCacheImp(const size_t memoryBudget, const ParseConfig & config) :
+            m_MemoryBudget(memoryBudget),
+            m_Config(config),
+            m_Memory(0),
+            m_Hits(0),
+            m_Parses(0)
+        {
+        }
+
+        DocumentPtr Get(const char * filename)
+        {
+            if(filename == nullptr)
+            {
+                throw OperationException(g_ErrorCannotOpenFile);
+            }
+            const std::string key(filename);
+            FileIdentity identity;
+            const bool exists = GetFileIdentity(filename, identity);
+
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            auto it = m_Entries.find(key);
+            if(it != m_Entries.end())
+            {
+                Entry & entry = it->second;
+                if(entry.Loading)
+                {
+                    // Single flight, wait for the loading caller.
+                    std::shared_future<DocumentPtr> future = entry.Future;
+                    m_Hits++;
+                    lock.unlock();
+                    return future.get();
+                }
+                if(exists && entry.Identity == identity)
+                {
+                    m_Lru.splice(m_Lru.begin(), m_Lru, entry.Lru);
+                    m_Hits++;
+                    return entry.pDocument;
+                }
+            }
+            if(exists == false)
+            {
+                if(it != m_Entries.end())
+                {
+                    Remove(it);
+                }
+                throw OperationException(g_ErrorCannotOpenFile);
+            }
+
+            // Mark entry as loading, keeping previous document for comparing content hash.
+            DocumentPtr pPrevious;
+            uint64_t previousHash = 0;
+            if(it != m_Entries.end())
+            {
+                pPrevious = it->second.pDocument;
+                previousHash = it->second.Hash;
+                Remove(it);
+            }
+            std::promise<DocumentPtr> promise;
+            Entry & entry = m_Entries[key];
+            entry.Loading = true;
+            entry.Future = promise.get_future().share();
+            lock.unlock();
+
+            try
+            {
+                Entry loaded;
+                loaded.Identity = identity;
+                Load(filename, pPrevious, previousHash, loaded);
+
+                lock.lock();
+                auto loadedIt = m_Entries.find(key);
+                if(loaded.Memory <= m_MemoryBudget && loadedIt != m_Entries.end())
+                {
+                    Entry & current = loadedIt->second;
+                    current.Loading = false;
+                    current.Future = std::shared_future<DocumentPtr>();
+                    current.pDocument = loaded.pDocument;
+                    current.Identity = loaded.Identity;
+                    current.Hash = loaded.Hash;
+                    current.Memory = loaded.Memory;
+                    m_Lru.push_front(key);
+                    current.Lru = m_Lru.begin();
+                    m_Memory += loaded.Memory;
+                    Evict();
+                }
+                else if(loadedIt != m_Entries.end())
+                {
+                    // Larger than budget, not cached.
+                    m_Entries.erase(loadedIt);
+                }
+                lock.unlock();
+
+                promise.set_value(loaded.pDocument);
+                return loaded.pDocument;
+            }
+            catch(...)
+            {
+                if(lock.owns_lock() == false)
+                {
+                    lock.lock();
+                }
+                auto loadedIt = m_Entries.find(key);
+                if(loadedIt != m_Entries.end() && loadedIt->second.Loading)
+                {
+                    m_Entries.erase(loadedIt);
+                }
+                lock.unlock();
+                promise.set_exception(std::current_exception());
+                throw;
+            }
+        }
+
+        void Erase(const char * filename)
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            auto it = m_Entries.find(filename);
+            if(it != m_Entries.end() && it->second.Loading == false)
+            {
+                Remove(it);
+            }
+        }
+
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            for(auto it = m_Entries.begin(); it != m_Entries.end();)
+            {
+                if(it->second.Loading)
+                {
+                    ++it;
+                    continue;
+                }
+                m_Lru.erase(it->second.Lru);
+                m_Memory -= it->second.Memory;
+                it = m_Entries.erase(it);
+            }
+        }
+
+        size_t Size() const
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Lru.size();
+        }
+
+        size_t MemoryUsage() const
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Memory;
+        }
+
+        size_t Hits() const
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Hits;
+        }
+
+        size_t Parses() const
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            return m_Parses;
+        }
+
+    private:
+
+        /**
+        * @breif Read file, reusing previous document if content hash matches, else parse it.
+        *        Called without holding the mutex.
+        *
+        */
+        void Load(const char * filename, const DocumentPtr & pPrevious, const uint64_t previousHash, Entry & entry)
+        {
+            std::ifstream f(filename, std::ifstream::binary);
+            if(f.is_open() == false)
+            {
+                throw OperationException(g_ErrorCannotOpenFile);
+            }
+            f.seekg(0, f.end);
+            const std::streamoff end = f.tellg();
+            if(end < 0)
+            {
+                throw OperationException(g_ErrorCannotOpenFile);
+            }
+            f.seekg(0, f.beg);
+            std::unique_ptr<char[]> data(new char[end ? static_cast<size_t>(end) : 1]);
+            f.read(data.get(), end);
+
+            // File may shrink after being stat'ed, only read data is used.
+            const size_t fileSize = static_cast<size_t>(f.gcount());
+            f.close();
+
+            entry.Hash = ContentHash(data.get(), fileSize);
+            if(pPrevious && entry.Hash == previousHash)
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Hits++;
+                entry.pDocument = pPrevious;
+                entry.Memory = EstimateMemory(pPrevious->Root());
+                return;
+            }
+
+            std::shared_ptr<Document> pDocument(new Document);
+            Parse(*pDocument, data.get(), fileSize, m_Config);
+            entry.pDocument = pDocument;
+            entry.Memory = EstimateMemory(pDocument->Root());
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Parses++;
+        }
+
+        /**
+        * @breif Remove loaded entry. Requires the mutex.
+        *
+        */
+        void Remove(std::unordered_map<std::string, Entry>::iterator it)
+        {
+            m_Lru.erase(it->second.Lru);
+            m_Memory -= it->second.Memory;
+            m_Entries.erase(it);
+        }
+
+        /**
+        * @breif Evict least recently used entries until memory usage is within budget. Requires the mutex.
+        *
+        */
+        void Evict()
+        {
+            while(m_Memory > m_MemoryBudget && m_Lru.size())
+            {
+                Remove(m_Entries.find(m_Lru.back()));
+            }
+        }
+
+        const size_t                            m_MemoryBudget; ///< Maximum estimated memory usage.
+        const ParseConfig                       m_Config;       ///< Parsing configurations.
+        mutable std::mutex                      m_Mutex;        ///< Mutex of cache state.
+        std::unordered_map<std::string, Entry>  m_Entries;      ///< Entries by filename.
+        std::list<std::string>                  m_Lru;          ///< Filenames of loaded entries, most recently used first.
+        size_t                                  m_Memory;       ///< Estimated memory usage of loaded entries.
+        size_t                                  m_Hits;         ///< Number of calls served from cache.
+        size_t                                  m_Parses;       ///< Number of parsed files.
+
+    };
+
+    DocumentCache::DocumentCache(const size_t memoryBudget, const ParseConfig & config) :
+        m_pImp(new DocumentCacheImp(memoryBudget, config))
+    {
+    }
+
+    DocumentCache::~DocumentCache()
+    {
+        delete static_cast<DocumentCacheImp*>(m_pImp);
+    }
+
+    std::shared_ptr<const Document> DocumentCache::Get(const char * filename)
+    {
+        return static_cast<DocumentCacheImp*>(m_pImp)->Get(filename);
+    }
+
+    void DocumentCache::Erase(const char * filename)
+    {
+        static_cast<DocumentCacheImp*>(m_pImp)->Erase(filename);
+    }
+
+    void DocumentCache::Clear()
+    {
+        static_cast<DocumentCacheImp*>(m_pImp)->Clear();
+    }
+
+    size_t DocumentCache::Size() const
+    {
+        return static_cast<DocumentCacheImp*>(m_pImp)->Size();
+    }
+
+    size_t DocumentCache::MemoryUsage() const
+    {
+        return static_cast<DocumentCacheImp*>(m_pImp)->MemoryUsage();
+    }
+
+    size_t DocumentCache::Hits() const
+    {
+        return static_cast<DocumentCacheImp*>(m_pImp)->Hits();
+    }
+
+    size_t DocumentCache::Parses() const
+    {
+        return static_cast<DocumentCacheImp*>(m_pImp)->Parses();
+    }
+
+
+    // Parse configuration structure.
+    ParseConfig::ParseConfig(const bool sourceLocations,
+                             const bool typedScalars) :
+        SourceLocations(sourceLocations),
+        TypedScalars(typedScalars)
+    {
+    }
+
+
+    // Location structure.
+    Location::Location(const size_t line, const size_t column) :
+        Line(line),
+        Column(column)
+    {
+    }
+
+
+    // Parallel configuration structure.
+    ParallelConfig::ParallelConfig(const size_t threads,
+                                   const size_t chunkSize) :
+        Threads(threads),
+        ChunkSize(chunkSize)
+    {
+    }
+
+    namespace impl
+    {
+
+        void ParallelChunks(const size_t count, const ParallelConfig & config, ChunkFunction function, void * pContext)
+        {
+            if(count == 0)
+            {
+                return;
+            }
+
+            size_t threads = config.Threads ? config.Threads : static_cast<size_t>(std::thread::hardware_concurrency());
+            threads = threads ? threads : 1;
+            size_t chunkSize = config.ChunkSize ? config.ChunkSize : count / (threads * 8);
+            chunkSize = chunkSize ? chunkSize : 1;
+            const size_t chunks = (count + chunkSize - 1) / chunkSize;
+            threads = threads < chunks ? threads : chunks;
+
+            std::atomic<size_t> next(0);
+            std::atomic<bool> failed(false);
+            std::exception_ptr exception;
+            std::mutex exceptionMutex;
+
+            auto worker = [&]()
+            {
+                try
+                {
+                    while(failed.load(std::memory_order_relaxed) == false)
+                    {
+                        const size_t first = next.fetch_add(chunkSize, std::memory_order_relaxed);
+                        if(first >= count)
+                        {
+                            return;
+                        }
+                        const size_t last = count - first < chunkSize ? count : first + chunkSize;
+                        function(pContext, first, last);
+                    }
+                }
+                catch(...)
+                {
+                    std::lock_guard<std::mutex> lock(exceptionMutex);
+                    if(!exception)
+                    {
+                        exception = std::current_exception();
+                    }
+                    failed = true;
+                }
+            };
+
+            std::vector<std::thread> pool;
+            pool.reserve(threads - 1);
+            for(size_t i = 1; i < threads; i++)
+            {
+                try
+                {
+                    pool.push_back(std::thread(worker));
+                }
+                catch(const std::system_error &)
+                {
+                    break;
+                }
+            }
+            worker();
+            for(auto it = pool.begin(); it != pool.end(); ++it)
+            {
+                it->join();
+            }
+
+            if(exception)
+            {
+                std::rethrow_exception(exception);
+            }
+        }
+
+    }
+
+
+    // Path implementations.
+    Path Path::Compile(const std::string & path)
+    {
+        Path result;
+        const size_t size = path.size();
+        size_t pos = 0;
+        bool expectSegment = false;
+
+        while(pos < size)
+        {
+            Segment segment;
+            segment.Index = 0;
+            const char c = path[pos];
+
+            if(c == '.')
+            {
+                if(expectSegment || result.m_Segments.size() == 0)
+                {
+                    throw OperationException(g_ErrorInvalidPath);
+                }
+                expectSegment = true;
+                ++pos;
+                continue;
+            }
+
+            if(c == '[')
+            {
+                const size_t end = FindPathBracketEnd(path, pos);
+                if(end == std::string::npos)
+                {
+                    throw OperationException(g_ErrorInvalidPath);
+                }
+                std::string content = path.substr(pos + 1, end - pos - 1);
+
+                if(content.size() >= 2 && (content[0] == '"' || content[0] == '\'') &&
+                   content.back() == content[0])
+                {
+                    segment.Type = Segment::KeyType;
+                    segment.Key = content.substr(1, content.size() - 2);
+                }
+                else if(content == "*")
+                {
+                    segment.Type = Segment::WildcardType;
+                }
+                else if(content.size() > 1 && content[0] == '?')
+                {
+                    const size_t equalPos = content.find("==");
+                    const size_t notEqualPos = content.find("!=");
+                    const size_t opPos = equalPos < notEqualPos ? equalPos : notEqualPos;
+                    if(opPos == std::string::npos)
+                    {
+                        segment.Type = Segment::FilterExistsType;
+                        segment.Key = content.substr(1);
+                    }
+                    else
+                    {
+                        segment.Type = opPos == equalPos ? Segment::FilterEqualType : Segment::FilterNotEqualType;
+                        segment.Key = content.substr(1, opPos - 1);
+                        segment.Value = content.substr(opPos + 2);
+                        if(segment.Value.size() >= 2 && (segment.Value[0] == '"' || segment.Value[0] == '\'') &&
+                           segment.Value.back() == segment.Value[0])
+                        {
+                            segment.Value = segment.Value.substr(1, segment.Value.size() - 2);
+                        }
+                    }
+                    if(segment.Key.size() == 0)
+                    {
+                        throw OperationException(g_ErrorInvalidPath);
+                    }
+                }
+                else
+                {
+                    if(content.size() == 0 || content.find_first_not_of("0123456789") != std::string::npos)
+                    {
+                        throw OperationException(g_ErrorInvalidPath);
+                    }
+                    bool negative = false;
+                    uint64_t magnitude = 0;
+                    if(impl::ParseInteger(content.data(), content.data() + content.size(), negative, magnitude) != impl::NumberOk ||
+                       magnitude > static_cast<uint64_t>(std::numeric_limits<size_t>::max()))
+                    {
+                        throw OperationException(g_ErrorInvalidPath);
+                    }
+                    segment.Type = Segment::IndexType;
+                    segment.Index = static_cast<size_t>(magnitude);
+                }
+
+                pos = end + 1;
+            }
+            else
+            {
+                if(result.m_Segments.size() && expectSegment == false)
+                {
+                    throw OperationException(g_ErrorInvalidPath);
+                }
+
+                size_t end = path.find_first_of(".[", pos);
+                if(end == std::string::npos)
+                {
+                    end = size;
+                }
+                segment.Key = path.substr(pos, end - pos);
+                segment.Type = segment.Key == "*" ? Segment::WildcardType : Segment::KeyType;
+                pos = end;
+            }
+
+            result.m_Segments.push_back(segment);
+            expectSegment = false;
+        }
+
+        if(expectSegment)
+        {
+            throw OperationException(g_ErrorInvalidPath);
+        }
+
+        return result;
+    }
+
+    Path::Path()
+    {
+    }
+
+    std::vector<const Node *> Path::Evaluate(const Node & root) const
+    {
+        std::vector<const Node *> result;
+        EvaluateSegment(root, 0, result);
+        return result;
+    }
+
+    std::vector<const Node *> Path::Evaluate(const Node & root, const ParallelConfig & config) const
+    {
+        // Walk single-step segments, until first segment with multiple branches.
+        const Node * pNode = &root;
+        size_t segment = 0;
+        for(; segment < m_Segments.size(); segment++)
+        {
+            const Segment & current = m_Segments[segment];
+            if(current.Type == Segment::KeyType)
+            {
+                pNode = pNode->Find(current.Key);
+            }
+            else if(current.Type == Segment::IndexType)
+            {
+                pNode = pNode->Find(current.Index);
+            }
+            else
+            {
+                break;
+            }
+
+            if(pNode == nullptr)
+            {
+                return std::vector<const Node *>();
+            }
+        }
+
+        if(segment == m_Segments.size() || pNode->Size() == 0)
+        {
+            return Evaluate(*pNode);
+        }
+
+        // Evaluate branches in parallel, with results per branch merged in order.
+        std::vector<const Node *> branches;
+        branches.reserve(pNode->Size());
+        for(auto it = pNode->begin(); it != pNode->end(); ++it)
+        {
+            branches.push_back(&(*it).second);
+        }
+
+        std::vector<std::vector<const Node *> > branchResults(branches.size());
+        impl::ParallelChunks(branches.size(), config, [&](const size_t first, const size_t last)
+        {
+            for(size_t i = first; i < last; ++i)
+            {
+                EvaluateBranch(*branches[i], segment, branchResults[i]);
+            }
+        });
+
+        size_t count = 0;
+        for(auto it = branchResults.begin(); it != branchResults.end(); ++it)
+        {
+            count += it->size();
+        }
+
+        std::vector<const Node *> result;
+        result.reserve(count);
+        for(auto it = branchResults.begin(); it != branchResults.end(); ++it)
+        {
+            result.insert(result.end(), it->begin(), it->end());
+        }
+        return result;
+    }
+
+    size_t Path::Size() const
+    {
+        return m_Segments.size();
+    }
+
+    void Path::EvaluateSegment(const Node & node, const size_t segment, std::vector<const Node *> & result) const
+    {
+        if(segment == m_Segments.size())
+        {
+            result.push_back(&node);
+            return;
+        }
+
+        const Segment & current = m_Segments[segment];
+        switch(current.Type)
+        {
+        case Segment::KeyType:
+        {
+            const Node * pNode = node.Find(current.Key);
+            if(pNode)
+            {
+                EvaluateSegment(*pNode, segment + 1, result);
+            }
+        }
+        break;
+        case Segment::IndexType:
+        {
+            const Node * pNode = node.Find(current.Index);
+            if(pNode)
+            {
+                EvaluateSegment(*pNode, segment + 1, result);
+            }
+        }
+        break;
+        default:
+            for(auto it = node.begin(); it != node.end(); ++it)
+            {
+                EvaluateBranch((*it).second, segment, result);
+            }
+            break;
+        }
+    }
+
+    void Path::EvaluateBranch(const Node & node, const size_t segment, std::vector<const Node *> & result) const
+    {
+        const Segment & current = m_Segments[segment];
+        if(current.Type != Segment::WildcardType)
+        {
+            const Node * pValue = node.Find(current.Key);
+            if(current.Type == Segment::FilterExistsType)
+            {
+                if(pValue == nullptr)
+                {
+                    return;
+                }
+            }
+            else
+            {
+                const bool equal = pValue != nullptr && pValue->IsScalar() &&
+                                   NODE_IMP_EXT((*pValue))->m_pImp->GetData() == current.Value;
+                if(equal != (current.Type == Segment::FilterEqualType))
+                {
+                    return;
+                }
+            }
+        }
+
+        EvaluateSegment(node, segment + 1, result);
+    }
+
+
+    // Index implementations.
+    Index::Index() :
+        m_pSequence(nullptr),
+        m_Version(0)
+    {
+    }
+
+    Index::Index(const Node & sequence, const std::vector<std::string> & fields, const ParallelConfig & config) :
+        m_pSequence(&sequence),
+        m_Fields(fields),
+        m_Version(0)
+    {
+        if(m_Fields.size() == 0)
+        {
+            throw OperationException(g_ErrorIndexKey);
+        }
+
+        Rebuild(config);
+    }
+
+    const Node * Index::Find(const std::string & value) const
+    {
+        if(m_Fields.size() > 1)
+        {
+            throw OperationException(g_ErrorIndexKey);
+        }
+
+        const size_t entry = FindFirst(value);
+        return entry != std::string::npos ? m_Entries[entry].pNode : nullptr;
+    }
+
+    const Node * Index::Find(const std::vector<std::string> & values) const
+    {
+        const size_t entry = FindFirst(CompoundKey(values));
+        return entry != std::string::npos ? m_Entries[entry].pNode : nullptr;
+    }
+
+    std::vector<const Node *> Index::FindAll(const std::string & value) const
+    {
+        if(m_Fields.size() > 1)
+        {
+            throw OperationException(g_ErrorIndexKey);
+        }
+
+        std::vector<const Node *> result;
+        for(size_t entry = FindFirst(value); entry != std::string::npos; entry = m_Entries[entry].Next)
+        {
+            result.push_back(m_Entries[entry].pNode);
+        }
+        return result;
+    }
+
+    std::vector<const Node *> Index::FindAll(const std::vector<std::string> & values) const
+    {
+        std::vector<const Node *> result;
+        for(size_t entry = FindFirst(CompoundKey(values)); entry != std::string::npos; entry = m_Entries[entry].Next)
+        {
+            result.push_back(m_Entries[entry].pNode);
+        }
+        return result;
+    }
+
+    size_t Index::Size() const
+    {
+        return m_Buckets.size();
+    }
+
+    bool Index::IsValid() const
+    {
+        return m_pSequence == nullptr || SequenceVersion(*m_pSequence) == m_Version;
+    }
+
+    void Index::Rebuild(const ParallelConfig & config)
+    {
+        m_Buckets.clear();
+        m_Entries.clear();
+        if(m_pSequence == nullptr)
+        {
+            return;
+        }
+
+        m_Version = SequenceVersion(*m_pSequence);
+        if(m_pSequence->IsSequence() == false)
+        {
+            return;
+        }
+
+        // Extract keys of elements in parallel.
+        const std::vector<Node*> & sequence = static_cast<SequenceImp*>(NODE_IMP_EXT((*m_pSequence))->m_pImp)->m_Sequence;
+        std::vector<std::vector<std::string> > elementKeys(sequence.size());
+        impl::ParallelChunks(sequence.size(), config, [&](const size_t first, const size_t last)
+        {
+            for(size_t i = first; i < last; ++i)
+            {
+                CollectIndexKeys(*sequence[i], m_Fields, 0, g_EmptyString, elementKeys[i]);
+            }
+        });
+
+        // Link entries of equal keys, in sequence order.
+        size_t count = 0;
+        for(auto it = elementKeys.begin(); it != elementKeys.end(); ++it)
+        {
+            count += it->size();
+        }
+        m_Entries.reserve(count);
+        m_Buckets.reserve(count);
+
+        for(size_t i = 0; i < sequence.size(); i++)
+        {
+            std::vector<std::string> & keys = elementKeys[i];
+            for(auto it = keys.begin(); it != keys.end(); ++it)
+            {
+                const size_t entry = m_Entries.size();
+                auto result = m_Buckets.insert(std::make_pair(std::move(*it), Bucket{entry, entry}));
+                if(result.second == false)
+                {
+                    Bucket & bucket = result.first->second;
+                    if(m_Entries[bucket.Last].pNode == sequence[i])
+                    {
+                        continue;
+                    }
+                    m_Entries[bucket.Last].Next = entry;
+                    bucket.Last = entry;
+                }
+                m_Entries.push_back(Entry{sequence[i], std::string::npos});
+            }
+        }
+    }
+
+    size_t Index::FindFirst(const std::string & key) const
+    {
+        if(IsValid() == false)
+        {
+            throw OperationException(g_ErrorIndexOutdated);
+        }
+
+        auto it = m_Buckets.find(key);
+        if(it == m_Buckets.end())
+        {
+            return std::string::npos;
+        }
+        return it->second.First;
+    }
+
+    std::string Index::CompoundKey(const std::vector<std::string> & values) const
+    {
+        if(values.size() != m_Fields.size())
+        {
+            throw OperationException(g_ErrorIndexKey);
+        }
+        if(values.size() == 1)
+        {
+            return values[0];
+        }
+
+        std::string key;
+        for(auto it = values.begin(); it != values.end(); ++it)
+        {
+            AppendIndexKeyPart(key, *it);
+        }
+        return key;
+    }
+
+    Index BuildIndex(const Node & sequence, const std::string & field, const ParallelConfig & config)
+    {
+        return Index(sequence, std::vector<std::string>(1, field), config);
+    }
+
+    Index BuildIndex(const Node & sequence, const std::vector<std::string> & fields, const ParallelConfig & config)
+    {
+        return Index(sequence, fields, config);
+    }
+
+
+    // Serialize configuration structure.
+    SerializeConfig::SerializeConfig(const size_t spaceIndentation,
+                                     const size_t scalarMaxLength,
+                                     const bool sequenceMapNewline,
+                                     const bool mapScalarNewline,
+                                     const eStyle style,
+                                     const size_t flowSequenceLength) :
+        SpaceIndentation(spaceIndentation),
+        ScalarMaxLength(scalarMaxLength),
+        SequenceMapNewline(sequenceMapNewline),
+        MapScalarNewline(mapScalarNewline),
+        Style(style),
+        FlowSequenceLength(flowSequenceLength)
+    {
+    }
+
+
+    // File configuration structure.
+    FileConfig::FileConfig(const size_t bufferSize,
+                           const bool atomicReplace) :
+        BufferSize(bufferSize),
+        AtomicReplace(atomicReplace)
+    {
+    }
+
+
+    // Serialization functions
+    void Serialize(const Node & root, const char * filename, const SerializeConfig & config, const FileConfig & fileConfig)
+    {
+        impl::CheckSerializeConfig(config);
+        if(filename == nullptr)
+        {
+            throw OperationException(g_ErrorCannotOpenFile);
+        }
+
+        if(fileConfig.AtomicReplace)
+        {
+            WriteFileAtomic(root, filename, config, fileConfig);
+            return;
+        }
+
+        // Existing file is truncated after writing, left unchanged if serializing fails before any data is written.
+        const int fd = OpenOutputFile(filename, false);
+        if(fd < 0)
+        {
+            throw OperationException(g_ErrorCannotOpenFile);
+        }
+
+        try
+        {
+            WriteFileData(root, fd, config, fileConfig, false);
+            if(TruncateFile(fd, false) == false)
+            {
+                throw OperationException(g_ErrorWriteFile);
+            }
+        }
+        catch(...)
+        {
+            TruncateFile(fd, true);
+            CloseFile(fd);
+            throw;
+        }
+
+        if(CloseFile(fd) == false)
+        {
+            throw OperationException(g_ErrorWriteFile);
+        }
+    }
+
+    size_t LineFolding(const std::string & input, std::vector<std::string> & folded, const size_t maxLength)
+    {
+        folded.clear();
+        if(input.size() == 0)
+        {
+            return 0;
+        }
+
+        size_t currentPos = 0;
+        size_t lastPos = 0;
+        size_t spacePos = std::string::npos;
+        while(currentPos < input.size())
+        {
+            currentPos = lastPos + maxLength;
+
+            if(currentPos < input.size())
+            {
+               spacePos = input.find_first_of(' ', currentPos);
+            }
+
+            if(spacePos == std::string::npos || currentPos >= input.size())
+            {
+                const std::string endLine = input.substr(lastPos);
+                if(endLine.size())
+                {
+                    folded.push_back(endLine);
+                }
+
+                return folded.size();
+            }
+
+            folded.push_back(input.substr(lastPos, spacePos - lastPos));
+
+            lastPos = spacePos + 1;
+        }
+
+        return folded.size();
+    }
+
+    static void SerializeLoop(const Node & node, Sink & sink, bool useLevel, const size_t level, const SerializeConfig & config);
+
+    static bool SerializeEntryHeader(const bool isMap, const std::string & key, const Node & value, Sink & sink,
+                                     const bool indent, const size_t level, const SerializeConfig & config)
+    {
+        const bool inlined = value.IsScalar() || IsFlowSequence(value, config);
+        if(isMap == false)
+        {
+            sink.Spaces(level);
+            sink.Write("- ", 2);
+            if((value.IsSequence() && inlined == false) || (value.IsMap() && config.SequenceMapNewline == true))
+            {
+                sink.Put('\n');
+                return true;
+            }
+            return false;
+        }
+
+        if(indent)
+        {
+           sink.Spaces(level);
+        }
+
+        impl::EncodeKey(sink, key.c_str(), key.size());
+
+        if(inlined == false || config.MapScalarNewline)
+        {
+            sink.Put('\n');
+            return true;
+        }
+        return false;
+    }
+
+    static size_t SerializeEntryLevel(const bool isMap, const size_t level, const SerializeConfig & config)
+    {
+        return isMap ? level + config.SpaceIndentation : level + 2;
+    }
+
+    static void SerializeRange(const bool isMap, ConstIterator it, const ConstIterator end, Sink & sink,
+                               bool indent, const size_t level, const SerializeConfig & config)
+    {
+        const size_t entryLevel = SerializeEntryLevel(isMap, level, config);
+        for(; it != end; ++it)
+        {
+            const ConstIterator::value_type entry = *it;
+            if(entry.second.IsNone())
+            {
+                continue;
+            }
+
+            const bool useLevel = SerializeEntryHeader(isMap, entry.first, entry.second, sink, indent, level, config);
+            SerializeLoop(entry.second, sink, useLevel, entryLevel, config);
+            indent = true;
+        }
+    }
+
+    void SerializeLoop(const Node & node, Sink & sink, bool useLevel, const size_t level, const SerializeConfig & config)
+    {
+        switch(node.Type())
+        {
+            case Node::SequenceType:
+            case Node::MapType:
+            {
+                if(IsFlowSequence(node, config))
+                {
+                    if(useLevel)
+                    {
+                        sink.Spaces(level);
+                    }
+                    const SerializeConfig flowConfig(config.SpaceIndentation, config.ScalarMaxLength, false, false,
+                                                     SerializeConfig::FlowStyle);
+                    SerializeFlow(node, sink, flowConfig);
+                    sink.Put('\n');
+                    break;
+                }
+                SerializeRange(node.IsMap(), node.begin(), node.end(), sink, useLevel, level, config);
+            }
+            break;
+            case Node::ScalarType:
+            {
+                impl::EncodeScalar(sink, NODE_IMP_EXT(node)->m_pImp->GetData(), node.DataType() != Node::StringData, useLevel, level, config,
+                                   IsCitedScalar(node));
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    /**
+    * @breif Independently serializable part of parallel serialization.
+    *        Output is the prefix, followed by the serialized entries of range.
+    *
+    */
+    struct SerializeTask
+    {
+        std::string     Prefix;
+        bool            IsMap;
+        ConstIterator   Begin;
+        ConstIterator   End;
+        bool            Indent;
+        size_t          Level;
+    };
+
+    static void PlanSerialize(const Node & node, const bool useLevel, const size_t level, const SerializeConfig & config,
+                              const size_t chunkSize, std::vector<SerializeTask> & tasks, std::string & prefix)
+    {
+        if((node.IsSequence() == false && node.IsMap() == false) || IsFlowSequence(node, config))
+        {
+            StringSink prefixSink(prefix);
+            SerializeLoop(node, prefixSink, useLevel, level, config);
+            return;
+        }
+
+        // Entries of large containers are only split into ranges, avoiding a planning pass over all entries.
+        const bool isMap = node.IsMap();
+        const bool searchEntries = node.Size() <= chunkSize;
+        const size_t entryLevel = SerializeEntryLevel(isMap, level, config);
+        bool indent = useLevel;
+        bool rangeIndent = indent;
+        size_t rangeCount = 0;
+        ConstIterator rangeBegin = node.begin();
+        const ConstIterator end = node.end();
+
+        auto flushRange = [&](const ConstIterator & rangeEnd)
+        {
+            SerializeTask task;
+            task.Prefix.swap(prefix);
+            task.IsMap = isMap;
+            task.Begin = rangeBegin;
+            task.End = rangeEnd;
+            task.Indent = rangeIndent;
+            task.Level = level;
+            tasks.push_back(std::move(task));
+            rangeCount = 0;
+        };
+
+        for(ConstIterator it = node.begin(); it != end; ++it)
+        {
+            if(searchEntries == false)
+            {
+                if(rangeCount == 0)
+                {
+                    rangeBegin = it;
+                    rangeIndent = indent;
+                }
+                if(isMap && indent == false && (*it).second.IsNone() == false)
+                {
+                    indent = true;
+                }
+                if(++rangeCount == chunkSize)
+                {
+                    ConstIterator rangeEnd = it;
+                    flushRange(++rangeEnd);
+                }
+                continue;
+            }
+
+            const ConstIterator::value_type entry = *it;
+            const Node & value = entry.second;
+
+            // Large containers are split further, with their entry header as prefix of the next task.
+            if((value.IsSequence() || value.IsMap()) && value.Size() > chunkSize && IsFlowSequence(value, config) == false)
+            {
+                if(rangeCount)
+                {
+                    flushRange(it);
+                }
+
+                StringSink prefixSink(prefix);
+                const bool valueUseLevel = SerializeEntryHeader(isMap, entry.first, value, prefixSink, indent, level, config);
+                PlanSerialize(value, valueUseLevel, entryLevel, config, chunkSize, tasks, prefix);
+                indent = true;
+                continue;
+            }
+
+            if(rangeCount == 0)
+            {
+                rangeBegin = it;
+                rangeIndent = indent;
+            }
+            if(value.IsNone() == false)
+            {
+                indent = true;
+            }
+            if(++rangeCount == chunkSize)
+            {
+                ConstIterator rangeEnd = it;
+                flushRange(++rangeEnd);
+            }
+        }
+
+        if(rangeCount)
+        {
+            flushRange(end);
+        }
+    }
+
+    void Serialize(const Node & root, std::iostream & stream, const SerializeConfig & config)
+    {
+        StreamSink sink(stream);
+        Serialize(root, sink, config);
+    }
+
+    void Serialize(const Node & root, std::string & string, const SerializeConfig & config)
+    {
+        string.clear();
+        StringSink sink(string);
+        Serialize(root, sink, config);
+    }
+
+    void Serialize(const Node & root, Sink & sink, const SerializeConfig & config)
+    {
+        impl::CheckSerializeConfig(config);
+        if(config.Style != SerializeConfig::BlockStyle)
+        {
+            if(root.IsNone() && config.Style == SerializeConfig::JsonStyle)
+            {
+                sink.Write("null\n", 5);
+                return;
+            }
+            if(root.IsNone() == false)
+            {
+                SerializeFlow(root, sink, config);
+                sink.Put('\n');
+            }
+            return;
+        }
+        SerializeLoop(root, sink, false, 0, config);
+    }
+
+    /**
+    * @breif Counting sink, aborting serialization by throwing LimitExceeded when passing its limit.
+    *
+    */
+    class LimitedCountingSink : public Sink
+    {
+
+    public:
+
+        struct LimitExceeded
+        {
+        };
+
+        LimitedCountingSink(const size_t limit) :
+            m_Limit(limit),
+            m_Size(0)
+        {
+        }
+
+        using Sink::Write;
+        virtual void Write(const char *, const size_t size)
+        {
+            if(size > m_Limit - m_Size)
+            {
+                throw LimitExceeded();
+            }
+            m_Size += size;
+        }
+
+        size_t Size() const
+        {
+            return m_Size;
+        }
+
+    private:
+
+        size_t m_Limit; ///< Maximum number of bytes.
+        size_t m_Size;  ///< Number of written bytes.
+
+    };
+
+    size_t SerializedSize(const Node & root, const SerializeConfig & config, const size_t limit)
+    {
+        if(limit == 0)
+        {
+            CountingSink sink;
+            Serialize(root, sink, config);
+            return sink.Size();
+        }
+
+        LimitedCountingSink sink(limit);
+        try
+        {
+            Serialize(root, sink, config);
+        }
+        catch(const LimitedCountingSink::LimitExceeded &)
+        {
+            return limit + 1;
+        }
+        return sink.Size();
+    }
+
+    void Serialize(const Node & root, Sink & sink, const SerializeConfig & config, const ParallelConfig & parallelConfig)
+    {
+        impl::CheckSerializeConfig(config);
+
+        size_t threads = parallelConfig.Threads ? parallelConfig.Threads : static_cast<size_t>(std::thread::hardware_concurrency());
+        threads = threads ? threads : 1;
+        if(threads == 1 || config.Style != SerializeConfig::BlockStyle)
+        {
+            Serialize(root, sink, config);
+            return;
+        }
+        const size_t chunkSize = parallelConfig.ChunkSize ? parallelConfig.ChunkSize : 1024;
+
+        // Split document into tasks of at most chunkSize entries, in output order.
+        std::vector<SerializeTask> tasks;
+        std::string prefix;
+        PlanSerialize(root, false, 0, config, chunkSize, tasks, prefix);
+        if(prefix.size())
+        {
+            SerializeTask task;
+            task.Prefix.swap(prefix);
+            task.IsMap = false;
+            task.Indent = false;
+            task.Level = 0;
+            tasks.push_back(std::move(task));
+        }
+
+        // Serialize windows of tasks in parallel, written to sink in order. Buffers are reused between windows.
+        const size_t windowSize = threads * 4;
+        std::vector<std::string> buffers(windowSize < tasks.size() ? windowSize : tasks.size());
+        const ParallelConfig windowConfig(threads, 1);
+        for(size_t window = 0; window < tasks.size(); window += windowSize)
+        {
+            const size_t count = tasks.size() - window < windowSize ? tasks.size() - window : windowSize;
+            impl::ParallelChunks(count, windowConfig, [&](const size_t first, const size_t last)
+            {
+                for(size_t i = first; i < last; ++i)
+                {
+                    const SerializeTask & task = tasks[window + i];
+                    std::string & buffer = buffers[i];
+                    buffer.clear();
+                    StringSink bufferSink(buffer);
+                    bufferSink.Write(task.Prefix);
+                    SerializeRange(task.IsMap, task.Begin, task.End, bufferSink, task.Indent, task.Level, config);
+                }
+            });
+
+            for(size_t i = 0; i < count; ++i)
+            {
+                sink.Write(buffers[i]);
+            }
+        }
+    }
+
+    void Serialize(const Node & root, std::string & string, const SerializeConfig & config, const ParallelConfig & parallelConfig)
+    {
+        string.clear();
+        StringSink sink(string);
+        Serialize(root, sink, config, parallelConfig);
+    }
+
+
+    // Sink implementations.
+    Sink::~Sink()
+    {
+    }
+
+    void Sink::Write(const std::string & string)
+    {
+        Write(string.c_str(), string.size());
+    }
+
+    void Sink::Put(const char character)
+    {
+        Write(&character, 1);
+    }
+
+    void Sink::Spaces(const size_t count)
+    {
+        static const char spaces[] = "                                                                ";
+        static const size_t spacesSize = sizeof(spaces) - 1;
+
+        size_t left = count;
+        while(left > 0)
+        {
+            const size_t size = left < spacesSize ? left : spacesSize;
+            Write(spaces, size);
+            left -= size;
+        }
+    }
+
+    StreamSink::StreamSink(std::ostream & stream) :
+        m_Stream(stream)
+    {
+    }
+
+    void StreamSink::Write(const char * data, const size_t size)
+    {
+        m_Stream.write(data, static_cast<std::streamsize>(size));
+    }
+
+    StringSink::StringSink(std::string & string, const size_t reserve) :
+        m_String(string)
+    {
+        if(reserve > m_String.capacity())
+        {
+            m_String.reserve(reserve);
+        }
+    }
+
+    void StringSink::Write(const char * data, const size_t size)
+    {
+        m_String.append(data, size);
+    }
+
+    CountingSink::CountingSink() :
+        m_Size(0)
+    {
+    }
+
+    void CountingSink::Write(const char * data, const size_t size)
+    {
+        m_Size += size;
+    }
+
+    size_t CountingSink::Size() const
+    {
+        return m_Size;
+    }
+
+    BufferSink::BufferSink(char * buffer, const size_t capacity) :
+        m_pBuffer(buffer),
+        m_Capacity(capacity),
+        m_Size(0)
+    {
+    }
+
+    void BufferSink::Write(const char * data, const size_t size)
+    {
+        if(m_Size < m_Capacity)
+        {
+            const size_t left = m_Capacity - m_Size;
+            memcpy(m_pBuffer + m_Size, data, size < left ? size : left);
+        }
+        m_Size += size;
+    }
+
+    size_t BufferSink::Size() const
+    {
+        return m_Size;
+    }
+
+    bool BufferSink::Overflow() const
+    {
+        return m_Size > m_Capacity;
+    }
+
+    FileSink::FileSink(const int fd, const size_t bufferSize) :
+        m_Fd(fd),
+        m_Buffer(bufferSize > 0 ? bufferSize : 1),
+        m_Size(0)
+    {
+    }
+
+    FileSink::~FileSink()
+    {
+        try
+        {
+            Flush();
+        }
+        catch(const Exception &)
+        {
+        }
+    }
+
+    void FileSink::Write(const char * data, const size_t size)
+    {
+        if(m_Size + size <= m_Buffer.size())
+        {
+            memcpy(m_Buffer.data() + m_Size, data, size);
+            m_Size += size;
+            return;
+        }
+
+        // Large writes bypass the buffer.
+        Flush();
+        if(size >= m_Buffer.size())
+        {
+            WriteFile(data, size);
+            return;
+        }
+
+        memcpy(m_Buffer.data(), data, size);
+        m_Size = size;
+    }
+
+    void FileSink::Discard()
+    {
+        m_Size = 0;
+    }
+
+    void FileSink::Flush()
+    {
+        const size_t size = m_Size;
+        m_Size = 0;
+        WriteFile(m_Buffer.data(), size);
+    }
+
+    void FileSink::WriteFile(const char * data, const size_t size)
+    {
+        size_t written = 0;
+        while(written < size)
+        {
+        #if defined(_WIN32)
+            const unsigned int chunk = size - written > 0x40000000 ? 0x40000000 : static_cast<unsigned int>(size - written);
+            const int result = _write(m_Fd, data + written, chunk);
+        #else
+            const ssize_t result = ::write(m_Fd, data + written, size - written);
+            if(result < 0 && errno == EINTR)
+            {
+                continue;
+            }
+        #endif
+            if(result <= 0)
+            {
+                throw OperationException(g_ErrorWriteFile);
+            }
+            written += static_cast<size_t>(result);
+        }
+    }
+
+
+    // Binary snapshot implementations.
+    static const char     g_BinaryMagic[4]  = { 'Y', 'A', 'M', 'B' };
+    static const uint8_t  g_BinaryVersion   = 2;
+
+    /**
+    * @breif Tags of nodes in binary snapshots.
+    *        Typed scalars with g_BinaryTextFlag set are followed by their original text,
+    *        strings with g_BinaryTextFlag set were quoted in parsed input data.
+    *        Nodes with g_BinaryAnchorFlag set are shared by aliases, numbered in order of appearance,
+    *        and later occurrences are saved as BinaryAlias followed by the anchor number.
+    *
+    */
+    enum eBinaryTag
+    {
+        BinaryNone      = 0,
+        BinarySequence  = 1,
+        BinaryMap       = 2,
+        BinaryString    = 3,
+        BinaryNull      = 4,
+        BinaryBoolean   = 5,
+        BinaryInteger   = 7,
+        BinaryFloat     = 8,
+        BinaryAlias     = 9
+    };
+    static const uint8_t  g_BinaryTextFlag      = 0x80;
+    static const uint8_t  g_BinaryAnchorFlag    = 0x40;
+
+    /**
+    * @breif Reader of binary snapshots, building nodes directly into node imps.
+    *
+    */
+    class BinaryReader
+    {
+
+    public:
+
+        BinaryReader(const char * data, const size_t size) :
+            m_pData(reinterpret_cast<const unsigned char *>(data)),
+            m_pEnd(reinterpret_cast<const unsigned char *>(data) + size)
+        {
+        }
+
+        void Load(Node & root)
+        {
+            if(Remaining() < sizeof(g_BinaryMagic) + 1 ||
+               std::memcmp(m_pData, g_BinaryMagic, sizeof(g_BinaryMagic)) != 0 ||
+               m_pData[sizeof(g_BinaryMagic)] != g_BinaryVersion)
+            {
+                throw ParsingException(g_ErrorInvalidBinary);
+            }
+            m_pData += sizeof(g_BinaryMagic) + 1;
+
+            const size_t keyCount = ReadCount();
+            m_Keys.resize(keyCount);
+            for(size_t i = 0; i < keyCount; i++)
+            {
+                const size_t size = ReadCount();
+                m_Keys[i].assign(reinterpret_cast<const char *>(m_pData), size);
+                m_pData += size;
+            }
+
+            LoadNode(NODE_IMP_EXT(root), 0);
+            if(m_pData != m_pEnd)
+            {
+                throw ParsingException(g_ErrorInvalidBinary);
+            }
+        }
+
+    private:
+
+        size_t Remaining() const
+        {
+            return static_cast<size_t>(m_pEnd - m_pData);
+        }
+
+        uint8_t ReadByte()
+        {
+            if(m_pData == m_pEnd)
+            {
+                throw ParsingException(g_ErrorInvalidBinary);
+            }
+            return *m_pData++;
+        }
+
+        uint64_t ReadVarint()
+        {
+            uint64_t value = 0;
+            for(unsigned int shift = 0; shift < 64; shift += 7)
+            {
+                const uint8_t byte = ReadByte();
+                value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if((byte & 0x80) == 0)
+                {
+                    return value;
+                }
+            }
+            throw ParsingException(g_ErrorInvalidBinary);
+        }
+
+        /**
+        * @breif Read count of bytes or nodes, each taking at least one byte of remaining data.
+        *
+        */
+        size_t ReadCount()
+        {
+            const uint64_t count = ReadVarint();
+            if(count > Remaining())
+            {
+                throw ParsingException(g_ErrorInvalidBinary);
+            }
+            return static_cast<size_t>(count);
+        }
+
+        void ReadText(std::string & text)
+        {
+            const size_t size = ReadCount();
+            text.assign(reinterpret_cast<const char *>(m_pData), size);
+            m_pData += size;
+        }
+
+        /**
+        * @breif Load node recursively, with nesting depth limited to avoid stack overflow.
+        *
+        */
+        void LoadNode(NodeImp * pNodeImp, const size_t depth)
+        {
+            if(depth > g_MaxBinaryDepth)
+            {
+                throw ParsingException(g_ErrorInvalidBinary);
+            }
+
+            const uint8_t tag = ReadByte();
+            const uint8_t type = tag & ~(g_BinaryTextFlag | g_BinaryAnchorFlag);
+            if(tag == BinaryAlias)
+            {
+                const uint64_t anchor = ReadVarint();
+                if(anchor >= m_Anchors.size() || m_Anchors[static_cast<size_t>(anchor)] == nullptr)
+                {
+                    throw ParsingException(g_ErrorInvalidBinary);
+                }
+                pNodeImp->Share(m_Anchors[static_cast<size_t>(anchor)]);
+                return;
+            }
+
+            // Anchors are numbered before loading children, but not referable until loaded.
+            const size_t anchor = m_Anchors.size();
+            if(tag & g_BinaryAnchorFlag)
+            {
+                m_Anchors.push_back(nullptr);
+            }
+
+            switch(type)
+            {
+            case BinaryNone:
+                pNodeImp->Clear();
+                break;
+            case BinarySequence:
+            {
+                const size_t count = ReadCount();
+                pNodeImp->InitSequence();
+                std::vector<Node*> & sequence = static_cast<SequenceImp*>(pNodeImp->m_pImp)->m_Sequence;
+                sequence.reserve(count);
+                for(size_t i = 0; i < count; i++)
+                {
+                    sequence.push_back(new Node);
+                    LoadNode(NODE_IMP_EXT(*sequence.back()), depth + 1);
+                }
+            }
+            break;
+            case BinaryMap:
+            {
+                const size_t count = ReadCount();
+                pNodeImp->InitMap();
+                std::map<std::string, Node*> & map = static_cast<MapImp*>(pNodeImp->m_pImp)->m_Map;
+                for(size_t i = 0; i < count; i++)
+                {
+                    const uint64_t keyIndex = ReadVarint();
+                    if(keyIndex >= m_Keys.size())
+                    {
+                        throw ParsingException(g_ErrorInvalidBinary);
+                    }
+
+                    // Keys are saved in map order, appended at end of map.
+                    const size_t size = map.size();
+                    Node * pNode = new Node;
+                    auto it = map.emplace_hint(map.end(), m_Keys[static_cast<size_t>(keyIndex)], pNode);
+                    if(map.size() == size)
+                    {
+                        delete pNode;
+                        throw ParsingException(g_ErrorInvalidBinary);
+                    }
+                    LoadNode(NODE_IMP_EXT(*it->second), depth + 1);
+                }
+            }
+            break;
+            case BinaryString:
+            case BinaryNull:
+            case BinaryBoolean:
+            case BinaryInteger:
+            case BinaryFloat:
+                LoadScalar(pNodeImp, type, (tag & g_BinaryTextFlag) != 0);
+                break;
+            default:
+                throw ParsingException(g_ErrorInvalidBinary);
+            }
+
+            if(tag & g_BinaryAnchorFlag)
+            {
+                m_Anchors[anchor] = pNodeImp;
+            }
+        }
+
+        void LoadScalar(NodeImp * pNodeImp, const uint8_t type, const bool hasText)
+        {
+            pNodeImp->InitScalar();
+            ScalarImp * pScalarImp = static_cast<ScalarImp*>(pNodeImp->m_pImp);
+            pScalarImp->Reset();
+            impl::ScalarValue & native = pScalarImp->m_Native;
+            char buffer[32];
+            size_t size = 0;
+
+            switch(type)
+            {
+            case BinaryString:
+            case BinaryNull:
+                ReadText(pScalarImp->m_Value);
+                native.Type = type == BinaryNull ? impl::ScalarValue::NullType : impl::ScalarValue::NoneType;
+                pScalarImp->m_Quoted = type == BinaryString && hasText;
+                return;
+            case BinaryBoolean:
+            {
+                const uint8_t value = ReadByte();
+                if(value > 1)
+                {
+                    throw ParsingException(g_ErrorInvalidBinary);
+                }
+                native.Type = impl::ScalarValue::BooleanType;
+                native.Boolean = value == 1;
+                size = std::strlen(std::strcpy(buffer, native.Boolean ? "true" : "false"));
+            }
+            break;
+            case BinaryInteger:
+            {
+                const uint64_t value = ReadVarint();
+                native.Type = impl::ScalarValue::IntegerType;
+                native.Integer = static_cast<int64_t>((value >> 1) ^ (0 - (value & 1)));
+                size = impl::FormatInteger(buffer, native.Integer);
+            }
+            break;
+            case BinaryFloat:
+            {
+                if(Remaining() < 8)
+                {
+                    throw ParsingException(g_ErrorInvalidBinary);
+                }
+                uint64_t bits = 0;
+                for(size_t i = 0; i < 8; i++)
+                {
+                    bits |= static_cast<uint64_t>(m_pData[i]) << (i * 8);
+                }
+                m_pData += 8;
+                native.Type = impl::ScalarValue::FloatType;
+                std::memcpy(&native.Float, &bits, sizeof(bits));
+                size = impl::FormatFloat(buffer, native.Float);
+            }
+            break;
+            default:
+                throw ParsingException(g_ErrorInvalidBinary);
+            }
+
+            if(hasText)
+            {
+                ReadText(pScalarImp->m_Value);
+            }
+            else
+            {
+                pScalarImp->m_Value.assign(buffer, size);
+            }
+        }
+
+        const unsigned char *       m_pData;    ///< Current read position.
+        const unsigned char *       m_pEnd;     ///< End of data.
+        std::vector<std::string>    m_Keys;     ///< Key table.
+        std::vector<NodeImp *>      m_Anchors;  ///< Loaded anchored nodes, by anchor number.
+
+    };
+
+    void SaveBinary(const Node & root, Sink & sink)
+    {
+        // Collect key table, and key index of each map entry in traversal order.
+        std::unordered_map<std::string, size_t> keyMap;
+        std::vector<const std::string *> keys;
+        std::vector<size_t> keyRefs;
+        std::unordered_set<const TypeImp *> shared;
+        CollectBinaryKeys(root, keyMap, keys, keyRefs, shared);
+
+        sink.Write(g_BinaryMagic, sizeof(g_BinaryMagic));
+        sink.Put(static_cast<char>(g_BinaryVersion));
+        WriteVarint(sink, keys.size());
+        for(auto it = keys.begin(); it != keys.end(); it++)
+        {
+            WriteVarint(sink, (*it)->size());
+            sink.Write(**it);
+        }
+
+        size_t keyRef = 0;
+        std::unordered_map<const TypeImp *, size_t> anchors;
+        SaveBinaryNode(root, sink, keyRefs, keyRef, anchors);
+    }
+
+    void SaveBinary(const Node & root, std::string & string)
+    {
+        string.clear();
+        StringSink sink(string);
+        SaveBinary(root, sink);
+    }
+
+    void LoadBinary(Node & root, const char * data, const size_t size)
+    {
+        root.Clear();
+        try
+        {
+            BinaryReader reader(data, size);
+            reader.Load(root);
+        }
+        catch(const Exception &)
+        {
+            root.Clear();
+            throw;
+        }
+    }
+
+    void LoadBinary(Node & root, const std::string & data)
+    {
+        LoadBinary(root, data.c_str(), data.size());
+    }
+
+
+    // Mapped document implementations.
+    static const char     g_MappedMagic[4]      = { 'Y', 'A', 'M', 'M' };
+    static const uint32_t g_MappedVersion       = 1;
+    static const uint32_t g_MappedByteOrder     = 0x01020304;
+
+    /**
+    * @breif Node record of mapped documents. Offset points to payload:
+    *        Sequence: Size contiguous node records.
+    *        Map:      Bucket count, buckets of entry index + 1, and Size entries in key order.
+    *        Scalar:   Native value bits, followed by Size bytes of null terminated data.
+    *
+    */
+    struct MappedRecord
+    {
+        uint32_t Type;      ///< Node::eType of node.
+        uint32_t Native;    ///< impl::ScalarValue::eType of scalar.
+        uint64_t Size;      ///< Number of items, or size of scalar data.
+        uint64_t Offset;    ///< Offset of payload.
+    };
+
+    struct MappedEntry
+    {
+        uint64_t        Hash;       ///< Hash of key.
+        uint64_t        KeyOffset;  ///< Offset of null terminated key.
+        uint64_t        KeySize;    ///< Size of key.
+        MappedRecord    Value;      ///< Value node.
+    };
+
+    struct MappedHeader
+    {
+        char            Magic[4];   ///< Format identifier.
+        uint32_t        Version;    ///< Format version.
+        uint32_t        ByteOrder;  ///< Byte order marker, g_MappedByteOrder in byte order of writer.
+        uint32_t        Reserved;   ///< Reserved, 0.
+        uint64_t        Size;       ///< Total size of document.
+        MappedRecord    Root;       ///< Root node.
+    };
+
+    static size_t MappedAlign(const size_t size)
+    {
+        return (size + 7) & ~static_cast<size_t>(7);
+    }
+
+    /**
+    * @breif Writer of mapped documents, laying out payloads after the records referencing them.
+    *
+    */
+    class MappedWriter
+    {
+
+    public:
+
+        MappedWriter(std::string & data) :
+            m_Data(data)
+        {
+        }
+
+        void Write(const Node & root)
+        {
+            m_Data.assign(sizeof(MappedHeader), '\0');
+            MappedHeader header;
+            std::memset(&header, 0, sizeof(header));
+            std::memcpy(header.Magic, g_MappedMagic, sizeof(g_MappedMagic));
+            header.Version = g_MappedVersion;
+            header.ByteOrder = g_MappedByteOrder;
+            WriteNode(root, header.Root);
+            m_Data.resize(MappedAlign(m_Data.size()), '\0');
+            header.Size = m_Data.size();
+            std::memcpy(&m_Data[0], &header, sizeof(header));
+        }
+
+    private:
+
+        size_t Allocate(const size_t size)
+        {
+            const size_t offset = MappedAlign(m_Data.size());
+            m_Data.resize(offset + size, '\0');
+            return offset;
+        }
+
+        void WriteNode(const Node & node, MappedRecord & record)
+        {
+            std::memset(&record, 0, sizeof(record));
+            const NodeImp * pNodeImp = NODE_IMP_EXT(node);
+            if(pNodeImp->m_pImp == nullptr)
+            {
+                record.Type = Node::None;
+                return;
+            }
+            record.Type = pNodeImp->m_Type;
+
+            switch(pNodeImp->m_Type)
+            {
+            case Node::SequenceType:
+            {
+                const std::vector<Node*> & sequence = static_cast<const SequenceImp*>(pNodeImp->m_pImp)->m_Sequence;
+                record.Size = sequence.size();
+                record.Offset = Allocate(sequence.size() * sizeof(MappedRecord));
+                for(size_t i = 0; i < sequence.size(); i++)
+                {
+                    MappedRecord item;
+                    WriteNode(*sequence[i], item);
+                    std::memcpy(&m_Data[record.Offset + i * sizeof(MappedRecord)], &item, sizeof(item));
+                }
+            }
+            break;
+            case Node::MapType:
+            {
+                const std::map<std::string, Node*> & map = static_cast<const MapImp*>(pNodeImp->m_pImp)->m_Map;
+                uint64_t bucketCount = map.size() ? 2 : 0;
+                while(bucketCount && bucketCount < map.size() * 2)
+                {
+                    bucketCount <<= 1;
+                }
+                const size_t bucketsSize = MappedAlign(static_cast<size_t>(bucketCount) * sizeof(uint32_t));
+                record.Size = map.size();
+                record.Offset = Allocate(sizeof(uint64_t) + bucketsSize + map.size() * sizeof(MappedEntry));
+                std::memcpy(&m_Data[record.Offset], &bucketCount, sizeof(bucketCount));
+                const size_t bucketsOffset = record.Offset + sizeof(uint64_t);
+                const size_t entriesOffset = bucketsOffset + bucketsSize;
+
+                uint32_t index = 0;
+                for(auto it = map.begin(); it != map.end(); it++, index++)
+                {
+                    MappedEntry entry;
+                    entry.Hash = MappedHash(it->first.c_str(), it->first.size());
+                    entry.KeySize = it->first.size();
+                    entry.KeyOffset = WriteKey(it->first);
+
+                    // Open addressing with linear probing, empty buckets are 0.
+                    uint32_t * pBuckets = reinterpret_cast<uint32_t *>(&m_Data[bucketsOffset]);
+                    size_t bucket = static_cast<size_t>(entry.Hash & (bucketCount - 1));
+                    while(pBuckets[bucket] != 0)
+                    {
+                        bucket = (bucket + 1) & static_cast<size_t>(bucketCount - 1);
+                    }
+                    pBuckets[bucket] = index + 1;
+
+                    WriteNode(*it->second, entry.Value);
+                    std::memcpy(&m_Data[entriesOffset + index * sizeof(MappedEntry)], &entry, sizeof(entry));
+                }
+            }
+            break;
+            case Node::ScalarType:
+            {
+                const ScalarImp * pScalarImp = static_cast<const ScalarImp*>(pNodeImp->m_pImp);
+                const impl::ScalarValue & native = pScalarImp->m_Native;
+                uint64_t bits = 0;
+                switch(native.Type)
+                {
+                case impl::ScalarValue::BooleanType:
+                    bits = native.Boolean ? 1 : 0;
+                    break;
+                case impl::ScalarValue::IntegerType:
+                    bits = static_cast<uint64_t>(native.Integer);
+                    break;
+                case impl::ScalarValue::FloatType:
+                    std::memcpy(&bits, &native.Float, sizeof(bits));
+                    break;
+                default:
+                    break;
+                }
+                record.Native = native.Type;
+                record.Size = pScalarImp->m_Value.size();
+                record.Offset = Allocate(sizeof(uint64_t) + pScalarImp->m_Value.size() + 1);
+                std::memcpy(&m_Data[record.Offset], &bits, sizeof(bits));
+                std::memcpy(&m_Data[record.Offset + sizeof(uint64_t)], pScalarImp->m_Value.c_str(), pScalarImp->m_Value.size());
+            }
+            break;
+            default:
+                record.Type = Node::None;
+                break;
+            }
+        }
+
+        /**
+        * @breif Write null terminated key, shared by all maps using it.
+        *
+        */
+        uint64_t WriteKey(const std::string & key)
+        {
+            auto result = m_Keys.emplace(key, 0);
+            if(result.second)
+            {
+                const size_t offset = m_Data.size();
+                m_Data.append(key.c_str(), key.size() + 1);
+                result.first->second = offset;
+            }
+            return result.first->second;
+        }
+
+        std::string &                               m_Data; ///< Output data.
+        std::unordered_map<std::string, uint64_t>   m_Keys; ///< Offsets of written keys.
+
+    };
+
+    /**
+    * @breif Check that count elements at offset are within document data.
+    *
+    */
+    static void CheckMappedRange(const size_t size, const uint64_t offset, const uint64_t count, const size_t elementSize)
+    {
+        if(offset > size || count > (size - offset) / elementSize)
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+    }
+
+    /**
+    * @breif Check that payload at offset is 8 byte aligned, with count elements within document data.
+    *
+    */
+    static void CheckMappedPayload(const size_t size, const uint64_t offset, const uint64_t count, const size_t elementSize)
+    {
+        if(offset % 8 != 0)
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+        CheckMappedRange(size, offset, count, elementSize);
+    }
+
+    /**
+    * @breif Check scalar payload, value bits followed by null terminated data, without overflowing.
+    *
+    */
+    static void CheckMappedScalar(const char * pData, const size_t size, const MappedRecord & record)
+    {
+        CheckMappedPayload(size, record.Offset, 1, sizeof(uint64_t) + 1);
+        if(record.Size > size - record.Offset - sizeof(uint64_t) - 1 ||
+           pData[record.Offset + sizeof(uint64_t) + record.Size] != '\0')
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+    }
+
+    static const MappedRecord & GetMappedRecord(const char * pData, const size_t record)
+    {
+        return *reinterpret_cast<const MappedRecord *>(pData + record);
+    }
+
+    void SaveMapped(const Node & root, Sink & sink)
+    {
+        std::string data;
+        SaveMapped(root, data);
+        sink.Write(data);
+    }
+
+    void SaveMapped(const Node & root, std::string & string)
+    {
+        MappedWriter writer(string);
+        writer.Write(root);
+    }
+
+    NodeView::NodeView() :
+        m_pData(nullptr),
+        m_Size(0),
+        m_Record(0)
+    {
+    }
+
+    NodeView::NodeView(const char * pData, const size_t size, const size_t record) :
+        m_pData(pData),
+        m_Size(size),
+        m_Record(record)
+    {
+        if(record % 8 != 0)
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+        CheckMappedRange(size, record, 1, sizeof(MappedRecord));
+        if(GetMappedRecord(pData, record).Type > Node::ScalarType)
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+    }
+
+    Node::eType NodeView::Type() const
+    {
+        if(m_Record == 0)
+        {
+            return Node::None;
+        }
+        return static_cast<Node::eType>(GetMappedRecord(m_pData, m_Record).Type);
+    }
+
+    bool NodeView::IsNone() const
+    {
+        return Type() == Node::None;
+    }
+
+    bool NodeView::IsSequence() const
+    {
+        return Type() == Node::SequenceType;
+    }
+
+    bool NodeView::IsMap() const
+    {
+        return Type() == Node::MapType;
+    }
+
+    bool NodeView::IsScalar() const
+    {
+        return Type() == Node::ScalarType;
+    }
+
+    size_t NodeView::Size() const
+    {
+        const Node::eType type = Type();
+        if(type != Node::SequenceType && type != Node::MapType)
+        {
+            return 0;
+        }
+        return static_cast<size_t>(GetMappedRecord(m_pData, m_Record).Size);
+    }
+
+    NodeView NodeView::operator [] (const size_t index) const
+    {
+        if(IsSequence() == false)
+        {
+            return NodeView();
+        }
+        const MappedRecord & record = GetMappedRecord(m_pData, m_Record);
+        if(index >= record.Size)
+        {
+            return NodeView();
+        }
+        CheckMappedPayload(m_Size, record.Offset, record.Size, sizeof(MappedRecord));
+        return NodeView(m_pData, m_Size, static_cast<size_t>(record.Offset) + index * sizeof(MappedRecord));
+    }
+
+    NodeView NodeView::operator [] (const std::string & key) const
+    {
+        return Find(key.c_str(), key.size());
+    }
+
+    NodeView NodeView::Find(const char * key, const size_t size) const
+    {
+        if(IsMap() == false || GetMappedRecord(m_pData, m_Record).Size == 0)
+        {
+            return NodeView();
+        }
+        const MappedRecord & record = GetMappedRecord(m_pData, m_Record);
+        CheckMappedPayload(m_Size, record.Offset, 1, sizeof(uint64_t));
+        const uint64_t bucketCount = *reinterpret_cast<const uint64_t *>(m_pData + record.Offset);
+        if(bucketCount < record.Size || (bucketCount & (bucketCount - 1)) != 0)
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+        const size_t bucketsOffset = static_cast<size_t>(record.Offset) + sizeof(uint64_t);
+        CheckMappedRange(m_Size, bucketsOffset, bucketCount, sizeof(uint32_t));
+        const size_t entriesOffset = bucketsOffset + MappedAlign(static_cast<size_t>(bucketCount) * sizeof(uint32_t));
+        CheckMappedRange(m_Size, entriesOffset, record.Size, sizeof(MappedEntry));
+
+        const uint32_t * pBuckets = reinterpret_cast<const uint32_t *>(m_pData + bucketsOffset);
+        const MappedEntry * pEntries = reinterpret_cast<const MappedEntry *>(m_pData + entriesOffset);
+        const uint64_t hash = MappedHash(key, size);
+        size_t bucket = static_cast<size_t>(hash & (bucketCount - 1));
+        for(uint64_t i = 0; i < bucketCount; i++)
+        {
+            const uint32_t value = pBuckets[bucket];
+            if(value == 0)
+            {
+                break;
+            }
+            if(value > record.Size)
+            {
+                throw ParsingException(g_ErrorInvalidMapped);
+            }
+
+            const MappedEntry & entry = pEntries[value - 1];
+            if(entry.Hash == hash && entry.KeySize == size)
+            {
+                CheckMappedRange(m_Size, entry.KeyOffset, size, 1);
+                if(std::memcmp(m_pData + entry.KeyOffset, key, size) == 0)
+                {
+                    return NodeView(m_pData, m_Size, entriesOffset + (value - 1) * sizeof(MappedEntry) + offsetof(MappedEntry, Value));
+                }
+            }
+            bucket = (bucket + 1) & static_cast<size_t>(bucketCount - 1);
+        }
+        return NodeView();
+    }
+
+    std::string NodeView::Key(const size_t index) const
+    {
+        if(IsMap() == false || index >= GetMappedRecord(m_pData, m_Record).Size)
+        {
+            throw OperationException(g_ErrorViewIndex);
+        }
+        const NodeView value = Value(index);
+        const MappedEntry & entry = *reinterpret_cast<const MappedEntry *>(m_pData + value.m_Record - offsetof(MappedEntry, Value));
+        CheckMappedRange(m_Size, entry.KeyOffset, entry.KeySize, 1);
+        return std::string(m_pData + entry.KeyOffset, static_cast<size_t>(entry.KeySize));
+    }
+
+    NodeView NodeView::Value(const size_t index) const
+    {
+        if(IsMap() == false || index >= GetMappedRecord(m_pData, m_Record).Size)
+        {
+            throw OperationException(g_ErrorViewIndex);
+        }
+        const MappedRecord & record = GetMappedRecord(m_pData, m_Record);
+        CheckMappedPayload(m_Size, record.Offset, 1, sizeof(uint64_t));
+        const uint64_t bucketCount = *reinterpret_cast<const uint64_t *>(m_pData + record.Offset);
+        CheckMappedRange(m_Size, record.Offset + sizeof(uint64_t), bucketCount, sizeof(uint32_t));
+        const size_t entriesOffset = static_cast<size_t>(record.Offset) + sizeof(uint64_t) +
+                                     MappedAlign(static_cast<size_t>(bucketCount) * sizeof(uint32_t));
+        CheckMappedRange(m_Size, entriesOffset, record.Size, sizeof(MappedEntry));
+        return NodeView(m_pData, m_Size, entriesOffset + index * sizeof(MappedEntry) + offsetof(MappedEntry, Value));
+    }
+
+    const char * NodeView::Data() const
+    {
+        if(IsScalar() == false)
+        {
+            return "";
+        }
+        const MappedRecord & record = GetMappedRecord(m_pData, m_Record);
+        CheckMappedScalar(m_pData, m_Size, record);
+        return m_pData + record.Offset + sizeof(uint64_t);
+    }
+
+    size_t NodeView::DataSize() const
+    {
+        if(IsScalar() == false)
+        {
+            return 0;
+        }
+        const MappedRecord & record = GetMappedRecord(m_pData, m_Record);
+        CheckMappedScalar(m_pData, m_Size, record);
+        return static_cast<size_t>(record.Size);
+    }
+
+    std::string NodeView::AsString() const
+    {
+        return std::string(Data(), DataSize());
+    }
+
+    impl::ScalarValue NodeView::NativeValue() const
+    {
+        impl::ScalarValue value;
+        if(IsScalar() == false)
+        {
+            return value;
+        }
+        const MappedRecord & record = GetMappedRecord(m_pData, m_Record);
+        CheckMappedPayload(m_Size, record.Offset, 1, sizeof(uint64_t));
+        const uint64_t bits = *reinterpret_cast<const uint64_t *>(m_pData + record.Offset);
+        switch(record.Native)
+        {
+        case impl::ScalarValue::NullType:
+            value.Type = impl::ScalarValue::NullType;
+            break;
+        case impl::ScalarValue::BooleanType:
+            value.Type = impl::ScalarValue::BooleanType;
+            value.Boolean = bits != 0;
+            break;
+        case impl::ScalarValue::IntegerType:
+            value.Type = impl::ScalarValue::IntegerType;
+            value.Integer = static_cast<int64_t>(bits);
+            break;
+        case impl::ScalarValue::FloatType:
+            value.Type = impl::ScalarValue::FloatType;
+            std::memcpy(&value.Float, &bits, sizeof(bits));
+            break;
+        default:
+            break;
+        }
+        return value;
+    }
+
+    MappedDocument::MappedDocument() :
+        m_pData(nullptr),
+        m_Size(0),
+        m_pMapping(nullptr),
+        m_MappingSize(0),
+        m_Generation(0)
+    {
+    }
+
+    MappedDocument::~MappedDocument()
+    {
+        Close();
+    }
+
+    void MappedDocument::Open(const char * filename)
+    {
+        Close();
+        size_t size = 0;
+        void * pMapping = MapFile(filename, size);
+        try
+        {
+            Open(static_cast<const char *>(pMapping), size);
+        }
+        catch(const Exception &)
+        {
+            UnmapFile(pMapping, size);
+            throw;
+        }
+        m_pMapping = pMapping;
+        m_MappingSize = size;
+    }
+
+    void MappedDocument::Open(const char * data, const size_t size)
+    {
+        Close();
+        if(data == nullptr || reinterpret_cast<uintptr_t>(data) % 8 != 0 || size < sizeof(MappedHeader))
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+
+        const MappedHeader & header = *reinterpret_cast<const MappedHeader *>(data);
+        if(std::memcmp(header.Magic, g_MappedMagic, sizeof(g_MappedMagic)) != 0 ||
+           header.Version != g_MappedVersion || header.ByteOrder != g_MappedByteOrder || header.Size != size)
+        {
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+        NodeView root(data, size, offsetof(MappedHeader, Root));
+
+        m_pData = data;
+        m_Size = size;
+    }
+
+    void MappedDocument::Close()
+    {
+        if(m_pMapping)
+        {
+            UnmapFile(m_pMapping, m_MappingSize);
+        }
+        m_pData = nullptr;
+        m_Size = 0;
+        m_pMapping = nullptr;
+        m_MappingSize = 0;
+        m_Generation = 0;
+    }
+
+    bool MappedDocument::IsOpen() const
+    {
+        return m_pData != nullptr;
+    }
+
+    NodeView MappedDocument::Root() const
+    {
+        if(m_pData == nullptr)
+        {
+            return NodeView();
+        }
+        return NodeView(m_pData, m_Size, offsetof(MappedHeader, Root));
+    }
+
+    uint64_t MappedDocument::Generation() const
+    {
+        return m_Generation;
+    }
+
+
+    // Shared memory document implementations.
+    // Format identifier "YAMS" in upper 32 bits, version in lower 32 bits.
+    static const uint64_t g_SharedFormat    = (static_cast<uint64_t>(0x59414D53) << 32) | 2;
+
+    /**
+    * @breif Control segment of shared memory documents.
+    *        New segments are zero filled. The format word is set once by an atomic exchange,
+    *        segments of format 0 are not initialized yet.
+    *
+    */
+    struct SharedControl
+    {
+        std::atomic<uint64_t>   Format;     ///< Format identifier and version, set by first publisher.
+        std::atomic<uint64_t>   Generation; ///< Current generation, 0 if nothing is published.
+        std::atomic<uint64_t>   Reserved;   ///< Last generation reserved by a publisher.
+    };
+
+    void PublishShared(const Node & root, const char * name, const unsigned int mode)
+    {
+    #if defined(_WIN32)
+        throw OperationException(g_ErrorSharedMemory);
+    #else
+        std::string data;
+        SaveMapped(root, data);
+
+        SharedControl * pControl = static_cast<SharedControl *>(MapSharedControl(name, true, mode));
+
+        // Reserve a generation of our own, its segment is never touched by other publishers.
+        // Segments left by failed publishers, before the control segment was removed, are skipped.
+        uint64_t generation = 0;
+        std::string segment;
+        int fd = -1;
+        while(true)
+        {
+            uint64_t reserved = pControl->Reserved.load(std::memory_order_relaxed);
+            do
+            {
+                generation = std::max(reserved, pControl->Generation.load(std::memory_order_acquire)) + 1;
+            }
+            while(pControl->Reserved.compare_exchange_weak(reserved, generation, std::memory_order_acq_rel) == false);
+
+            segment = SharedSegmentName(name, generation);
+            fd = shm_open(segment.c_str(), O_RDWR | O_CREAT | O_EXCL, static_cast<mode_t>(mode));
+            if(fd != -1 || errno != EEXIST)
+            {
+                break;
+            }
+        }
+
+        void * pMapping = MAP_FAILED;
+        if(fd != -1)
+        {
+            if(ftruncate(fd, static_cast<off_t>(data.size())) == 0)
+            {
+                pMapping = mmap(nullptr, data.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+            if(pMapping == MAP_FAILED)
+            {
+                shm_unlink(segment.c_str());
+            }
+        }
+        if(pMapping == MAP_FAILED)
+        {
+            munmap(pControl, sizeof(SharedControl));
+            throw OperationException(g_ErrorSharedMemory);
+        }
+        std::memcpy(pMapping, data.c_str(), data.size());
+        munmap(pMapping, data.size());
+
+        // Make our generation current, unless a newer one already is. The publisher replacing
+        // a generation unlinks its segment, readers of it keep their mapping after unlink.
+        uint64_t previous = pControl->Generation.load(std::memory_order_acquire);
+        while(previous < generation &&
+              pControl->Generation.compare_exchange_weak(previous, generation, std::memory_order_acq_rel) == false)
+        {
+        }
+        munmap(pControl, sizeof(SharedControl));
+        if(previous > generation)
+        {
+            // Superseded by a concurrent publisher, as if replaced right after publishing.
+            shm_unlink(segment.c_str());
+        }
+        else if(previous)
+        {
+            shm_unlink(SharedSegmentName(name, previous).c_str());
+        }
+    #endif
+    }
+
+    void AttachShared(MappedDocument & document, const char * name)
+    {
+    #if defined(_WIN32)
+        throw OperationException(g_ErrorSharedMemory);
+    #else
+        SharedControl * pControl = static_cast<SharedControl *>(MapSharedControl(name, false, 0));
+        if(pControl == nullptr)
+        {
+            throw OperationException(g_ErrorNotPublished);
+        }
+
+        // Retry if segment is unlinked by a new generation, before being opened.
+        uint64_t generation = 0;
+        void * pMapping = MAP_FAILED;
+        size_t size = 0;
+        while(true)
+        {
+            generation = pControl->Generation.load(std::memory_order_acquire);
+            if(generation == 0)
+            {
+                munmap(pControl, sizeof(SharedControl));
+                throw OperationException(g_ErrorNotPublished);
+            }
+
+            const int fd = shm_open(SharedSegmentName(name, generation).c_str(), O_RDONLY, 0);
+            if(fd == -1)
+            {
+                if(errno == ENOENT && pControl->Generation.load(std::memory_order_acquire) != generation)
+                {
+                    continue;
+                }
+                break;
+            }
+            struct stat status;
+            if(fstat(fd, &status) == 0 && status.st_size > 0)
+            {
+                size = static_cast<size_t>(status.st_size);
+                pMapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+            }
+            ::close(fd);
+            break;
+        }
+        munmap(pControl, sizeof(SharedControl));
+        if(pMapping == MAP_FAILED)
+        {
+            throw OperationException(g_ErrorSharedMemory);
+        }
+
+        try
+        {
+            document.Open(static_cast<const char *>(pMapping), size);
+        }
+        catch(const Exception &)
+        {
+            munmap(pMapping, size);
+            throw;
+        }
+        document.m_pMapping = pMapping;
+        document.m_MappingSize = size;
+        document.m_Generation = generation;
+    #endif
+    }
+
+    uint64_t SharedGeneration(const char * name)
+    {
+    #if defined(_WIN32)
+        return 0;
+    #else
+        SharedControl * pControl = static_cast<SharedControl *>(MapSharedControl(name, false, 0));
+        if(pControl == nullptr)
+        {
+            return 0;
+        }
+        const uint64_t generation = pControl->Generation.load(std::memory_order_acquire);
+        munmap(pControl, sizeof(SharedControl));
+        return generation;
+    #endif
+    }
+
+    void RemoveShared(const char * name)
+    {
+    #if !defined(_WIN32)
+        const uint64_t generation = SharedGeneration(name);
+        if(generation)
+        {
+            shm_unlink(SharedSegmentName(name, generation).c_str());
+        }
+        shm_unlink(name);
+    #endif
+    }
+
+
+    // Emitter implementations.
+    Emitter::Emitter(Sink & sink, const SerializeConfig & config) :
+        m_pSink(&sink),
+        m_Config(config),
+        m_Complete(false)
+    {
+        impl::CheckSerializeConfig(m_Config);
+    }
+
+    void Emitter::BeginMap()
+    {
+        Begin(true);
+    }
+
+    void Emitter::BeginSeq()
+    {
+        Begin(false);
+    }
+
+    void Emitter::End()
+    {
+        if(m_Frames.size() == 0 || m_Frames.back().HasKey)
+        {
+            throw OperationException(g_ErrorEmitterState);
+        }
+
+        if(m_Config.Style != SerializeConfig::BlockStyle)
+        {
+            m_pSink->Put(m_Frames.back().IsMap ? '}' : ']');
+        }
+        m_Frames.pop_back();
+        EndValue();
+    }
+
+    void Emitter::Key(const std::string & key)
+    {
+        Key(key.c_str(), key.size());
+    }
+
+    void Emitter::Key(const char * key, const size_t size)
+    {
+        if(m_Frames.size() == 0 || m_Frames.back().IsMap == false || m_Frames.back().HasKey)
+        {
+            throw OperationException(g_ErrorEmitterState);
+        }
+
+        Frame & frame = m_Frames.back();
+        if(m_Config.Style != SerializeConfig::BlockStyle)
+        {
+            if(frame.Count > 0)
+            {
+                impl::EncodeFlowSeparator(*m_pSink, m_Config);
+            }
+            impl::EncodeFlowKey(*m_pSink, key, size, m_Config);
+        }
+        else
+        {
+            if(frame.UseLevel || frame.Count > 0)
+            {
+                m_pSink->Spaces(frame.Level);
+            }
+            impl::EncodeKey(*m_pSink, key, size);
+        }
+
+        frame.Count++;
+        frame.HasKey = true;
+    }
+
+    size_t Emitter::Depth() const
+    {
+        return m_Frames.size();
+    }
+
+    bool Emitter::IsComplete() const
+    {
+        return m_Complete;
+    }
+
+    void Emitter::Begin(const bool isMap)
+    {
+        bool useLevel = false;
+        size_t level = 0;
+        BeginValue(isMap ? Node::MapType : Node::SequenceType, useLevel, level);
+
+        Frame frame;
+        frame.IsMap = isMap;
+        frame.UseLevel = useLevel;
+        frame.Level = level;
+        frame.Count = 0;
+        frame.HasKey = false;
+        m_Frames.push_back(frame);
+
+        if(m_Config.Style != SerializeConfig::BlockStyle)
+        {
+            m_pSink->Put(isMap ? '{' : '[');
+        }
+    }
+
+    bool Emitter::BeginValue(const Node::eType type, bool & useLevel, size_t & level)
+    {
+        if(m_Complete || (m_Frames.size() && m_Frames.back().IsMap && m_Frames.back().HasKey == false))
+        {
+            throw OperationException(g_ErrorEmitterState);
+        }
+
+        useLevel = false;
+        level = 0;
+        if(m_Frames.size())
+        {
+            // Entry header, equal to SerializeLoop.
+            Frame & frame = m_Frames.back();
+            if(m_Config.Style != SerializeConfig::BlockStyle)
+            {
+                if(frame.IsMap == false && frame.Count++ > 0)
+                {
+                    impl::EncodeFlowSeparator(*m_pSink, m_Config);
+                }
+            }
+            else if(frame.IsMap)
+            {
+                if(type == Node::SequenceType || type == Node::MapType || m_Config.MapScalarNewline)
+                {
+                    useLevel = true;
+                    m_pSink->Put('\n');
+                }
+                level = frame.Level + m_Config.SpaceIndentation;
+            }
+            else
+            {
+                m_pSink->Spaces(frame.Level);
+                m_pSink->Write("- ", 2);
+                if(type == Node::SequenceType || (type == Node::MapType && m_Config.SequenceMapNewline))
+                {
+                    useLevel = true;
+                    m_pSink->Put('\n');
+                }
+                level = frame.Level + 2;
+                frame.Count++;
+            }
+            frame.HasKey = false;
+        }
+
+        // Values of None type are written as null, following written keys.
+        if(type == Node::None)
+        {
+            impl::EncodePlainScalar(*m_pSink, "", 0, useLevel, level, m_Config);
+            return false;
+        }
+        return true;
+    }
+
+    void Emitter::EndValue()
+    {
+        if(m_Frames.size() == 0)
+        {
+            m_Complete = true;
+            if(m_Config.Style != SerializeConfig::BlockStyle)
+            {
+                m_pSink->Put('\n');
+            }
+        }
+    }
+
+
+    // Encoding implementations.
+    namespace impl
+    {
+
+        void CheckSerializeConfig(const SerializeConfig & config)
+        {
+            if(config.SpaceIndentation < 2)
+            {
+                throw OperationException(g_ErrorIndentation);
+            }
+        }
+
+        void EncodeScalar(Sink & sink, const std::string & value, const bool plain, const bool useLevel,
+                          const size_t level, const SerializeConfig & config, const bool cite)
+        {
+            if(config.Style != SerializeConfig::BlockStyle)
+            {
+                EncodeFlowScalar(sink, value.c_str(), value.size(), plain, config, cite);
+                return;
+            }
+
+            // Empty scalar
+            if(value.size() == 0)
+            {
+                sink.Put('\n');
+                return;
+            }
+
+            // Typed scalar, written as plain scalar.
+            if(plain)
+            {
+                EncodePlainScalar(sink, value.c_str(), value.size(), useLevel, level, config);
+                return;
+            }
+
+            // Single line, written without splitting.
+            if(value.find('\n') == std::string::npos &&
+               (config.ScalarMaxLength == 0 || value.size() <= config.ScalarMaxLength))
+            {
+                if(useLevel)
+                {
+                    sink.Spaces(level);
+                }
+
+                if(cite || ShouldBeCited(value))
+                {
+                    sink.Put('"');
+                    sink.Write(value);
+                    sink.Write("\"\n", 2);
+                    return;
+                }
+                sink.Write(value);
+                sink.Put('\n');
+                return;
+            }
+
+            // Get lines of scalar.
+            std::string line = "";
+            std::vector<std::string> lines;
+            std::istringstream iss(value);
+            while (iss.eof() == false)
+            {
+                std::getline(iss, line);
+                lines.push_back(line);
+            }
+
+            // Block scalar
+            const std::string & lastLine = lines.back();
+            const bool endNewline = lastLine.size() == 0;
+            if(endNewline)
+            {
+                lines.pop_back();
+            }
+
+            // Literal
+            if(lines.size() > 1)
+            {
+                sink.Put('|');
+            }
+            // Folded/plain
+            else
+            {
+                const std::string frontLine = lines.front();
+                if(config.ScalarMaxLength == 0 || lines.front().size() <= config.ScalarMaxLength ||
+                   LineFolding(frontLine, lines, config.ScalarMaxLength) == 1)
+                {
+                    if(useLevel)
+                    {
+                        sink.Spaces(level);
+                    }
+
+                    if(ShouldBeCited(value))
+                    {
+                        sink.Put('"');
+                        sink.Write(value);
+                        sink.Write("\"\n", 2);
+                        return;
+                    }
+                    sink.Write(value);
+                    sink.Put('\n');
+                    return;
+                }
+                else
+                {
+                    sink.Put('>');
+                }
+            }
+
+            if(endNewline == false)
+            {
+                sink.Put('-');
+            }
+            sink.Put('\n');
+
+
+            for(auto it = lines.begin(); it != lines.end(); it++)
+            {
+                sink.Spaces(level);
+                sink.Write(*it);
+                sink.Put('\n');
+            }
+        }
+
+        void EncodePlainScalar(Sink & sink, const char * data, const size_t size, const bool useLevel, const size_t level,
+                               const SerializeConfig & config)
+        {
+            if(config.Style != SerializeConfig::BlockStyle)
+            {
+                EncodeFlowScalar(sink, data, size, true, config);
+                return;
+            }
+
+            if(size == 0)
+            {
+                sink.Put('\n');
+                return;
+            }
+
+            if(useLevel)
+            {
+                sink.Spaces(level);
+            }
+            sink.Write(data, size);
+            sink.Put('\n');
+        }
+
+        void EncodeKey(Sink & sink, const char * key, const size_t size)
+        {
+            // Fast path, key without tokens to cite or escape.
+            const char * pEnd = key + size;
+            const char * pCur = key;
+            while(pCur != pEnd && std::strchr("\":{}[],&*#?|-<>=!%@\\", *pCur) == nullptr)
+            {
+                ++pCur;
+            }
+            if(pCur == pEnd)
+            {
+                sink.Write(key, size);
+                sink.Write(": ", 2);
+                return;
+            }
+
+            std::string escapedKey(key, size);
+            AddEscapeTokens(escapedKey, "\\\"");
+            if(ShouldBeCited(escapedKey))
+            {
+                sink.Put('"');
+                sink.Write(escapedKey);
+                sink.Write("\": ", 3);
+            }
+            else
+            {
+                sink.Write(escapedKey);
+                sink.Write(": ", 2);
+            }
+        }
+
+        void EncodeNode(Sink & sink, const Node & node, const bool useLevel, const size_t level, const SerializeConfig & config)
+        {
+            if(config.Style != SerializeConfig::BlockStyle)
+            {
+                SerializeFlow(node, sink, config);
+                return;
+            }
+            SerializeLoop(node, sink, useLevel, level, config);
+        }
+
+        void EncodeFlowScalar(Sink & sink, const char * data, const size_t size, const bool plain, const SerializeConfig & config,
+                              const bool cite)
+        {
+            const bool json = config.Style == SerializeConfig::JsonStyle;
+            if(plain)
+            {
+                if(json == false)
+                {
+                    if(size == 0)
+                    {
+                        sink.Put('~');
+                        return;
+                    }
+                    sink.Write(data, size);
+                    return;
+                }
+
+                // Plain JSON scalar, converted to JSON literal if needed.
+                if(IsJsonNumber(data, size) || (size == 4 && std::memcmp(data, "true", 4) == 0) ||
+                   (size == 5 && std::memcmp(data, "false", 5) == 0) || (size == 4 && std::memcmp(data, "null", 4) == 0))
+                {
+                    sink.Write(data, size);
+                    return;
+                }
+
+                impl::ScalarValue value;
+                if(ParseScalarValue(std::string(data, size), value))
+                {
+                    char buffer[32];
+                    switch(value.Type)
+                    {
+                    case impl::ScalarValue::NullType:
+                        sink.Write("null", 4);
+                        return;
+                    case impl::ScalarValue::BooleanType:
+                        sink.Write(value.Boolean ? "true" : "false", value.Boolean ? 4 : 5);
+                        return;
+                    case impl::ScalarValue::IntegerType:
+                        sink.Write(buffer, FormatInteger(buffer, value.Integer));
+                        return;
+                    case impl::ScalarValue::FloatType:
+                        if(std::isfinite(value.Float))
+                        {
+                            sink.Write(buffer, FormatFloat(buffer, value.Float));
+                            return;
+                        }
+                        break;
+                    default:
+                        break;
+                    }
+                }
+            }
+            else if(json == false && cite == false && size > 0 && ShouldBeFlowQuoted(data, size) == false)
+            {
+                sink.Write(data, size);
+                return;
+            }
+
+            EncodeQuoted(sink, data, size, json);
+        }
+
+        void EncodeFlowKey(Sink & sink, const char * key, const size_t size, const SerializeConfig & config)
+        {
+            if(config.Style == SerializeConfig::JsonStyle)
+            {
+                EncodeQuoted(sink, key, size, true);
+                sink.Put(':');
+                return;
+            }
+
+            if(size > 0 && ShouldBeFlowQuoted(key, size) == false)
+            {
+                sink.Write(key, size);
+            }
+            else
+            {
+                EncodeQuoted(sink, key, size, false);
+            }
+            sink.Write(": ", 2);
+        }
+
+        void EncodeFlowSeparator(Sink & sink, const SerializeConfig & config)
+        {
+            if(config.Style == SerializeConfig::JsonStyle)
+            {
+                sink.Put(',');
+                return;
+            }
+            sink.Write(", ", 2);
+        }
+
+        size_t FormatUnsignedInteger(char * buffer, const uint64_t value)
+        {
+            char digits[24];
+            size_t count = 0;
+            uint64_t left = value;
+            do
+            {
+                digits[count++] = static_cast<char>('0' + (left % 10));
+                left /= 10;
+            }
+            while(left > 0);
+
+            for(size_t i = 0; i < count; i++)
+            {
+                buffer[i] = digits[count - i - 1];
+            }
+            buffer[count] = '\0';
+            return count;
+        }
+
+        size_t FormatInteger(char * buffer, const int64_t value)
+        {
+            if(value < 0)
+            {
+                buffer[0] = '-';
+                return FormatUnsignedInteger(buffer + 1, 0 - static_cast<uint64_t>(value)) + 1;
+            }
+            return FormatUnsignedInteger(buffer, static_cast<uint64_t>(value));
+        }
+
+        size_t FormatFloat(char * buffer, const double value)
+        {
+            const char * pSpecial = nullptr;
+            if(value != value)
+            {
+                pSpecial = ".nan";
+            }
+            else if(value == std::numeric_limits<double>::infinity())
+            {
+                pSpecial = ".inf";
+            }
+            else if(value == -std::numeric_limits<double>::infinity())
+            {
+                pSpecial = "-.inf";
+            }
+            if(pSpecial)
+            {
+                std::strcpy(buffer, pSpecial);
+                return std::strlen(buffer);
+            }
+
+            // Shortest of 15, 16 and 17 significant digits, parsed back to equal value.
+            size_t size = 0;
+            for(int precision = 15; precision <= 17; precision++)
+            {
+                size = static_cast<size_t>(snprintf(buffer, 32, "%.*g", precision, value));
+
+                // Decimal point of current locale.
+                for(size_t i = 0; i < size; i++)
+                {
+                    const char c = buffer[i];
+                    if((c < '0' || c > '9') && c != '-' && c != '+' && c != 'e')
+                    {
+                        buffer[i] = '.';
+                    }
+                }
+
+                double parsed = 0.0;
+                if(ParseFloat(buffer, buffer + size, parsed, true) == NumberOk && parsed == value)
+                {
+                    break;
+                }
+            }
+
+            // Keep floating point type, "1" is an integer.
+            if(std::strpbrk(buffer, ".e") == nullptr)
+            {
+                buffer[size++] = '.';
+                buffer[size++] = '0';
+                buffer[size] = '\0';
+            }
+            return size;
+        }
+
+    }
+
+
+
+    // Number parsing implementations.
+    namespace impl
+    {
+
+        static const double g_ExactPowersOfTen[] =
+        {
+            1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        static bool IsSpace(const char c)
+        {
+            return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+        }
+
+        static void TrimSpaces(const char * & pBegin, const char * & pEnd)
+        {
+            while(pBegin != pEnd && IsSpace(*pBegin))
+            {
+                ++pBegin;
+            }
+            while(pEnd != pBegin && IsSpace(*(pEnd - 1)))
+            {
+                --pEnd;
+            }
+        }
+
+        static uint64_t DigitValue(const char c)
+        {
+            if(c >= '0' && c <= '9')
+            {
+                return static_cast<uint64_t>(c - '0');
+            }
+            if(c >= 'a' && c <= 'f')
+            {
+                return static_cast<uint64_t>(c - 'a' + 10);
+            }
+            if(c >= 'A' && c <= 'F')
+            {
+                return static_cast<uint64_t>(c - 'A' + 10);
+            }
+            return 255;
+        }
+
+        static bool Equals(const char * pBegin, const char * pEnd, const char * pWord)
+        {
+            for(; pBegin != pEnd && *pWord != '\0'; ++pBegin, ++pWord)
+            {
+                if(*pBegin != *pWord)
+                {
+                    return false;
+                }
+            }
+            return pBegin == pEnd && *pWord == '\0';
+        }
+
+        static bool EqualsNoCase(const char * pBegin, const char * pEnd, const char * pWord)
+        {
+            for(; pBegin != pEnd && *pWord != '\0'; ++pBegin, ++pWord)
+            {
+                char c = *pBegin;
+                if(c >= 'A' && c <= 'Z')
+                {
+                    c = static_cast<char>(c - 'A' + 'a');
+                }
+                if(c != *pWord)
+                {
+                    return false;
+                }
+            }
+            return pBegin == pEnd && *pWord == '\0';
+        }
+
+        /**
+        * @breif Scan decimal digits of floating point number, separated by underscores if allowed.
+        *        Up to 19 significant digits are accumulated in mantissa.
+        *
+        * @param exponentStep   Exponent change for each digit that does not fit in mantissa,
+        *                       and digits that does fit if fraction is true.
+        *
+        * @return Number of scanned digits.
+        *
+        */
+        static size_t ScanFloatDigits(const char * & pCur, const char * pEnd, const bool underscores, const bool fraction,
+                                      uint64_t & mantissa, size_t & significantDigits, bool & truncated, int64_t & exponent)
+        {
+            size_t count = 0;
+            for(; pCur != pEnd; ++pCur)
+            {
+                const char c = *pCur;
+                if(c == '_' && underscores && count && pCur + 1 != pEnd && pCur[1] >= '0' && pCur[1] <= '9')
+                {
+                    continue;
+                }
+                if(c < '0' || c > '9')
+                {
+                    break;
+                }
+
+                ++count;
+                const uint64_t digit = static_cast<uint64_t>(c - '0');
+                if(significantDigits < 19)
+                {
+                    mantissa = mantissa * 10 + digit;
+                    significantDigits += mantissa ? 1 : 0;
+                    exponent -= fraction ? 1 : 0;
+                }
+                else
+                {
+                    truncated = truncated || digit != 0;
+                    exponent += fraction ? 0 : 1;
+                }
+            }
+            return count;
+        }
+
+        eNumberResult ParseInteger(const char * pBegin, const char * pEnd, bool & negative, uint64_t & magnitude,
+                                   const bool coreSchema)
+        {
+            if(coreSchema == false)
+            {
+                TrimSpaces(pBegin, pEnd);
+            }
+
+            const char * pCur = pBegin;
+            negative = false;
+            magnitude = 0;
+            if(pCur != pEnd && (*pCur == '-' || *pCur == '+'))
+            {
+                negative = *pCur == '-';
+                ++pCur;
+            }
+
+            uint64_t base = 10;
+            if(pEnd - pCur > 2 && pCur[0] == '0' && (pCur[1] == 'x' || pCur[1] == 'o' || (pCur[1] == 'b' && coreSchema == false)))
+            {
+                // Signs of hexadecimal and octal numbers are not part of the core schema.
+                if(coreSchema && pCur != pBegin)
+                {
+                    return NumberInvalid;
+                }
+                base = pCur[1] == 'x' ? 16 : (pCur[1] == 'o' ? 8 : 2);
+                pCur += 2;
+            }
+            if(pCur == pEnd)
+            {
+                return NumberInvalid;
+            }
+
+            bool overflow = false;
+            bool previousDigit = false;
+            for(; pCur != pEnd; ++pCur)
+            {
+                if(*pCur == '_' && coreSchema == false && previousDigit && pCur + 1 != pEnd)
+                {
+                    previousDigit = false;
+                    continue;
+                }
+
+                const uint64_t digit = DigitValue(*pCur);
+                if(digit >= base)
+                {
+                    return NumberInvalid;
+                }
+                previousDigit = true;
+
+                if(magnitude > (std::numeric_limits<uint64_t>::max() - digit) / base)
+                {
+                    overflow = true;
+                    continue;
+                }
+                magnitude = magnitude * base + digit;
+            }
+
+            if(previousDigit == false)
+            {
+                return NumberInvalid;
+            }
+            return overflow ? NumberOutOfRange : NumberOk;
+        }
+
+        eNumberResult ParseFloat(const char * pBegin, const char * pEnd, double & value, const bool coreSchema)
+        {
+            if(coreSchema == false)
+            {
+                TrimSpaces(pBegin, pEnd);
+            }
+
+            const char * pCur = pBegin;
+            bool negative = false;
+            if(pCur != pEnd && (*pCur == '-' || *pCur == '+'))
+            {
+                negative = *pCur == '-';
+                ++pCur;
+            }
+
+            // Infinity and not a number.
+            if(pEnd - pCur == 4 && pCur[0] == '.')
+            {
+                const char * pSpecial = pCur + 1;
+                if(Equals(pSpecial, pEnd, "inf") || Equals(pSpecial, pEnd, "Inf") || Equals(pSpecial, pEnd, "INF"))
+                {
+                    value = negative ? -std::numeric_limits<double>::infinity() : std::numeric_limits<double>::infinity();
+                    return NumberOk;
+                }
+                if(pCur == pBegin && (Equals(pSpecial, pEnd, "nan") || Equals(pSpecial, pEnd, "NaN") || Equals(pSpecial, pEnd, "NAN")))
+                {
+                    value = std::numeric_limits<double>::quiet_NaN();
+                    return NumberOk;
+                }
+            }
+
+            // [-+]? ( \. [0-9]+ | [0-9]+ ( \. [0-9]* )? ) ( [eE] [-+]? [0-9]+ )?
+            const bool underscores = coreSchema == false;
+            uint64_t mantissa = 0;
+            size_t significantDigits = 0;
+            bool truncated = false;
+            int64_t exponent = 0;
+
+            const char * pDigits = pCur;
+            const size_t integerDigits = ScanFloatDigits(pCur, pEnd, underscores, false, mantissa, significantDigits, truncated, exponent);
+            size_t fractionDigits = 0;
+            if(pCur != pEnd && *pCur == '.')
+            {
+                ++pCur;
+                fractionDigits = ScanFloatDigits(pCur, pEnd, underscores, true, mantissa, significantDigits, truncated, exponent);
+            }
+            if(integerDigits == 0 && fractionDigits == 0)
+            {
+                return NumberInvalid;
+            }
+            const char * pDigitsEnd = pCur;
+
+            int64_t exponentPart = 0;
+            if(pCur != pEnd && (*pCur == 'e' || *pCur == 'E'))
+            {
+                ++pCur;
+                bool negativeExponent = false;
+                if(pCur != pEnd && (*pCur == '-' || *pCur == '+'))
+                {
+                    negativeExponent = *pCur == '-';
+                    ++pCur;
+                }
+                const char * pExponent = pCur;
+                for(; pCur != pEnd && *pCur >= '0' && *pCur <= '9'; ++pCur)
+                {
+                    if(exponentPart < 100000)
+                    {
+                        exponentPart = exponentPart * 10 + (*pCur - '0');
+                    }
+                }
+                if(pCur == pExponent)
+                {
+                    return NumberInvalid;
+                }
+                exponentPart = negativeExponent ? -exponentPart : exponentPart;
+            }
+            if(pCur != pEnd)
+            {
+                return NumberInvalid;
+            }
+            exponent += exponentPart;
+
+            // Fast path, mantissa and power of ten are exact, making the result correctly rounded.
+            if(mantissa == 0)
+            {
+                value = negative ? -0.0 : 0.0;
+                return NumberOk;
+            }
+            if(truncated == false && mantissa <= (static_cast<uint64_t>(1) << 53) && exponent >= -22 && exponent <= 22)
+            {
+                const double result = static_cast<double>(mantissa);
+                value = exponent < 0 ? result / g_ExactPowersOfTen[-exponent] : result * g_ExactPowersOfTen[exponent];
+                value = negative ? -value : value;
+                return NumberOk;
+            }
+
+            // Slow path, strtod of digits without decimal point, independent of locale.
+            char buffer[128];
+            std::string longBuffer;
+            const size_t maxSize = static_cast<size_t>(pDigitsEnd - pDigits) + 24;
+            char * pBuffer = buffer;
+            if(maxSize > sizeof(buffer))
+            {
+                longBuffer.resize(maxSize);
+                pBuffer = &longBuffer[0];
+            }
+
+            char * pOut = pBuffer;
+            *pOut++ = negative ? '-' : '+';
+            for(const char * pIn = pDigits; pIn != pDigitsEnd; ++pIn)
+            {
+                if(*pIn >= '0' && *pIn <= '9')
+                {
+                    *pOut++ = *pIn;
+                }
+            }
+            snprintf(pOut, 24, "e%lld", static_cast<long long>(exponentPart - static_cast<int64_t>(fractionDigits)));
+
+            errno = 0;
+            value = std::strtod(pBuffer, nullptr);
+            if(errno == ERANGE && (value == HUGE_VAL || value == -HUGE_VAL))
+            {
+                return NumberOutOfRange;
+            }
+            return NumberOk;
+        }
+
+        eNumberResult ParseBoolean(const char * pBegin, const char * pEnd, bool & value)
+        {
+            TrimSpaces(pBegin, pEnd);
+
+            if(EqualsNoCase(pBegin, pEnd, "true") || EqualsNoCase(pBegin, pEnd, "yes") || EqualsNoCase(pBegin, pEnd, "1"))
+            {
+                value = true;
+                return NumberOk;
+            }
+            if(EqualsNoCase(pBegin, pEnd, "false") || EqualsNoCase(pBegin, pEnd, "no") || EqualsNoCase(pBegin, pEnd, "0"))
+            {
+                value = false;
+                return NumberOk;
+            }
+
+            return NumberInvalid;
+        }
+
+        void ParseScalarNumber(const char * pBegin, const char * pEnd, const ScalarNumber::eKind kind, ScalarNumber & number)
+        {
+            number.Kind = kind;
+            switch(kind)
+            {
+            case ScalarNumber::IntegerKind:
+                number.Result = ParseInteger(pBegin, pEnd, number.Negative, number.Magnitude);
+                if(number.Result == NumberInvalid)
+                {
+                    number.Kind = ScalarNumber::FallbackKind;
+                    number.Negative = false;
+                    number.Magnitude = 0;
+                    number.Result = ParseFloat(pBegin, pEnd, number.Float);
+                }
+                break;
+            case ScalarNumber::FloatKind:
+            case ScalarNumber::FallbackKind:
+                number.Result = ParseFloat(pBegin, pEnd, number.Float);
+                break;
+            case ScalarNumber::BooleanKind:
+                number.Result = ParseBoolean(pBegin, pEnd, number.Boolean);
+                break;
+            default:
+                number.Result = NumberInvalid;
+                break;
+            }
+        }
+
+    }
+
+
+
+    // Static function implementations
+    std::string ExceptionMessage(const std::string & message, ReaderLine & line)
+    {
+        return message + std::string(" Line ") + std::to_string(line.No) + std::string(": ") + line.Data;
+    }
+
+    std::string ExceptionMessage(const std::string & message, ReaderLine & line, const size_t errorPos)
+    {
+        return message + std::string(" Line ") + std::to_string(line.No) + std::string(" column ") + std::to_string(errorPos + 1) + std::string(": ") + line.Data;
+    }
+
+    std::string ExceptionMessage(const std::string & message, const size_t errorLine, const size_t errorPos)
+    {
+        return message + std::string(" Line ") + std::to_string(errorLine) + std::string(" column ") + std::to_string(errorPos);
+    }
+
+    std::string ExceptionMessage(const std::string & message, const size_t errorLine, const std::string & data)
+    {
+        return message + std::string(" Line ") + std::to_string(errorLine) + std::string(": ") + data;
+    }
+
+    void ScanCharacters(const char * data, size_t pos, const size_t size, std::vector<size_t> & lineEnds, std::vector<size_t> & invalidPositions)
+    {
+        const unsigned char * pData = reinterpret_cast<const unsigned char *>(data);
+
+        while(pos < size)
+        {
+#if defined(YAML_SSE2)
+            // Fast path, 16 characters at a time as long as all of them are printable ASCII, tabs or line ends.
+            const __m128i spaceMask = _mm_set1_epi8(' ');
+            const __m128i deleteMask = _mm_set1_epi8(127);
+            const __m128i newlineMask = _mm_set1_epi8('\n');
+            const __m128i returnMask = _mm_set1_epi8('\r');
+            const __m128i tabMask = _mm_set1_epi8('\t');
+            while(pos + 16 <= size)
+            {
+                const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pData + pos));
+
+                // Signed comparison, control characters and all non-ASCII bytes are "less than" space.
+                const int special = _mm_movemask_epi8(_mm_or_si128(_mm_cmplt_epi8(block, spaceMask), _mm_cmpeq_epi8(block, deleteMask)));
+                const int newlines = _mm_movemask_epi8(_mm_cmpeq_epi8(block, newlineMask));
+                const int returns = _mm_movemask_epi8(_mm_cmpeq_epi8(block, returnMask)) & (newlines >> 1);
+                const int tabs = _mm_movemask_epi8(_mm_cmpeq_epi8(block, tabMask));
+                if(special & ~(newlines | returns | tabs))
+                {
+                    break;
+                }
+
+                unsigned int lineMask = static_cast<unsigned int>(newlines);
+                while(lineMask)
+                {
+#if defined(_MSC_VER)
+                    unsigned long index = 0;
+                    _BitScanForward(&index, lineMask);
+#else
+                    const unsigned int index = static_cast<unsigned int>(__builtin_ctz(lineMask));
+#endif
+                    lineEnds.push_back(pos + index);
+                    lineMask &= lineMask - 1;
+                }
+                pos += 16;
+            }
+            const size_t blockEnd = std::min(pos + 16, size);
+#else
+            const size_t blockEnd = size;
+#endif
+
+            // Slow path, one character or UTF-8 sequence at a time.
+            while(pos < blockEnd)
+            {
+                const unsigned char c = pData[pos];
+                if(c < 0x80)
+                {
+                    if(c == '\n')
+                    {
+                        lineEnds.push_back(pos);
+                    }
+                    else if(c == 127 || (c < 32 && c != '\t' && (c != '\r' || (pos + 1 < size && pData[pos + 1] != '\n'))))
+                    {
+                        invalidPositions.push_back(pos);
+                    }
+                    pos++;
+                    continue;
+                }
+
+                const size_t length = Utf8SequenceLength(pData + pos, size - pos);
+                if(length == 0)
+                {
+                    invalidPositions.push_back(pos);
+                    pos++;
+                    continue;
+                }
+                pos += length;
+            }
+        }
+    }
+
+    size_t Utf8SequenceLength(const unsigned char * data, const size_t size)
+    {
+        const unsigned char c = data[0];
+        unsigned char min = 0x80;
+        unsigned char max = 0xBF;
+        size_t length = 0;
+
+        if(c >= 0xC2 && c <= 0xDF)
+        {
+            length = 2;
+        }
+        else if(c >= 0xE0 && c <= 0xEF)
+        {
+            length = 3;
+            min = c == 0xE0 ? 0xA0 : min; // Overlong encoding.
+            max = c == 0xED ? 0x9F : max; // Surrogates.
+        }
+        else if(c >= 0xF0 && c <= 0xF4)
+        {
+            length = 4;
+            min = c == 0xF0 ? 0x90 : min; // Overlong encoding.
+            max = c == 0xF4 ? 0x8F : max; // Larger than U+10FFFF.
+        }
+        else
+        {
+            return 0;
+        }
+
+        if(length > size || data[1] < min || data[1] > max)
+        {
+            return 0;
+        }
+        for(size_t i = 2; i < length; i++)
+        {
+            if(data[i] < 0x80 || data[i] > 0xBF)
+            {
+                return 0;
+            }
+        }
+
+        return length;
+    }
+
+    bool ParseScalarValue(const std::string & data, impl::ScalarValue & value)
+    {
+        value = impl::ScalarValue();
+
+        if(data.size() == 0 || data == "~" || data == "null" || data == "Null" || data == "NULL")
+        {
+            value.Type = impl::ScalarValue::NullType;
+            return true;
+        }
+        if(data == "true" || data == "True" || data == "TRUE")
+        {
+            value.Type = impl::ScalarValue::BooleanType;
+            value.Boolean = true;
+            return true;
+        }
+        if(data == "false" || data == "False" || data == "FALSE")
+        {
+            value.Type = impl::ScalarValue::BooleanType;
+            value.Boolean = false;
+            return true;
+        }
+
+        int64_t integer = 0;
+        if(ParseIntegerValue(data, integer))
+        {
+            value.Type = impl::ScalarValue::IntegerType;
+            value.Integer = integer;
+            return true;
+        }
+
+        double floating = 0.0;
+        if(ParseFloatValue(data, floating))
+        {
+            value.Type = impl::ScalarValue::FloatType;
+            value.Float = floating;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool ParseTaggedScalarValue(const std::string & data, const std::string & tag, impl::ScalarValue & value)
+    {
+        if(tag == "!!str" || tag == "!")
+        {
+            value = impl::ScalarValue();
+            return true;
+        }
+
+        impl::ScalarValue tagged;
+        if(tag == "!!int")
+        {
+            tagged.Type = impl::ScalarValue::IntegerType;
+            if(ParseIntegerValue(data, tagged.Integer) == false)
+            {
+                return false;
+            }
+        }
+        else if(tag == "!!float")
+        {
+            tagged.Type = impl::ScalarValue::FloatType;
+            if(ParseFloatValue(data, tagged.Float) == false)
+            {
+                int64_t integer = 0;
+                if(ParseIntegerValue(data, integer) == false)
+                {
+                    return false;
+                }
+                tagged.Float = static_cast<double>(integer);
+            }
+        }
+        else if(tag == "!!bool" || tag == "!!null")
+        {
+            const impl::ScalarValue::eType type = tag == "!!bool" ? impl::ScalarValue::BooleanType : impl::ScalarValue::NullType;
+            if(ParseScalarValue(data, tagged) == false || tagged.Type != type)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            // Unknown tags are ignored.
+            return true;
+        }
+
+        value = tagged;
+        return true;
+    }
+
+    bool ParseIntegerValue(const std::string & data, int64_t & value)
+    {
+        bool negative = false;
+        uint64_t magnitude = 0;
+        if(impl::ParseInteger(data.c_str(), data.c_str() + data.size(), negative, magnitude, true) != impl::NumberOk ||
+           magnitude > static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + (negative ? 1 : 0))
+        {
+            return false;
+        }
+
+        value = negative ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+        return true;
+    }
+
+    bool ParseFloatValue(const std::string & data, double & value)
+    {
+        return impl::ParseFloat(data.c_str(), data.c_str() + data.size(), value, true) == impl::NumberOk;
+    }
+
+    bool FindQuote(const std::string & input, size_t & start, size_t & end, size_t searchPos)
+    {
+        start = end = std::string::npos;
+        size_t qPos = searchPos;
+        bool foundStart = false;
+
+        while(qPos != std::string::npos)
+        {
+            // Find first quote.
+            qPos = input.find_first_of("\"'", qPos);
+            if(qPos == std::string::npos)
+            {
+                return false;
+            }
+
+            const char token = input[qPos];
+            if(token == '"' && (qPos == 0 || input[qPos-1] != '\\'))
+            {
+                // Found start quote.
+                if(foundStart == false)
+                {
+                    start = qPos;
+                    foundStart = true;
+                }
+                // Found end quote
+                else
+                {
+                    end = qPos;
+                    return true;
+                }
+            }
+
+            // Check if it's possible for another loop.
+            if(qPos + 1 == input.size())
+            {
+                return false;
+            }
+            qPos++;
+        }
+
+        return false;
+    }
+
+    size_t FindNotCited(const std::string & input, char token, size_t & preQuoteCount)
+    {
+        preQuoteCount = 0;
+        size_t tokenPos = input.find_first_of(token);
+        if(tokenPos == std::string::npos)
+        {
+            return std::string::npos;
+        }
+
+        // Find all quotes
+        std::vector<std::pair<size_t, size_t>> quotes;
+
+        size_t quoteStart = 0;
+        size_t quoteEnd = 0;
+        while(FindQuote(input, quoteStart, quoteEnd, quoteEnd))
+        {
+            quotes.push_back({quoteStart, quoteEnd});
+
+            if(quoteEnd + 1 == input.size())
+            {
+                break;
+            }
+            quoteEnd++;
+        }
+
+        if(quotes.size() == 0)
+        {
+            return tokenPos;
+        }
+
+        size_t currentQuoteIndex = 0;
+        std::pair<size_t, size_t> currentQuote = {0, 0};
+
+        while(currentQuoteIndex < quotes.size())
+        {
+            currentQuote = quotes[currentQuoteIndex];
+
+            if(tokenPos < currentQuote.first)
+            {
+                return tokenPos;
+            }
+            preQuoteCount++;
+            if(tokenPos <= currentQuote.second)
+            {
+                // Find next token
+                if(tokenPos + 1 == input.size())
+                {
+                    return std::string::npos;
+                }
+                tokenPos = input.find_first_of(token, tokenPos + 1);
+                if(tokenPos == std::string::npos)
+                {
+                    return std::string::npos;
+                }
+            }
+
+            currentQuoteIndex++;
+        }
+
+        return tokenPos;
+    }
+
+    size_t FindNotCited(const std::string & input, char token)
+    {
+        size_t dummy = 0;
+        return FindNotCited(input, token, dummy);
+    }
+
+    bool ValidateQuote(const std::string & input)
+    {
+        if(input.size() == 0)
+        {
+            return true;
+        }
+
+        char token = 0;
+        size_t searchPos = 0;
+        if(input[0] == '\"' || input[0] == '\'')
+        {
+            if(input.size() == 1)
+            {
+                return false;
+            }
+            token = input[0];
+            searchPos = 1;
+        }
+
+        while(searchPos != std::string::npos && searchPos < input.size() - 1)
+        {
+            searchPos = input.find_first_of("\"'", searchPos + 1);
+            if(searchPos == std::string::npos)
+            {
+                break;
+            }
+
+            const char foundToken = input[searchPos];
+
+            if(input[searchPos] == '\"' || input[searchPos] == '\'')
+            {
+                if(token == 0 && input[searchPos-1] != '\\')
+                {
+                    return false;
+                }
+                //if(foundToken == token)
+                //{
+
+                    /*if(foundToken == token && searchPos == input.size() - 1 && input[searchPos-1] != '\\')
+                    {
+                        return true;
+                        if(searchPos == input.size() - 1)
+                        {
+                            return true;
+                        }
+                        return false;
+                    }
+                    else */
+                    if(foundToken == token && input[searchPos-1] != '\\')
+                    {
+                        if(searchPos == input.size() - 1)
+                        {
+                            return true;
+                        }
+                        return false;
+                    }
+                //}
+            }
+        }
+
+        return token == 0;
+    }
+
+    void CopyNode(const Node & from, Node & to)
+    {
+        const Node::eType type = from.Type();
+
+        switch(type)
+        {
+        case Node::SequenceType:
+            for(auto it = from.Begin(); it != from.End(); it++)
+            {
+                const Node & currentNode = (*it).second;
+                Node & newNode = to.PushBack();
+                CopyNode(currentNode, newNode);
+            }
+            break;
+        case Node::MapType:
+            for(auto it = from.Begin(); it != from.End(); it++)
+            {
+                const Node & currentNode = (*it).second;
+                Node & newNode = to[(*it).first];
+                CopyNode(currentNode, newNode);
+            }
+            break;
+        case Node::ScalarType:
+            to = from.As<std::string>();
+            static_cast<ScalarImp*>(NODE_IMP_EXT(to)->m_pImp)->m_Native = static_cast<ScalarImp*>(NODE_IMP_EXT(from)->m_pImp)->m_Native;
+            static_cast<ScalarImp*>(NODE_IMP_EXT(to)->m_pImp)->m_Quoted = static_cast<ScalarImp*>(NODE_IMP_EXT(from)->m_pImp)->m_Quoted;
+            break;
+        case Node::None:
+            break;
+        }
+    }
+
+    bool ShouldBeCited(const std::string & key)
+    {
+        return key.find_first_of("\":{}[],&*#?|-<>=!%@") != std::string::npos;
+    }
+
+    bool IsCitedScalar(const Node & node)
+    {
+        const ScalarImp * pScalarImp = static_cast<const ScalarImp*>(NODE_IMP_EXT(node)->m_pImp);
+        return pScalarImp->m_Quoted && ResolvesToTypedValue(pScalarImp->m_Value.c_str(), pScalarImp->m_Value.size());
+    }
+
+    bool ResolvesToTypedValue(const char * data, const size_t size)
+    {
+        // Fast path, typed values start with a digit, sign, dot, tilde or first letter of null, true or false.
+        if(size == 0 || std::strchr("0123456789+-.~nNtTfF", data[0]) == nullptr)
+        {
+            return false;
+        }
+
+        impl::ScalarValue value;
+        return ParseScalarValue(std::string(data, size), value);
+    }
+
+    void AddEscapeTokens(std::string & input, const std::string & tokens)
+    {
+        for(auto it = tokens.begin(); it != tokens.end(); it++)
+        {
+            const char token = *it;
+            const std::string replace = std::string("\\") + std::string(1, token);
+            size_t found = input.find_first_of(token);
+            while(found != std::string::npos)
+            {
+                input.replace(found, 1, replace);
+                found = input.find_first_of(token, found + 2);
+            }
+        }
+    }
+
+    void RemoveAllEscapeTokens(std::string & input)
+    {
+        size_t found = input.find_first_of("\\");
+        while(found != std::string::npos)
+        {
+            if(found + 1 == input.size())
+            {
+                return;
+            }
+
+            std::string replace(1, input[found + 1]);
+            input.replace(found, 2, replace);
+            found = input.find_first_of("\\", found + 1);
+        }
+    }
+
+    uint64_t SequenceVersion(const Node & node)
+    {
+        if(node.IsSequence() == false)
+        {
+            return 0;
+        }
+        return static_cast<SequenceImp*>(NODE_IMP_EXT(node)->m_pImp)->m_Version;
+    }
+
+    void CollectIndexKeys(const Node & element, const std::vector<std::string> & fields, const size_t field,
+                          const std::string & prefix, std::vector<std::string> & keys)
+    {
+        if(field == fields.size())
+        {
+            keys.push_back(prefix);
+            return;
+        }
+
+        const Node * pValue = element.Find(fields[field]);
+        if(pValue == nullptr)
         {
-            pImp = new ParseImp;
-            pImp->Parse(root, stream);
-            delete pImp;
+            return;
         }
-        catch (const Exception e)
+
+        // Fields of sequences are multi-valued, producing one key per scalar.
+        const size_t count = pValue->IsSequence() ? pValue->Size() : 1;
+        for(size_t i = 0; i < count; i++)
         {
-            delete pImp;
-            throw;
+            const Node * pScalar = pValue->IsSequence() ? pValue->Find(i) : pValue;
+            if(pScalar->IsScalar() == false)
+            {
+                continue;
+            }
+
+            const std::string & data = NODE_IMP_EXT((*pScalar))->m_pImp->GetData();
+            if(fields.size() == 1)
+            {
+                keys.push_back(data);
+                continue;
+            }
+
+            std::string key = prefix;
+            AppendIndexKeyPart(key, data);
+            CollectIndexKeys(element, fields, field + 1, key, keys);
         }
     }
 
-    void Parse(Node & root, const std::string & string)
+    void AppendIndexKeyPart(std::string & key, const std::string & part)
     {
-        std::stringstream ss(string);
-        Parse(root, ss);
+        // Length prefixed, making keys of different value splits unique.
+        key += std::to_string(part.size());
+        key += ':';
+        key += part;
     }
 
-    void Parse(Node & root, const char * buffer, const size_t size)
+    int OpenOutputFile(const char * filename, const bool exclusive)
     {
-        std::stringstream ss(std::string(buffer, size));
-        Parse(root, ss);
+    #if defined(_WIN32)
+        return _open(filename, _O_WRONLY | _O_CREAT | (exclusive ? _O_EXCL : 0), _S_IREAD | _S_IWRITE);
+    #else
+        return ::open(filename, O_WRONLY | O_CREAT | O_CLOEXEC | (exclusive ? O_EXCL : 0), 0666);
+    #endif
     }
 
-
-    // Serialize configuration structure.
-    SerializeConfig::SerializeConfig(const size_t spaceIndentation,
-                                     const size_t scalarMaxLength,
-                                     const bool sequenceMapNewline,
-                                     const bool mapScalarNewline) :
-        SpaceIndentation(spaceIndentation),
-        ScalarMaxLength(scalarMaxLength),
-        SequenceMapNewline(sequenceMapNewline),
-        MapScalarNewline(mapScalarNewline)
+    bool CloseFile(const int fd)
     {
+    #if defined(_WIN32)
+        return _close(fd) == 0;
+    #else
+        return ::close(fd) == 0;
+    #endif
     }
 
-
-    // Serialization functions
-    void Serialize(const Node & root, const char * filename, const SerializeConfig & config)
+    bool TruncateFile(const int fd, const bool onlyIfWritten)
     {
-        std::stringstream stream;
-        Serialize(root, stream, config);
-
-        std::ofstream f(filename);
-        if (f.is_open() == false)
+        // Truncated at current position, the end of written data.
+    #if defined(_WIN32)
+        const long long position = _lseeki64(fd, 0, SEEK_CUR);
+        if(position < 0 || (onlyIfWritten && position == 0))
         {
-            throw OperationException(g_ErrorCannotOpenFile);
+            return position == 0;
         }
-
-        f.write(stream.str().c_str(), stream.str().size());
-        f.close();
+        return _chsize_s(fd, position) == 0;
+    #else
+        // Pipes and devices have no size to truncate.
+        struct stat status;
+        if(fstat(fd, &status) != 0 || S_ISREG(status.st_mode) == false)
+        {
+            return true;
+        }
+        const off_t position = lseek(fd, 0, SEEK_CUR);
+        if(position < 0 || (onlyIfWritten && position == 0))
+        {
+            return position == 0;
+        }
+        return ftruncate(fd, position) == 0;
+    #endif
     }
 
-    size_t LineFolding(const std::string & input, std::vector<std::string> & folded, const size_t maxLength)
+    void WriteFileData(const Node & root, const int fd, const SerializeConfig & config, const FileConfig & fileConfig, const bool sync)
     {
-        folded.clear();
-        if(input.size() == 0)
+        FileSink sink(fd, fileConfig.BufferSize);
+        try
         {
-            return 0;
+            Serialize(root, sink, config);
         }
-
-        size_t currentPos = 0;
-        size_t lastPos = 0;
-        size_t spacePos = std::string::npos;
-        while(currentPos < input.size())
+        catch(...)
         {
-            currentPos = lastPos + maxLength;
+            // Buffered data of failed serialization is not written by destructor.
+            sink.Discard();
+            throw;
+        }
+        sink.Flush();
 
-            if(currentPos < input.size())
+        if(sync)
+        {
+        #if defined(_WIN32)
+            const bool synced = _commit(fd) == 0;
+        #else
+            const bool synced = fsync(fd) == 0;
+        #endif
+            if(synced == false)
             {
-               spacePos = input.find_first_of(' ', currentPos);
+                throw OperationException(g_ErrorWriteFile);
             }
+        }
+    }
 
-            if(spacePos == std::string::npos || currentPos >= input.size())
+    void WriteFileAtomic(const Node & root, const char * filename, const SerializeConfig & config, const FileConfig & fileConfig)
+    {
+        static std::atomic<unsigned int> tempCounter(0);
+
+    #if defined(_WIN32)
+        const std::string pid = std::to_string(_getpid());
+    #else
+        const std::string pid = std::to_string(getpid());
+
+        // Replacing file keeps mode and ownership of target file.
+        struct stat targetStatus;
+        const bool targetExists = stat(filename, &targetStatus) == 0;
+    #endif
+        const std::string target = filename;
+        std::string tempName;
+        int fd = -1;
+
+    #if defined(O_TMPFILE)
+        // Unnamed file in target directory, linked into the directory after all data is written.
+        // Linking requires /proc, checked before writing any data.
+        const size_t slashPos = target.find_last_of('/');
+        const std::string directory = slashPos == std::string::npos ? std::string(".") :
+                                      (slashPos == 0 ? std::string("/") : target.substr(0, slashPos));
+        std::string procPath;
+        fd = ::open(directory.c_str(), O_TMPFILE | O_WRONLY | O_CLOEXEC, 0666);
+        if(fd >= 0)
+        {
+            procPath = "/proc/self/fd/" + std::to_string(fd);
+            struct stat procStatus;
+            if(stat(procPath.c_str(), &procStatus) != 0)
             {
-                const std::string endLine = input.substr(lastPos);
-                if(endLine.size())
-                {
-                    folded.push_back(endLine);
-                }
-
-                return folded.size();
+                CloseFile(fd);
+                fd = -1;
             }
-
-            folded.push_back(input.substr(lastPos, spacePos - lastPos));
-
-            lastPos = spacePos + 1;
         }
+    #endif
+        const bool unnamed = fd >= 0;
+        if(unnamed == false)
+        {
+            // Named temporary file, next to target file.
+            do
+            {
+                tempName = target + "." + pid + "." + std::to_string(tempCounter++) + ".tmp";
+                fd = OpenOutputFile(tempName.c_str(), true);
+            } while(fd < 0 && errno == EEXIST);
 
-        return folded.size();
-    }
-
-    static void SerializeLoop(const Node & node, std::iostream & stream, bool useLevel, const size_t level, const SerializeConfig & config)
-    {
-        const size_t indention = config.SpaceIndentation;
+            if(fd < 0)
+            {
+                throw OperationException(g_ErrorCannotOpenFile);
+            }
+        }
 
-        switch(node.Type())
+        try
         {
-            case Node::SequenceType:
+        #if !defined(_WIN32)
+            if(targetExists)
             {
-                for(auto it = node.Begin(); it != node.End(); it++)
+                // Changing owner is not permitted without privileges, the file is then owned by the caller.
+                if(fchown(fd, targetStatus.st_uid, targetStatus.st_gid) != 0 && errno != EPERM)
                 {
-                    const Node & value = (*it).second;
-                    if(value.IsNone())
-                    {
-                        continue;
-                    }
-                    stream << std::string(level, ' ') << "- ";
-                    useLevel = false;
-                    if(value.IsSequence() || (value.IsMap() && config.SequenceMapNewline == true))
-                    {
-                        useLevel = true;
-                        stream << "\n";
-                    }
-
-                    SerializeLoop(value, stream, useLevel, level + 2, config);
+                    throw OperationException(g_ErrorWriteFile);
                 }
-
-            }
-            break;
-            case Node::MapType:
-            {
-                size_t count = 0;
-                for(auto it = node.Begin(); it != node.End(); it++)
+                if(fchmod(fd, targetStatus.st_mode & 07777) != 0)
                 {
-                    const Node & value = (*it).second;
-                    if(value.IsNone())
-                    {
-                        continue;
-                    }
-
-                    if(useLevel || count > 0)
-                    {
-                       stream << std::string(level, ' ');
-                    }
-
-                    std::string key = (*it).first;
-                    AddEscapeTokens(key, "\\\"");
-                    if(ShouldBeCited(key))
-                    {
-                        stream << "\"" << key << "\"" << ": ";
-                    }
-                    else
-                    {
-                        stream << key << ": ";
-                    }
-
-
-                    useLevel = false;
-                    if(value.IsScalar() == false || (value.IsScalar() && config.MapScalarNewline))
-                    {
-                        useLevel = true;
-                        stream << "\n";
-                    }
-
-                    SerializeLoop(value, stream, useLevel, level + indention, config);
-
-                    useLevel = true;
-                    count++;
+                    throw OperationException(g_ErrorWriteFile);
                 }
-
             }
-            break;
-            case Node::ScalarType:
+        #endif
+            WriteFileData(root, fd, config, fileConfig, true);
+        }
+        catch(...)
+        {
+            CloseFile(fd);
+            if(unnamed == false)
             {
-                const std::string value = node.As<std::string>();
-
-                // Empty scalar
-                if(value.size() == 0)
-                {
-                    stream << "\n";
-                    break;
-                }
+                std::remove(tempName.c_str());
+            }
+            throw;
+        }
 
-                // Get lines of scalar.
-                std::string line = "";
-                std::vector<std::string> lines;
-                std::istringstream iss(value);
-                while (iss.eof() == false)
-                {
-                    std::getline(iss, line);
-                    lines.push_back(line);
-                }
+    #if defined(O_TMPFILE)
+        if(unnamed)
+        {
+            int result = -1;
+            do
+            {
+                tempName = target + "." + pid + "." + std::to_string(tempCounter++) + ".tmp";
+                result = linkat(AT_FDCWD, procPath.c_str(), AT_FDCWD, tempName.c_str(), AT_SYMLINK_FOLLOW);
+            } while(result != 0 && errno == EEXIST);
+            CloseFile(fd);
+            if(result != 0)
+            {
+                throw OperationException(g_ErrorWriteFile);
+            }
+        }
+    #endif
+        if(unnamed == false && CloseFile(fd) == false)
+        {
+            std::remove(tempName.c_str());
+            throw OperationException(g_ErrorWriteFile);
+        }
 
-                // Block scalar
-                const std::string & lastLine = lines.back();
-                const bool endNewline = lastLine.size() == 0;
-                if(endNewline)
-                {
-                    lines.pop_back();
-                }
+    #if defined(_WIN32)
+        // Rename does not replace existing files on Windows.
+        if(MoveFileExA(tempName.c_str(), filename, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) == 0)
+    #else
+        if(std::rename(tempName.c_str(), filename) != 0)
+    #endif
+        {
+            std::remove(tempName.c_str());
+            throw OperationException(g_ErrorWriteFile);
+        }
+    }
 
-                // Literal
-                if(lines.size() > 1)
-                {
-                    stream << "|";
-                }
-                // Folded/plain
-                else
+    void SerializeFlow(const Node & node, Sink & sink, const SerializeConfig & config)
+    {
+        switch(node.Type())
+        {
+        case Node::SequenceType:
+        case Node::MapType:
+        {
+            const bool isMap = node.IsMap();
+            sink.Put(isMap ? '{' : '[');
+            size_t count = 0;
+            for(auto it = node.begin(); it != node.end(); ++it)
+            {
+                const ConstIterator::value_type entry = *it;
+                if(entry.second.IsNone())
                 {
-                    const std::string frontLine = lines.front();
-                    if(config.ScalarMaxLength == 0 || lines.front().size() <= config.ScalarMaxLength ||
-                       LineFolding(frontLine, lines, config.ScalarMaxLength) == 1)
-                    {
-                        if(useLevel)
-                        {
-                             stream << std::string(level, ' ');
-                        }
-
-                        if(ShouldBeCited(value))
-                        {
-                            stream << "\"" << value << "\"\n";
-                            break;
-                        }
-                        stream << value << "\n";
-                        break;
-                    }
-                    else
-                    {
-                        stream << ">";
-                    }
+                    continue;
                 }
-
-                if(endNewline == false)
+                if(count++)
                 {
-                     stream << "-";
+                    impl::EncodeFlowSeparator(sink, config);
                 }
-                stream << "\n";
-
-
-                for(auto it = lines.begin(); it != lines.end(); it++)
+                if(isMap)
                 {
-                    stream << std::string(level, ' ') << (*it) << "\n";
+                    impl::EncodeFlowKey(sink, entry.first.c_str(), entry.first.size(), config);
                 }
+                SerializeFlow(entry.second, sink, config);
             }
-            break;
+            sink.Put(isMap ? '}' : ']');
+        }
+        break;
+        case Node::ScalarType:
+        {
+            const ScalarImp * pScalarImp = static_cast<const ScalarImp*>(NODE_IMP_EXT(node)->m_pImp);
+            const std::string & data = pScalarImp->m_Value;
 
+            // Unquoted string scalars are written as JSON literals if looking like one, as if parsed with typed scalars.
+            const bool plain = node.DataType() != Node::StringData ||
+                               (config.Style == SerializeConfig::JsonStyle && pScalarImp->m_Quoted == false);
+            impl::EncodeFlowScalar(sink, data.c_str(), data.size(), plain, config, IsCitedScalar(node));
+        }
+        break;
         default:
+            impl::EncodeFlowScalar(sink, "", 0, true, config);
             break;
         }
     }
 
-    void Serialize(const Node & root, std::iostream & stream, const SerializeConfig & config)
+    bool IsFlowSequence(const Node & node, const SerializeConfig & config)
     {
-        if(config.SpaceIndentation < 2)
+        if(config.FlowSequenceLength == 0 || node.IsSequence() == false)
         {
-            throw OperationException(g_ErrorIndentation);
+            return false;
         }
 
-        SerializeLoop(root, stream, false, 0, config);
+        // Measured as written, until exceeding maximum length.
+        const SerializeConfig flowConfig(config.SpaceIndentation, config.ScalarMaxLength, false, false,
+                                         SerializeConfig::FlowStyle);
+        CountingSink sink;
+        sink.Put('[');
+        for(auto it = node.begin(); it != node.end(); ++it)
+        {
+            const Node & value = (*it).second;
+            if(value.IsNone())
+            {
+                continue;
+            }
+            if(value.IsScalar() == false)
+            {
+                return false;
+            }
+            if(sink.Size() > 1)
+            {
+                impl::EncodeFlowSeparator(sink, flowConfig);
+            }
+            SerializeFlow(value, sink, flowConfig);
+            if(sink.Size() >= config.FlowSequenceLength)
+            {
+                return false;
+            }
+        }
+        return sink.Size() < config.FlowSequenceLength;
     }
 
-    void Serialize(const Node & root, std::string & string, const SerializeConfig & config)
+    bool IsJsonNumber(const char * data, const size_t size)
     {
-        std::stringstream stream;
-        Serialize(root, stream, config);
-        string = stream.str();
-    }
+        const char * pCur = data;
+        const char * pEnd = data + size;
+        if(pCur != pEnd && *pCur == '-')
+        {
+            ++pCur;
+        }
+        if(pCur == pEnd)
+        {
+            return false;
+        }
 
+        // Integer part, without leading zeros.
+        if(*pCur == '0')
+        {
+            ++pCur;
+        }
+        else
+        {
+            if(*pCur < '1' || *pCur > '9')
+            {
+                return false;
+            }
+            while(pCur != pEnd && *pCur >= '0' && *pCur <= '9')
+            {
+                ++pCur;
+            }
+        }
 
+        // Fraction and exponent.
+        if(pCur != pEnd && *pCur == '.')
+        {
+            const char * pDigits = ++pCur;
+            while(pCur != pEnd && *pCur >= '0' && *pCur <= '9')
+            {
+                ++pCur;
+            }
+            if(pCur == pDigits)
+            {
+                return false;
+            }
+        }
+        if(pCur != pEnd && (*pCur == 'e' || *pCur == 'E'))
+        {
+            ++pCur;
+            if(pCur != pEnd && (*pCur == '+' || *pCur == '-'))
+            {
+                ++pCur;
+            }
+            const char * pDigits = pCur;
+            while(pCur != pEnd && *pCur >= '0' && *pCur <= '9')
+            {
+                ++pCur;
+            }
+            if(pCur == pDigits)
+            {
+                return false;
+            }
+        }
 
-    // Static function implementations
-    std::string ExceptionMessage(const std::string & message, ReaderLine & line)
-    {
-        return message + std::string(" Line ") + std::to_string(line.No) + std::string(": ") + line.Data;
+        return pCur == pEnd;
     }
 
-    std::string ExceptionMessage(const std::string & message, ReaderLine & line, const size_t errorPos)
+    bool ShouldBeFlowQuoted(const char * data, const size_t size)
     {
-        return message + std::string(" Line ") + std::to_string(line.No) + std::string(" column ") + std::to_string(errorPos + 1) + std::string(": ") + line.Data;
+        if(data[0] == ' ' || data[size - 1] == ' ')
+        {
+            return true;
+        }
+        for(size_t i = 0; i < size; i++)
+        {
+            const unsigned char c = static_cast<unsigned char>(data[i]);
+            if(c < 0x20 || c == 0x7F || std::strchr("\":{}[],&*#?|-<>=!%@'`\\", c) != nullptr)
+            {
+                return true;
+            }
+        }
+        return false;
     }
 
-    std::string ExceptionMessage(const std::string & message, const size_t errorLine, const size_t errorPos)
+    void EncodeQuoted(Sink & sink, const char * data, const size_t size, const bool json)
     {
-        return message + std::string(" Line ") + std::to_string(errorLine) + std::string(" column ") + std::to_string(errorPos);
+        static const char hexDigits[] = "0123456789abcdef";
+
+        sink.Put('"');
+        const char * pStart = data;
+        const char * pEnd = data + size;
+        for(const char * pCur = data; pCur != pEnd; ++pCur)
+        {
+            const unsigned char c = static_cast<unsigned char>(*pCur);
+            if(c >= 0x20 && c != '"' && c != '\\' && c != 0x7F)
+            {
+                continue;
+            }
+
+            sink.Write(pStart, static_cast<size_t>(pCur - pStart));
+            pStart = pCur + 1;
+            switch(c)
+            {
+            case '"':
+                sink.Write("\\\"", 2);
+                break;
+            case '\\':
+                sink.Write("\\\\", 2);
+                break;
+            case '\n':
+                sink.Write("\\n", 2);
+                break;
+            case '\r':
+                sink.Write("\\r", 2);
+                break;
+            case '\t':
+                sink.Write("\\t", 2);
+                break;
+            default:
+            {
+                char escaped[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0x0F] };
+                if(json)
+                {
+                    sink.Write(escaped, 6);
+                }
+                else
+                {
+                    escaped[2] = '\\';
+                    escaped[3] = 'x';
+                    sink.Write(escaped + 2, 4);
+                }
+            }
+            break;
+            }
+        }
+        sink.Write(pStart, static_cast<size_t>(pEnd - pStart));
+        sink.Put('"');
     }
 
-    std::string ExceptionMessage(const std::string & message, const size_t errorLine, const std::string & data)
+    void WriteVarint(Sink & sink, uint64_t value)
     {
-        return message + std::string(" Line ") + std::to_string(errorLine) + std::string(": ") + data;
+        char buffer[10];
+        size_t size = 0;
+        while(value >= 0x80)
+        {
+            buffer[size++] = static_cast<char>((value & 0x7F) | 0x80);
+            value >>= 7;
+        }
+        buffer[size++] = static_cast<char>(value);
+        sink.Write(buffer, size);
     }
 
-    bool FindQuote(const std::string & input, size_t & start, size_t & end, size_t searchPos)
+    void CollectBinaryKeys(const Node & node, std::unordered_map<std::string, size_t> & keyMap,
+                           std::vector<const std::string *> & keys, std::vector<size_t> & keyRefs,
+                           std::unordered_set<const TypeImp *> & shared)
     {
-        start = end = std::string::npos;
-        size_t qPos = searchPos;
-        bool foundStart = false;
+        const NodeImp * pNodeImp = NODE_IMP_EXT(node);
+        if(pNodeImp->m_pImp == nullptr)
+        {
+            return;
+        }
 
-        while(qPos != std::string::npos)
+        // Shared imps are saved once, later occurrences as aliases.
+        if(pNodeImp->m_pImp->m_RefCount > 1 && shared.insert(pNodeImp->m_pImp).second == false)
         {
-            // Find first quote.
-            qPos = input.find_first_of("\"'", qPos);
-            if(qPos == std::string::npos)
+            return;
+        }
+
+        if(pNodeImp->m_Type == Node::SequenceType)
+        {
+            const std::vector<Node*> & sequence = static_cast<const SequenceImp*>(pNodeImp->m_pImp)->m_Sequence;
+            for(auto it = sequence.begin(); it != sequence.end(); it++)
             {
-                return false;
+                CollectBinaryKeys(**it, keyMap, keys, keyRefs, shared);
             }
-
-            const char token = input[qPos];
-            if(token == '"' && (qPos == 0 || input[qPos-1] != '\\'))
+        }
+        else if(pNodeImp->m_Type == Node::MapType)
+        {
+            const std::map<std::string, Node*> & map = static_cast<const MapImp*>(pNodeImp->m_pImp)->m_Map;
+            for(auto it = map.begin(); it != map.end(); it++)
             {
-                // Found start quote.
-                if(foundStart == false)
-                {
-                    start = qPos;
-                    foundStart = true;
-                }
-                // Found end quote
-                else
+                auto result = keyMap.emplace(it->first, keys.size());
+                if(result.second)
                 {
-                    end = qPos;
-                    return true;
+                    keys.push_back(&it->first);
                 }
+                keyRefs.push_back(result.first->second);
+                CollectBinaryKeys(*it->second, keyMap, keys, keyRefs, shared);
             }
-
-            // Check if it's possible for another loop.
-            if(qPos + 1 == input.size())
-            {
-                return false;
-            }
-            qPos++;
         }
-
-        return false;
     }
 
-    size_t FindNotCited(const std::string & input, char token, size_t & preQuoteCount)
+    void SaveBinaryNode(const Node & node, Sink & sink, const std::vector<size_t> & keyRefs, size_t & keyRef,
+                        std::unordered_map<const TypeImp *, size_t> & anchors)
     {
-        preQuoteCount = 0;
-        size_t tokenPos = input.find_first_of(token);
-        if(tokenPos == std::string::npos)
+        const NodeImp * pNodeImp = NODE_IMP_EXT(node);
+        if(pNodeImp->m_pImp == nullptr)
         {
-            return std::string::npos;
+            sink.Put(static_cast<char>(BinaryNone));
+            return;
         }
 
-        // Find all quotes
-        std::vector<std::pair<size_t, size_t>> quotes;
-
-        size_t quoteStart = 0;
-        size_t quoteEnd = 0;
-        while(FindQuote(input, quoteStart, quoteEnd, quoteEnd))
+        uint8_t anchorFlag = 0;
+        if(pNodeImp->m_pImp->m_RefCount > 1)
         {
-            quotes.push_back({quoteStart, quoteEnd});
-
-            if(quoteEnd + 1 == input.size())
+            const size_t anchor = anchors.size();
+            auto result = anchors.emplace(pNodeImp->m_pImp, anchor);
+            if(result.second == false)
             {
-                break;
+                sink.Put(static_cast<char>(BinaryAlias));
+                WriteVarint(sink, result.first->second);
+                return;
             }
-            quoteEnd++;
+            anchorFlag = g_BinaryAnchorFlag;
         }
 
-        if(quotes.size() == 0)
+        switch(pNodeImp->m_Type)
         {
-            return tokenPos;
+        case Node::SequenceType:
+        {
+            const std::vector<Node*> & sequence = static_cast<const SequenceImp*>(pNodeImp->m_pImp)->m_Sequence;
+            sink.Put(static_cast<char>(BinarySequence | anchorFlag));
+            WriteVarint(sink, sequence.size());
+            for(auto it = sequence.begin(); it != sequence.end(); it++)
+            {
+                SaveBinaryNode(**it, sink, keyRefs, keyRef, anchors);
+            }
+        }
+        break;
+        case Node::MapType:
+        {
+            const std::map<std::string, Node*> & map = static_cast<const MapImp*>(pNodeImp->m_pImp)->m_Map;
+            sink.Put(static_cast<char>(BinaryMap | anchorFlag));
+            WriteVarint(sink, map.size());
+            for(auto it = map.begin(); it != map.end(); it++)
+            {
+                WriteVarint(sink, keyRefs[keyRef++]);
+                SaveBinaryNode(*it->second, sink, keyRefs, keyRef, anchors);
+            }
         }
+        break;
+        case Node::ScalarType:
+        {
+            const ScalarImp * pScalarImp = static_cast<const ScalarImp*>(pNodeImp->m_pImp);
+            const std::string & value = pScalarImp->m_Value;
+            const impl::ScalarValue & native = pScalarImp->m_Native;
+            char buffer[32];
+            size_t size = 0;
+            uint8_t tag = BinaryString;
 
-        size_t currentQuoteIndex = 0;
-        std::pair<size_t, size_t> currentQuote = {0, 0};
+            switch(native.Type)
+            {
+            case impl::ScalarValue::NullType:
+                tag = BinaryNull;
+                break;
+            case impl::ScalarValue::BooleanType:
+                tag = BinaryBoolean;
+                size = std::strlen(std::strcpy(buffer, native.Boolean ? "true" : "false"));
+                break;
+            case impl::ScalarValue::IntegerType:
+                tag = BinaryInteger;
+                size = impl::FormatInteger(buffer, native.Integer);
+                break;
+            case impl::ScalarValue::FloatType:
+                tag = BinaryFloat;
+                size = impl::FormatFloat(buffer, native.Float);
+                break;
+            default:
+                break;
+            }
 
-        while(currentQuoteIndex < quotes.size())
-        {
-            currentQuote = quotes[currentQuoteIndex];
+            if(tag == BinaryString || tag == BinaryNull)
+            {
+                const bool quoted = tag == BinaryString && pScalarImp->m_Quoted;
+                sink.Put(static_cast<char>((quoted ? tag | g_BinaryTextFlag : tag) | anchorFlag));
+                WriteVarint(sink, value.size());
+                sink.Write(value);
+                break;
+            }
 
-            if(tokenPos < currentQuote.first)
+            // Original text is only stored if differing from formatted native value.
+            const bool hasText = value.size() != size || std::memcmp(value.c_str(), buffer, size) != 0;
+            sink.Put(static_cast<char>((hasText ? tag | g_BinaryTextFlag : tag) | anchorFlag));
+            if(tag == BinaryBoolean)
             {
-                return tokenPos;
+                sink.Put(native.Boolean ? 1 : 0);
             }
-            preQuoteCount++;
-            if(tokenPos <= currentQuote.second)
+            else if(tag == BinaryInteger)
             {
-                // Find next token
-                if(tokenPos + 1 == input.size())
-                {
-                    return std::string::npos;
-                }
-                tokenPos = input.find_first_of(token, tokenPos + 1);
-                if(tokenPos == std::string::npos)
+                const uint64_t integer = static_cast<uint64_t>(native.Integer);
+                WriteVarint(sink, (integer << 1) ^ (0 - (integer >> 63)));
+            }
+            else
+            {
+                uint64_t bits = 0;
+                std::memcpy(&bits, &native.Float, sizeof(bits));
+                char bytes[8];
+                for(size_t i = 0; i < 8; i++)
                 {
-                    return std::string::npos;
+                    bytes[i] = static_cast<char>((bits >> (i * 8)) & 0xFF);
                 }
+                sink.Write(bytes, 8);
+            }
+            if(hasText)
+            {
+                WriteVarint(sink, value.size());
+                sink.Write(value);
             }
+        }
+        break;
+        default:
+            sink.Put(static_cast<char>(BinaryNone));
+            break;
+        }
+    }
 
-            currentQuoteIndex++;
+    uint64_t MappedHash(const char * data, const size_t size)
+    {
+        // 64-bit FNV-1a.
+        uint64_t hash = 14695981039346656037ULL;
+        for(size_t i = 0; i < size; i++)
+        {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 1099511628211ULL;
         }
+        return hash;
+    }
 
-        return tokenPos;
+    void * MapFile(const char * filename, size_t & size)
+    {
+    #if defined(_WIN32)
+        // Read into an aligned buffer, instead of mapping.
+        std::ifstream f(filename, std::ifstream::binary);
+        if(f.is_open() == false)
+        {
+            throw OperationException(g_ErrorCannotOpenFile);
+        }
+        f.seekg(0, f.end);
+        size = static_cast<size_t>(f.tellg());
+        f.seekg(0, f.beg);
+        uint64_t * pBuffer = new uint64_t[size / sizeof(uint64_t) + 1];
+        f.read(reinterpret_cast<char *>(pBuffer), size);
+        return pBuffer;
+    #else
+        const int fd = ::open(filename, O_RDONLY | O_CLOEXEC);
+        if(fd == -1)
+        {
+            throw OperationException(g_ErrorCannotOpenFile);
+        }
+        struct stat status;
+        if(fstat(fd, &status) != 0)
+        {
+            ::close(fd);
+            throw OperationException(g_ErrorMapFile);
+        }
+        size = static_cast<size_t>(status.st_size);
+        if(size < sizeof(MappedHeader))
+        {
+            ::close(fd);
+            throw ParsingException(g_ErrorInvalidMapped);
+        }
+
+        void * pMapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(pMapping == MAP_FAILED)
+        {
+            throw OperationException(g_ErrorMapFile);
+        }
+        return pMapping;
+    #endif
     }
 
-    size_t FindNotCited(const std::string & input, char token)
+    void UnmapFile(void * pMapping, const size_t size)
     {
-        size_t dummy = 0;
-        return FindNotCited(input, token, dummy);
+    #if defined(_WIN32)
+        delete [] static_cast<uint64_t *>(pMapping);
+    #else
+        munmap(pMapping, size);
+    #endif
     }
 
-    bool ValidateQuote(const std::string & input)
+    std::string SharedSegmentName(const char * name, const uint64_t generation)
     {
-        if(input.size() == 0)
+        return std::string(name) + "." + std::to_string(generation);
+    }
+
+    void * MapSharedControl(const char * name, const bool create, const unsigned int mode)
+    {
+    #if defined(_WIN32)
+        throw OperationException(g_ErrorSharedMemory);
+    #else
+        if(name == nullptr)
         {
-            return true;
+            throw OperationException(g_ErrorSharedMemory);
         }
-
-        char token = 0;
-        size_t searchPos = 0;
-        if(input[0] == '\"' || input[0] == '\'')
+        const int fd = shm_open(name, create ? O_RDWR | O_CREAT : O_RDONLY, static_cast<mode_t>(mode));
+        if(fd == -1)
         {
-            if(input.size() == 1)
+            if(create == false && errno == ENOENT)
             {
-                return false;
+                return nullptr;
             }
-            token = input[0];
-            searchPos = 1;
+            throw OperationException(g_ErrorSharedMemory);
         }
 
-        while(searchPos != std::string::npos && searchPos < input.size() - 1)
+        struct stat status;
+        bool valid = fstat(fd, &status) == 0;
+        if(valid && static_cast<size_t>(status.st_size) < sizeof(SharedControl))
         {
-            searchPos = input.find_first_of("\"'", searchPos + 1);
-            if(searchPos == std::string::npos)
+            // New control segments are zero filled, with generation 0.
+            valid = create && ftruncate(fd, sizeof(SharedControl)) == 0;
+            if(valid == false && create == false)
             {
-                break;
+                ::close(fd);
+                return nullptr;
             }
+        }
+        void * pMapping = valid ? mmap(nullptr, sizeof(SharedControl), PROT_READ | (create ? PROT_WRITE : 0), MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if(pMapping == MAP_FAILED)
+        {
+            throw OperationException(g_ErrorSharedMemory);
+        }
 
-            const char foundToken = input[searchPos];
-
-            if(input[searchPos] == '\"' || input[searchPos] == '\'')
+        // Initialized by exactly one publisher, readers seeing format 0 treat it as nothing published.
+        SharedControl * pControl = static_cast<SharedControl *>(pMapping);
+        uint64_t format = 0;
+        if(create)
+        {
+            pControl->Format.compare_exchange_strong(format, g_SharedFormat, std::memory_order_acq_rel);
+        }
+        format = pControl->Format.load(std::memory_order_acquire);
+        if(format != g_SharedFormat)
+        {
+            munmap(pMapping, sizeof(SharedControl));
+            if(create == false)
             {
-                if(token == 0 && input[searchPos-1] != '\\')
-                {
-                    return false;
-                }
-                //if(foundToken == token)
-                //{
-
-                    /*if(foundToken == token && searchPos == input.size() - 1 && input[searchPos-1] != '\\')
-                    {
-                        return true;
-                        if(searchPos == input.size() - 1)
-                        {
-                            return true;
-                        }
-                        return false;
-                    }
-                    else */
-                    if(foundToken == token && input[searchPos-1] != '\\')
-                    {
-                        if(searchPos == input.size() - 1)
-                        {
-                            return true;
-                        }
-                        return false;
-                    }
-                //}
+                return nullptr;
             }
+            throw OperationException(g_ErrorSharedMemory);
+        }
+        return pMapping;
+    #endif
+    }
+
+    uint64_t ContentHash(const char * data, const size_t size)
+    {
+        // FNV-1a style hash of 8 byte words, with final mixing.
+        uint64_t hash = 14695981039346656037ULL ^ size;
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8)
+        {
+            uint64_t word = 0;
+            std::memcpy(&word, data + i, sizeof(word));
+            hash = (hash ^ word) * 1099511628211ULL;
+            hash ^= hash >> 29;
         }
+        for(; i < size; i++)
+        {
+            hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+        }
+        hash ^= hash >> 32;
+        hash *= 0x9E3779B97F4A7C15ULL;
+        return hash ^ (hash >> 29);
+    }
 
-        return token == 0;
+    size_t EstimateMemory(const Node & node)
+    {
+        std::unordered_set<const TypeImp *> shared;
+        return EstimateMemory(node, shared);
     }
 
-    void CopyNode(const Node & from, Node & to)
+    size_t EstimateMemory(const Node & node, std::unordered_set<const TypeImp *> & shared)
     {
-        const Node::eType type = from.Type();
+        const NodeImp * pNodeImp = NODE_IMP_EXT(node);
+        size_t memory = sizeof(Node) + sizeof(NodeImp);
+        if(pNodeImp->m_pImp == nullptr)
+        {
+            return memory;
+        }
 
-        switch(type)
+        // Imps shared by aliases are counted once.
+        if(pNodeImp->m_pImp->m_RefCount > 1 && shared.insert(pNodeImp->m_pImp).second == false)
+        {
+            return memory;
+        }
+
+        switch(pNodeImp->m_Type)
         {
         case Node::SequenceType:
-            for(auto it = from.Begin(); it != from.End(); it++)
+        {
+            const std::vector<Node*> & sequence = static_cast<const SequenceImp*>(pNodeImp->m_pImp)->m_Sequence;
+            memory += sizeof(SequenceImp) + sequence.capacity() * sizeof(Node*);
+            for(auto it = sequence.begin(); it != sequence.end(); it++)
             {
-                const Node & currentNode = (*it).second;
-                Node & newNode = to.PushBack();
-                CopyNode(currentNode, newNode);
+                memory += EstimateMemory(**it, shared);
             }
-            break;
+        }
+        break;
         case Node::MapType:
-            for(auto it = from.Begin(); it != from.End(); it++)
+        {
+            // Tree nodes of std::map are estimated as 4 pointers, with key and value.
+            const std::map<std::string, Node*> & map = static_cast<const MapImp*>(pNodeImp->m_pImp)->m_Map;
+            memory += sizeof(MapImp);
+            for(auto it = map.begin(); it != map.end(); it++)
             {
-                const Node & currentNode = (*it).second;
-                Node & newNode = to[(*it).first];
-                CopyNode(currentNode, newNode);
+                memory += 4 * sizeof(void*) + sizeof(std::string) + sizeof(Node*) + it->first.capacity();
+                memory += EstimateMemory(*it->second, shared);
             }
-            break;
+        }
+        break;
         case Node::ScalarType:
-            to = from.As<std::string>();
+            memory += sizeof(ScalarImp) + static_cast<const ScalarImp*>(pNodeImp->m_pImp)->m_Value.capacity();
             break;
-        case Node::None:
+        default:
             break;
         }
+        return memory;
     }
 
-    bool ShouldBeCited(const std::string & key)
-    {
-        return key.find_first_of("\":{}[],&*#?|-<>=!%@") != std::string::npos;
-    }
-
-    void AddEscapeTokens(std::string & input, const std::string & tokens)
+    size_t FindPathBracketEnd(const std::string & path, const size_t pos)
     {
-        for(auto it = tokens.begin(); it != tokens.end(); it++)
+        // Quoted keys and values may contain any character, including ']'.
+        for(size_t i = pos + 1; i < path.size(); i++)
         {
-            const char token = *it;
-            const std::string replace = std::string("\\") + std::string(1, token);
-            size_t found = input.find_first_of(token);
-            while(found != std::string::npos)
+            const char c = path[i];
+            if(c == '"' || c == '\'')
             {
-                input.replace(found, 1, replace);
-                found = input.find_first_of(token, found + 2);
+                i = path.find(c, i + 1);
+                if(i == std::string::npos)
+                {
+                    return std::string::npos;
+                }
             }
-        }
-    }
-
-    void RemoveAllEscapeTokens(std::string & input)
-    {
-        size_t found = input.find_first_of("\\");
-        while(found != std::string::npos)
-        {
-            if(found + 1 == input.size())
+            else if(c == ']')
             {
-                return;
+                return i;
             }
-
-            std::string replace(1, input[found + 1]);
-            input.replace(found, 2, replace);
-            found = input.find_first_of("\\", found + 1);
         }
+        return std::string::npos;
     }
 
 
@@ -37,6 +37,21 @@ https://www.codeproject.com/Articles/28720/YAML-Parser-in-C
 #include <sstream>
 #include <algorithm>
 #include <map>
+#include <iterator>
+#include <cstddef>
+#include <vector>
+#include <limits>
+#include <type_traits>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
+#if __cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L)
+    #include <optional>
+    #define YAML_HAS_OPTIONAL 1
+#else
+    #define YAML_HAS_OPTIONAL 0
+#endif
 
 /**
 * @breif Namespace wrapping mini-yaml classes.
@@ -60,11 +75,355 @@ namespace Yaml
     {
 
         /**
-        * @breif Helper functionality, converting string to any data type.
-        *        Strings are left untouched.
+        * @breif Natively typed value of scalar.
+        *
+        */
+        struct ScalarValue
+        {
+
+            /**
+            * @breif Enumeration of value types.
+            *
+            */
+            enum eType
+            {
+                NoneType,       ///< No native value, string only.
+                NullType,       ///< Null value.
+                BooleanType,    ///< Boolean value.
+                IntegerType,    ///< 64-bit signed integer value.
+                FloatType       ///< Double precision floating point value.
+            };
+
+            ScalarValue() :
+                Type(NoneType),
+                Integer(0)
+            {
+            }
+
+            eType Type; ///< Type of value.
+
+            union
+            {
+                bool    Boolean;
+                int64_t Integer;
+                double  Float;
+            };
+
+        };
+
+        /**
+        * @breif Helper functionality, converting natively typed scalar values to arithmetic types.
+        *        Returns false if not possible, falling back to StringConverter.
+        *
+        */
+        template<typename T, typename Enable = void>
+        struct ValueConverter
+        {
+            static const bool Enabled = false;
+
+            static bool Get(const ScalarValue &, T &)
+            {
+                return false;
+            }
+        };
+
+        template<typename T>
+        struct IsCharacter
+        {
+            static const bool value =
+                std::is_same<T, char>::value || std::is_same<T, signed char>::value || std::is_same<T, unsigned char>::value ||
+                std::is_same<T, wchar_t>::value || std::is_same<T, char16_t>::value || std::is_same<T, char32_t>::value;
+        };
+
+        template<typename T>
+        struct ValueConverter<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && !IsCharacter<T>::value>::type>
+        {
+            static const bool Enabled = true;
+
+            static bool Get(const ScalarValue & value, T & type)
+            {
+                switch(value.Type)
+                {
+                case ScalarValue::IntegerType:
+                    if(std::is_signed<T>::value)
+                    {
+                        if(value.Integer < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+                           value.Integer > static_cast<int64_t>(std::numeric_limits<T>::max()))
+                        {
+                            return false;
+                        }
+                    }
+                    else if(value.Integer < 0 || static_cast<uint64_t>(value.Integer) > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+                    {
+                        return false;
+                    }
+                    type = static_cast<T>(value.Integer);
+                    return true;
+                case ScalarValue::FloatType:
+                    if(!(value.Float > static_cast<double>(std::numeric_limits<T>::min()) - 1.0 &&
+                         value.Float < static_cast<double>(std::numeric_limits<T>::max()) + 1.0))
+                    {
+                        return false;
+                    }
+                    type = static_cast<T>(value.Float);
+                    return true;
+                default:
+                    break;
+                }
+                return false;
+            }
+        };
+
+        template<typename T>
+        struct ValueConverter<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+        {
+            static const bool Enabled = true;
+
+            static bool Get(const ScalarValue & value, T & type)
+            {
+                switch(value.Type)
+                {
+                case ScalarValue::IntegerType:
+                    type = static_cast<T>(value.Integer);
+                    return true;
+                case ScalarValue::FloatType:
+                    type = static_cast<T>(value.Float);
+                    return true;
+                default:
+                    break;
+                }
+                return false;
+            }
+        };
+
+        template<>
+        struct ValueConverter<bool>
+        {
+            static const bool Enabled = true;
+
+            static bool Get(const ScalarValue & value, bool & type)
+            {
+                if(value.Type != ScalarValue::BooleanType)
+                {
+                    return false;
+                }
+                type = value.Boolean;
+                return true;
+            }
+        };
+
+        /**
+        * @breif Result of locale independent number parsing.
+        *
+        */
+        enum eNumberResult
+        {
+            NumberOk,           ///< Number parsed successfully.
+            NumberInvalid,      ///< Invalid format of number.
+            NumberOutOfRange    ///< Number is valid, but out of range.
+        };
+
+        /**
+        * @breif Parse integer from string, without allocations.
+        *        Decimal, hexadecimal("0x1F"), octal("0o17") and binary("0b101") forms are accepted.
+        *        Underscores between digits("1_000") and surrounding whitespaces are accepted,
+        *        unless coreSchema is true, limiting the format to the YAML 1.2 core schema.
+        *
+        * @param negative   Set to true if number is negative.
+        * @param magnitude  Absolute value of number.
+        *
+        */
+        eNumberResult ParseInteger(const char * pBegin, const char * pEnd, bool & negative, uint64_t & magnitude,
+                                   const bool coreSchema = false);
+
+        /**
+        * @breif Parse floating point number from string, without allocations for common numbers.
+        *        Exactly representable numbers are converted directly, others are correctly rounded by strtod.
+        *        ".inf" and ".nan" forms are accepted. Underscores and whitespaces are accepted as for ParseInteger.
+        *
+        */
+        eNumberResult ParseFloat(const char * pBegin, const char * pEnd, double & value, const bool coreSchema = false);
+
+        /**
+        * @breif Parse boolean from string, case insensitive.
+        *        Accepts "true", "yes", "1", "false", "no" and "0".
+        *
+        */
+        eNumberResult ParseBoolean(const char * pBegin, const char * pEnd, bool & value);
+
+        /**
+        * @breif Integer, floating point or boolean interpretation of scalar string.
+        *        The last conversion of a scalar node is cached, used by CacheConverter.
+        *
+        */
+        struct ScalarNumber
+        {
+            /**
+            * @breif Enumeration of parsed kinds.
+            *
+            */
+            enum eKind
+            {
+                NoKind,         ///< Not parsed.
+                IntegerKind,    ///< Parsed by ParseInteger.
+                FloatKind,      ///< Parsed by ParseFloat.
+                FallbackKind,   ///< Parsed by ParseFloat, after ParseInteger found an invalid integer.
+                BooleanKind     ///< Parsed by ParseBoolean.
+            };
+
+            ScalarNumber() :
+                Kind(NoKind),
+                Result(NumberInvalid),
+                Negative(false),
+                Magnitude(0),
+                Float(0.0),
+                Boolean(false)
+            {
+            }
+
+            eKind           Kind;       ///< Kind of parsing.
+            eNumberResult   Result;     ///< Result of parsing.
+            bool            Negative;   ///< Sign of integer.
+            uint64_t        Magnitude;  ///< Absolute value of integer.
+            double          Float;      ///< Floating point value.
+            bool            Boolean;    ///< Boolean value.
+        };
+
+        /**
+        * @breif Parse scalar string as requested kind of number.
+        *        Integers are parsed as floating point numbers if the integer format is invalid, resulting in FallbackKind.
+        *
+        */
+        void ParseScalarNumber(const char * pBegin, const char * pEnd, const ScalarNumber::eKind kind, ScalarNumber & number);
+
+        /**
+        * @breif Helper functionality, converting parsed scalar numbers to arithmetic types.
+        *        Enabled for all arithmetic types, except characters.
         *
         */
+        template<typename T, typename Enable = void>
+        struct CacheConverter
+        {
+            static const bool Enabled = false;
+            static const ScalarNumber::eKind Kind = ScalarNumber::NoKind;
+
+            static eNumberResult Get(const ScalarNumber &, T &)
+            {
+                return NumberInvalid;
+            }
+        };
+
+        template<typename T>
+        struct CacheConverter<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && !IsCharacter<T>::value>::type>
+        {
+            static const bool Enabled = true;
+            static const ScalarNumber::eKind Kind = ScalarNumber::IntegerKind;
+
+            static eNumberResult Get(const ScalarNumber & number, T & type)
+            {
+                // Floating point numbers are truncated.
+                if(number.Kind == ScalarNumber::FallbackKind)
+                {
+                    if(number.Result != NumberOk)
+                    {
+                        return number.Result;
+                    }
+                    if(!(number.Float > static_cast<double>(std::numeric_limits<T>::min()) - 1.0 &&
+                         number.Float < static_cast<double>(std::numeric_limits<T>::max()) + 1.0))
+                    {
+                        type = number.Float < 0.0 ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+                        return NumberOutOfRange;
+                    }
+                    type = static_cast<T>(number.Float);
+                    return NumberOk;
+                }
+                if(number.Kind != ScalarNumber::IntegerKind)
+                {
+                    return NumberInvalid;
+                }
+                if(number.Result != NumberOk)
+                {
+                    type = number.Negative ? std::numeric_limits<T>::min() : std::numeric_limits<T>::max();
+                    return number.Result;
+                }
+
+                if(number.Negative)
+                {
+                    const uint64_t limit = std::is_signed<T>::value ?
+                        static_cast<uint64_t>(-(static_cast<int64_t>(std::numeric_limits<T>::min()) + 1)) + 1 : 0;
+                    if(number.Magnitude > limit)
+                    {
+                        type = std::numeric_limits<T>::min();
+                        return NumberOutOfRange;
+                    }
+                    type = static_cast<T>(0 - number.Magnitude);
+                    return NumberOk;
+                }
+
+                if(number.Magnitude > static_cast<uint64_t>(std::numeric_limits<T>::max()))
+                {
+                    type = std::numeric_limits<T>::max();
+                    return NumberOutOfRange;
+                }
+                type = static_cast<T>(number.Magnitude);
+                return NumberOk;
+            }
+        };
+
         template<typename T>
+        struct CacheConverter<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+        {
+            static const bool Enabled = true;
+            static const ScalarNumber::eKind Kind = ScalarNumber::FloatKind;
+
+            static eNumberResult Get(const ScalarNumber & number, T & type)
+            {
+                if((number.Kind != ScalarNumber::FloatKind && number.Kind != ScalarNumber::FallbackKind) ||
+                   number.Result == NumberInvalid)
+                {
+                    return NumberInvalid;
+                }
+                const double value = number.Float;
+                if(number.Result == NumberOk &&
+                   (value > static_cast<double>(std::numeric_limits<T>::max()) ||
+                    value < -static_cast<double>(std::numeric_limits<T>::max())) &&
+                   value != std::numeric_limits<double>::infinity() && value != -std::numeric_limits<double>::infinity())
+                {
+                    type = value < 0.0 ? -std::numeric_limits<T>::max() : std::numeric_limits<T>::max();
+                    return NumberOutOfRange;
+                }
+                type = static_cast<T>(value);
+                return number.Result;
+            }
+        };
+
+        template<>
+        struct CacheConverter<bool>
+        {
+            static const bool Enabled = true;
+            static const ScalarNumber::eKind Kind = ScalarNumber::BooleanKind;
+
+            static eNumberResult Get(const ScalarNumber & number, bool & type)
+            {
+                if(number.Kind != ScalarNumber::BooleanKind)
+                {
+                    return NumberInvalid;
+                }
+                if(number.Result == NumberOk)
+                {
+                    type = number.Boolean;
+                }
+                return number.Result;
+            }
+        };
+
+        /**
+        * @breif Helper functionality, converting string to any data type.
+        *        Strings are left untouched, arithmetic types are parsed locale independently
+        *        and other types are read by operator >>.
+        *
+        */
+        template<typename T, typename Enable = void>
         struct StringConverter
         {
             static T Get(const std::string & data)
@@ -89,6 +448,7 @@ namespace Yaml
                 return type;
             }
         };
+
         template<>
         struct StringConverter<std::string>
         {
@@ -107,32 +467,44 @@ namespace Yaml
             }
         };
 
-        template<>
-        struct StringConverter<bool>
+        template<typename T>
+        struct StringConverter<T, typename std::enable_if<CacheConverter<T>::Enabled>::type>
         {
-            static bool Get(const std::string & data)
+            static T Get(const std::string & data)
             {
-                std::string tmpData = data;
-                std::transform(tmpData.begin(), tmpData.end(), tmpData.begin(), ::tolower);
-                if(tmpData == "true" || tmpData == "yes" || tmpData == "1")
-                {
-                    return true;
-                }
-
-                return false;
+                ScalarNumber number;
+                ParseScalarNumber(data.c_str(), data.c_str() + data.size(), CacheConverter<T>::Kind, number);
+                T type = T();
+                CacheConverter<T>::Get(number, type);
+                return type;
             }
 
-            static bool Get(const std::string & data, const bool & defaultValue)
+            static T Get(const std::string & data, const T & defaultValue)
             {
-                if(data.size() == 0)
+                ScalarNumber number;
+                ParseScalarNumber(data.c_str(), data.c_str() + data.size(), CacheConverter<T>::Kind, number);
+                T type = T();
+                if(CacheConverter<T>::Get(number, type) != NumberOk)
                 {
                     return defaultValue;
                 }
-
-                return Get(data);
+                return type;
             }
         };
 
+        /**
+        * @breif Helper functionality, converting node to any data type.
+        *        Scalars are converted by ValueConverter, CacheConverter or StringConverter,
+        *        sequences and maps by the std::vector and std::map specializations.
+        *        Implemented after the Node class.
+        *
+        */
+        template<typename T, typename Enable = void>
+        struct NodeConverter;
+
+        template<typename T, typename Enable = void>
+        struct Decoder;
+
     }
 
 
@@ -252,6 +624,10 @@ namespace Yaml
 
     /**
     * @breif Iterator class.
+    *        Value type without heap allocations, with random access operators.
+    *        Random access operators of map iterators are linear in distance.
+    *        Sequence items are stored in a vector, adding or erasing items of a sequence
+    *        invalidates all of its iterators. Only iterators of erased map items are invalidated.
     *
     */
     class Iterator
@@ -260,6 +636,13 @@ namespace Yaml
     public:
 
         friend class Node;
+        friend class ConstIterator;
+
+        typedef std::random_access_iterator_tag                 iterator_category;
+        typedef std::pair<const std::string &, Node &>    value_type;
+        typedef std::ptrdiff_t                                  difference_type;
+        typedef value_type                                      reference;
+        typedef void                                            pointer;
 
         /**
         * @breif Default constructor.
@@ -267,54 +650,48 @@ namespace Yaml
         */
         Iterator();
 
-        /**
-        * @breif Copy constructor.
-        *
-        */
-        Iterator(const Iterator & it);
-
-        /**
-        * @breif Assignment operator.
-        *
-        */
-        Iterator & operator = (const Iterator & it);
-
-        /**
-        * @breif Destructor.
-        *
-        */
-        ~Iterator();
-
         /**
         * @breif Get node of iterator.
         *        First pair item is the key of map value, empty if type is sequence.
         *
         */
-        std::pair<const std::string &, Node &> operator *();
+        reference operator *() const;
 
         /**
-        * @breif Post-increment operator.
+        * @breif Get node at offset from iterator.
         *
         */
-        Iterator & operator ++ (int);
+        reference operator [] (const difference_type offset) const;
 
         /**
-        * @breif Post-decrement operator.
+        * @breif Increment and decrement operators.
         *
         */
-        Iterator & operator -- (int);
+        Iterator & operator ++ ();
+        Iterator operator ++ (int);
+        Iterator & operator -- ();
+        Iterator operator -- (int);
 
         /**
-        * @breif Check if iterator is equal to other iterator.
+        * @breif Random access operators.
         *
         */
-        bool operator == (const Iterator & it);
+        Iterator & operator += (const difference_type offset);
+        Iterator & operator -= (const difference_type offset);
+        Iterator operator + (const difference_type offset) const;
+        Iterator operator - (const difference_type offset) const;
+        difference_type operator - (const Iterator & it) const;
 
         /**
-        * @breif Check if iterator is not equal to other iterator.
+        * @breif Comparison operators.
         *
         */
-        bool operator != (const Iterator & it);
+        bool operator == (const Iterator & it) const;
+        bool operator != (const Iterator & it) const;
+        bool operator < (const Iterator & it) const;
+        bool operator > (const Iterator & it) const;
+        bool operator <= (const Iterator & it) const;
+        bool operator >= (const Iterator & it) const;
 
     private:
 
@@ -325,14 +702,19 @@ namespace Yaml
             MapType
         };
 
-        eType   m_Type; ///< Type of iterator.
-        void *  m_pImp; ///< Implementation of iterator class.
+        eType                                   m_Type;             ///< Type of iterator.
+        std::vector<Node*>::iterator            m_SequenceIterator; ///< Iterator of sequence.
+        std::map<std::string, Node*>::iterator  m_MapIterator;      ///< Iterator of map.
 
     };
 
 
     /**
     * @breif Constant iterator class.
+    *        Value type without heap allocations, with random access operators.
+    *        Random access operators of map iterators are linear in distance.
+    *        Sequence items are stored in a vector, adding or erasing items of a sequence
+    *        invalidates all of its iterators. Only iterators of erased map items are invalidated.
     *
     */
     class ConstIterator
@@ -342,6 +724,12 @@ namespace Yaml
 
         friend class Node;
 
+        typedef std::random_access_iterator_tag                 iterator_category;
+        typedef std::pair<const std::string &, const Node &>    value_type;
+        typedef std::ptrdiff_t                                  difference_type;
+        typedef value_type                                      reference;
+        typedef void                                            pointer;
+
         /**
         * @breif Default constructor.
         *
@@ -349,53 +737,53 @@ namespace Yaml
         ConstIterator();
 
         /**
-        * @breif Copy constructor.
-        *
-        */
-        ConstIterator(const ConstIterator & it);
-
-        /**
-        * @breif Assignment operator.
-        *
-        */
-        ConstIterator & operator = (const ConstIterator & it);
-
-        /**
-        * @breif Destructor.
+        * @breif Conversion constructor from non-constant iterator.
         *
         */
-        ~ConstIterator();
+        ConstIterator(const Iterator & it);
 
         /**
         * @breif Get node of iterator.
         *        First pair item is the key of map value, empty if type is sequence.
         *
         */
-        std::pair<const std::string &, const Node &> operator *();
+        reference operator *() const;
 
         /**
-        * @breif Post-increment operator.
+        * @breif Get node at offset from iterator.
         *
         */
-        ConstIterator & operator ++ (int);
+        reference operator [] (const difference_type offset) const;
 
         /**
-        * @breif Post-decrement operator.
+        * @breif Increment and decrement operators.
         *
         */
-        ConstIterator & operator -- (int);
+        ConstIterator & operator ++ ();
+        ConstIterator operator ++ (int);
+        ConstIterator & operator -- ();
+        ConstIterator operator -- (int);
 
         /**
-        * @breif Check if iterator is equal to other iterator.
+        * @breif Random access operators.
         *
         */
-        bool operator == (const ConstIterator & it);
+        ConstIterator & operator += (const difference_type offset);
+        ConstIterator & operator -= (const difference_type offset);
+        ConstIterator operator + (const difference_type offset) const;
+        ConstIterator operator - (const difference_type offset) const;
+        difference_type operator - (const ConstIterator & it) const;
 
         /**
-        * @breif Check if iterator is not equal to other iterator.
+        * @breif Comparison operators.
         *
         */
-        bool operator != (const ConstIterator & it);
+        bool operator == (const ConstIterator & it) const;
+        bool operator != (const ConstIterator & it) const;
+        bool operator < (const ConstIterator & it) const;
+        bool operator > (const ConstIterator & it) const;
+        bool operator <= (const ConstIterator & it) const;
+        bool operator >= (const ConstIterator & it) const;
 
     private:
 
@@ -406,8 +794,9 @@ namespace Yaml
             MapType
         };
 
-        eType   m_Type; ///< Type of iterator.
-        void *  m_pImp; ///< Implementation of constant iterator class.
+        eType                                         m_Type;             ///< Type of iterator.
+        std::vector<Node*>::const_iterator            m_SequenceIterator; ///< Iterator of sequence.
+        std::map<std::string, Node*>::const_iterator  m_MapIterator;      ///< Iterator of map.
 
     };
 
@@ -422,6 +811,8 @@ namespace Yaml
     public:
 
         friend class Iterator;
+        friend class ParseImp;
+        friend class NodeImp;
 
         /**
         * @breif Enumeration of node types.
@@ -435,6 +826,19 @@ namespace Yaml
             ScalarType
         };
 
+        /**
+        * @breif Enumeration of scalar data types.
+        *
+        */
+        enum eDataType
+        {
+            StringData,
+            NullData,
+            BooleanData,
+            IntegerData,
+            FloatData
+        };
+
         /**
         * @breif Default constructor.
         *
@@ -479,12 +883,13 @@ namespace Yaml
 
         /**
         * @breif Get node as given template type.
+        *        Sequences can be converted to std::vector and maps to std::map<std::string, T>.
         *
         */
         template<typename T>
         T As() const
         {
-            return impl::StringConverter<T>::Get(AsString());
+            return impl::NodeConverter<T>::Get(*this);
         }
 
         /**
@@ -494,9 +899,55 @@ namespace Yaml
         template<typename T>
         T As(const T & defaultValue) const
         {
-            return impl::StringConverter<T>::Get(AsString(), defaultValue);
+            return impl::NodeConverter<T>::Get(*this, defaultValue);
+        }
+
+        /**
+        * @breif Convert all scalars of sequence to vector, in one traversal of the sequence.
+        *        Numbers and booleans are parsed directly into the vector, without caching conversions of elements.
+        *        Empty vector is returned if node is not a sequence.
+        *
+        */
+        template<typename T>
+        std::vector<T> AsVector() const
+        {
+            std::vector<T> vector;
+            if(IsSequence() == false)
+            {
+                return vector;
+            }
+            AppendElements(vector, std::integral_constant<bool, impl::CacheConverter<T>::Enabled>());
+            return vector;
+        }
+
+        /**
+        * @breif Convert scalars of sequence to array, in one traversal of the sequence.
+        *
+        * @param pOut   Output array.
+        * @param count  Maximum number of elements to convert.
+        *
+        * @return Number of converted elements, the lesser of count and size of sequence.
+        *         0 if node is not a sequence.
+        *
+        */
+        template<typename T>
+        size_t CopyTo(T * pOut, const size_t count) const
+        {
+            if(IsSequence() == false)
+            {
+                return 0;
+            }
+            return CopyElements(pOut, count, std::integral_constant<bool, impl::CacheConverter<T>::Enabled>());
         }
 
+        /**
+        * @breif Get data type of scalar.
+        *        Scalars are strings, unless typed while parsing(see ParseConfig::TypedScalars) or by tags("!!int").
+        *        StringData is returned if node is not a scalar.
+        *
+        */
+        eDataType DataType() const;
+
         /**
         * @breif Get size of node.
         *        Nodes of type None or Scalar will return 0.
@@ -510,6 +961,8 @@ namespace Yaml
         * @breif Insert sequence item at given index.
         *        Converts node to sequence type if needed.
         *        Adding new item to end of sequence if index is larger than sequence size.
+        *        Adding or erasing sequence items invalidates all iterators of the sequence,
+        *        references to item nodes stay valid.
         *
         */
         Node & Insert(const size_t index);
@@ -539,6 +992,15 @@ namespace Yaml
         Node & operator []  (const size_t index);
         Node & operator [] (const std::string & key);
 
+        /**
+        * @breif Find sequence/map item, without modifying node.
+        *
+        * @return Pointer to item, nullptr if node is not a sequence/map or if index or key is unknown.
+        *
+        */
+        const Node * Find(const size_t index) const;
+        const Node * Find(const std::string & key) const;
+
         /**
         * @breif Erase item.
         *        No action if node is not a sequence or map.
@@ -555,6 +1017,47 @@ namespace Yaml
         Node & operator = (const std::string & value);
         Node & operator = (const char * value);
 
+        /**
+        * @breif Assignment operator of numbers and booleans.
+        *        Converts node to scalar type if needed. See Set.
+        *
+        */
+        template<typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value && !impl::IsCharacter<T>::value, Node &>::type
+        operator = (const T value)
+        {
+            return Set(value);
+        }
+
+        /**
+        * @breif Set scalar value of node. Converts node to scalar type if needed.
+        *        Numbers and booleans are formatted without streams, floating point numbers
+        *        with the least number of digits parsed back to equal value. The value is stored natively as well,
+        *        see DataType, except for unsigned integers larger than the maximum value of int64_t.
+        *
+        */
+        template<typename T>
+        typename std::enable_if<std::is_arithmetic<T>::value && !impl::IsCharacter<T>::value, Node &>::type
+        Set(const T value)
+        {
+            if(std::is_same<T, bool>::value)
+            {
+                return SetBoolean(static_cast<bool>(value));
+            }
+            if(std::is_floating_point<T>::value)
+            {
+                return SetFloat(static_cast<double>(value));
+            }
+            if(std::is_signed<T>::value)
+            {
+                return SetInteger(static_cast<int64_t>(value));
+            }
+            return SetUnsignedInteger(static_cast<uint64_t>(value));
+        }
+
+        Node & Set(const std::string & value);
+        Node & Set(const char * value);
+
         /**
         * @breif Get start iterator.
         *
@@ -569,20 +1072,225 @@ namespace Yaml
         Iterator End();
         ConstIterator End() const;
 
-
-    private:
-
         /**
-        * @breif Get as string. If type is scalar, else empty.
+        * @breif Get start and end iterators, for range-based for loops.
         *
         */
-        const std::string & AsString() const;
+        Iterator begin();
+        ConstIterator begin() const;
+        Iterator end();
+        ConstIterator end() const;
 
-        void * m_pImp; ///< Implementation of node class.
+
+    private:
+
+        template<typename T, typename Enable>
+        friend struct impl::NodeConverter;
+        template<typename T, typename Enable>
+        friend struct impl::Decoder;
+
+        /**
+        * @breif Function called by VisitElements for each element.
+        *
+        * @param pContext   Context passed to VisitElements.
+        * @param index      Index of element.
+        * @param pKey       Key of element if node is a map, else nullptr.
+        * @param element    Element node.
+        *
+        */
+        typedef void (*ElementVisitor)(void * pContext, const size_t index, const std::string * pKey, const Node & element);
+
+        /**
+        * @breif Visit elements of sequence or map in order, without allocating iterators.
+        *
+        * @return Number of visited elements.
+        *
+        */
+        size_t VisitElements(ElementVisitor visitor, void * pContext, const size_t maxCount) const;
+
+        /**
+        * @breif Convert scalars of sequence to numbers or booleans, in a single loop over the elements.
+        *        Natively typed values are used if available, else strings are parsed without caching the result.
+        *        Instantiated for all types enabled by impl::CacheConverter.
+        *
+        * @return Number of converted elements, the lesser of count and size of sequence.
+        *
+        */
+        template<typename T>
+        size_t ConvertNumbers(T * pOut, const size_t count) const;
+
+        template<typename T>
+        void AppendElements(std::vector<T> & vector, std::false_type) const
+        {
+            vector.reserve(Size());
+            VisitElements(&PushElement<T>, &vector, Size());
+        }
+
+        template<typename T>
+        void AppendElements(std::vector<T> & vector, std::true_type) const
+        {
+            vector.resize(Size());
+            vector.resize(ConvertNumbers(vector.data(), vector.size()));
+        }
+
+        void AppendElements(std::vector<bool> & vector, std::true_type) const
+        {
+            const size_t size = Size();
+            std::unique_ptr<bool[]> buffer(new bool[size ? size : 1]);
+            const size_t count = ConvertNumbers(buffer.get(), size);
+            vector.assign(buffer.get(), buffer.get() + count);
+        }
+
+        template<typename T>
+        size_t CopyElements(T * pOut, const size_t count, std::false_type) const
+        {
+            return VisitElements(&CopyElement<T>, pOut, count);
+        }
+
+        template<typename T>
+        size_t CopyElements(T * pOut, const size_t count, std::true_type) const
+        {
+            return ConvertNumbers(pOut, count);
+        }
+
+        template<typename T>
+        static void PushElement(void * pContext, const size_t, const std::string *, const Node & element)
+        {
+            static_cast<std::vector<T>*>(pContext)->push_back(element.As<T>());
+        }
+
+        template<typename T>
+        static void CopyElement(void * pContext, const size_t index, const std::string *, const Node & element)
+        {
+            static_cast<T*>(pContext)[index] = element.As<T>();
+        }
+
+        template<typename T>
+        static void InsertElement(void * pContext, const size_t, const std::string * pKey, const Node & element)
+        {
+            static_cast<std::map<std::string, T>*>(pContext)->insert({*pKey, element.As<T>()});
+        }
+
+        /**
+        * @breif Set natively typed scalar value.
+        *
+        */
+        Node & SetInteger(const int64_t value);
+        Node & SetUnsignedInteger(const uint64_t value);
+        Node & SetFloat(const double value);
+        Node & SetBoolean(const bool value);
+        Node & SetNative(const char * data, const size_t size, const impl::ScalarValue & value);
+
+        /**
+        * @breif Get as string. If type is scalar, else empty.
+        *
+        */
+        const std::string & AsString() const;
+
+        /**
+        * @breif Get natively typed value. Value type is NoneType if not a typed scalar.
+        *
+        */
+        const impl::ScalarValue & NativeValue() const;
+
+        /**
+        * @breif Get scalar string parsed as requested kind of number.
+        *        The last parsed number is cached, until the scalar is modified.
+        *        Safe for concurrent readers, readers racing to fill the cache parse without caching.
+        *
+        */
+        impl::ScalarNumber CachedValue(const impl::ScalarNumber::eKind kind) const;
+
+        void * m_pImp; ///< Implementation of node class.
 
     };
 
 
+    namespace impl
+    {
+
+        template<typename T, typename Enable>
+        struct NodeConverter
+        {
+            static T Get(const Node & node)
+            {
+                T type;
+                if(ValueConverter<T>::Enabled && ValueConverter<T>::Get(node.NativeValue(), type))
+                {
+                    return type;
+                }
+                if(CacheConverter<T>::Enabled)
+                {
+                    type = T();
+                    CacheConverter<T>::Get(node.CachedValue(CacheConverter<T>::Kind), type);
+                    return type;
+                }
+                return StringConverter<T>::Get(node.AsString());
+            }
+
+            static T Get(const Node & node, const T & defaultValue)
+            {
+                T type;
+                if(ValueConverter<T>::Enabled && ValueConverter<T>::Get(node.NativeValue(), type))
+                {
+                    return type;
+                }
+                if(CacheConverter<T>::Enabled)
+                {
+                    if(CacheConverter<T>::Get(node.CachedValue(CacheConverter<T>::Kind), type) != NumberOk)
+                    {
+                        return defaultValue;
+                    }
+                    return type;
+                }
+                return StringConverter<T>::Get(node.AsString(), defaultValue);
+            }
+        };
+
+        template<typename T>
+        struct NodeConverter<std::vector<T> >
+        {
+            static std::vector<T> Get(const Node & node)
+            {
+                return node.AsVector<T>();
+            }
+
+            static std::vector<T> Get(const Node & node, const std::vector<T> & defaultValue)
+            {
+                if(node.IsSequence() == false)
+                {
+                    return defaultValue;
+                }
+                return node.AsVector<T>();
+            }
+        };
+
+        template<typename T>
+        struct NodeConverter<std::map<std::string, T> >
+        {
+            static std::map<std::string, T> Get(const Node & node)
+            {
+                std::map<std::string, T> map;
+                if(node.IsMap())
+                {
+                    node.VisitElements(&Node::InsertElement<T>, &map, node.Size());
+                }
+                return map;
+            }
+
+            static std::map<std::string, T> Get(const Node & node, const std::map<std::string, T> & defaultValue)
+            {
+                if(node.IsMap() == false)
+                {
+                    return defaultValue;
+                }
+                return Get(node);
+            }
+        };
+
+    }
+
+
     /**
     * @breif Parsing functions.
     *        Population given root node with deserialized data.
@@ -605,6 +1313,203 @@ namespace Yaml
     void Parse(Node & root, const char * buffer, const size_t size);
 
 
+    /**
+    * @breif    Parsing configuration structure,
+    *           describing parsing behavior.
+    *
+    */
+    struct ParseConfig
+    {
+
+        /**
+        * @breif Constructor.
+        *
+        * @param sourceLocations    Record line and column of all parsed nodes. See Document::LocationOf.
+        * @param typedScalars       Detect null, boolean, integer and floating point values of plain scalars,
+        *                           stored natively together with the original string. See Node::DataType.
+        *
+        */
+        ParseConfig(const bool sourceLocations = false,
+                    const bool typedScalars = false);
+
+        bool SourceLocations;   ///< Record line and column of all parsed nodes.
+        bool TypedScalars;      ///< Detect null, boolean, integer and floating point values of plain scalars.
+    };
+
+
+    /**
+    * @breif Location of node in parsed input data.
+    *
+    */
+    struct Location
+    {
+
+        /**
+        * @breif Constructor.
+        *
+        */
+        Location(const size_t line = 0, const size_t column = 0);
+
+        size_t Line;    ///< Line number, starting at 1. Equal to 0 if location is unknown.
+        size_t Column;  ///< Column number, starting at 1. Equal to 0 if location is unknown.
+    };
+
+
+    /**
+    * @breif Document class.
+    *        Root node of parsed data, together with optional parsing information.
+    *
+    */
+    class Document
+    {
+
+    public:
+
+        friend void Parse(Document & document, std::iostream & stream, const ParseConfig & config);
+
+        /**
+        * @breif Default constructor.
+        *
+        */
+        Document();
+
+        /**
+        * @breif Destructor.
+        *
+        */
+        ~Document();
+
+        /**
+        * @breif Get root node.
+        *
+        */
+        Node & Root();
+        const Node & Root() const;
+
+        /**
+        * @breif Get location of node in input data.
+        *        Only available if document is parsed with ParseConfig::SourceLocations enabled.
+        *        Locations are kept in a separate table, filled only while parsing, and parsed nodes are tagged
+        *        with the id of the parse. Nodes added after parsing have no location, even if reusing
+        *        the address of an erased node. Locations of erased nodes are kept until next parse or Clear.
+        *        Keys merged into maps by merge keys("<<") have no location.
+        *
+        * @return Location of node, Line and Column are equal to 0 if no location is found.
+        *
+        */
+        Location LocationOf(const Node & node) const;
+
+        /**
+        * @breif Completely clear document.
+        *
+        */
+        void Clear();
+
+    private:
+
+        /**
+        * @breif Copy constructor.
+        *
+        */
+        Document(const Document & document);
+
+        /**
+        * @breif Assignment operator.
+        *
+        */
+        Document & operator = (const Document & document);
+
+        Node    m_Root; ///< Root node.
+        void *  m_pImp; ///< Implementation of document class.
+
+    };
+
+
+    /**
+    * @breif Parsing functions of documents.
+    *        Population given document with deserialized data.
+    *
+    * @param document   Document to populate.
+    * @param config     Parsing configurations.
+    *
+    * @see Parse
+    *
+    */
+    void Parse(Document & document, const char * filename, const ParseConfig & config = {false, false});
+    void Parse(Document & document, std::iostream & stream, const ParseConfig & config = {false, false});
+    void Parse(Document & document, const std::string & string, const ParseConfig & config = {false, false});
+    void Parse(Document & document, const char * buffer, const size_t size, const ParseConfig & config = {false, false});
+
+
+    /**
+    * @breif Thread safe cache of parsed documents, keyed by filename.
+    *        A cached document is returned if device, inode, modification time and size of the file
+    *        are unchanged, or if the content hash of the reread file matches. Otherwise the file is parsed.
+    *        Concurrent misses of the same file are parsed once, with all callers waiting for the result.
+    *        Least recently used documents are evicted when the estimated memory usage exceeds the budget.
+    *        Returned documents are immutable and stay valid after eviction.
+    *
+    */
+    class DocumentCache
+    {
+
+    public:
+
+        /**
+        * @breif Constructor.
+        *
+        * @param memoryBudget   Maximum estimated memory usage of cached documents, in bytes.
+        * @param config         Parsing configurations.
+        *
+        */
+        DocumentCache(const size_t memoryBudget = 268435456, const ParseConfig & config = {false, false});
+
+        /**
+        * @breif Destructor.
+        *
+        */
+        ~DocumentCache();
+
+        DocumentCache(const DocumentCache &) = delete;
+        DocumentCache & operator = (const DocumentCache &) = delete;
+
+        /**
+        * @breif Get parsed document of file.
+        *
+        * @throw OperationException If file cannot be opened.
+        * @throw ParsingException If file cannot be parsed. Failed parses are not cached.
+        *
+        */
+        std::shared_ptr<const Document> Get(const char * filename);
+
+        /**
+        * @breif Remove document of file, or all documents, from cache.
+        *
+        */
+        void Erase(const char * filename);
+        void Clear();
+
+        /**
+        * @breif Get number of cached documents and their estimated memory usage.
+        *
+        */
+        size_t Size() const;
+        size_t MemoryUsage() const;
+
+        /**
+        * @breif Get number of calls to Get served from cache, and number of parsed files.
+        *
+        */
+        size_t Hits() const;
+        size_t Parses() const;
+
+    private:
+
+        void * m_pImp; ///< Implementation of document cache class.
+
+    };
+
+
     /**
     * @breif    Serialization configuration structure,
     *           describing output behavior.
@@ -613,6 +1518,17 @@ namespace Yaml
     struct SerializeConfig
     {
 
+        /**
+        * @breif Enumeration of output styles.
+        *
+        */
+        enum eStyle
+        {
+            BlockStyle, ///< Indented block collections.
+            FlowStyle,  ///< Single line flow collections, {key: value, ...} and [a, b, ...].
+            JsonStyle   ///< Single line strict JSON, without whitespace.
+        };
+
         /**
         * @breif Constructor.
         *
@@ -621,36 +1537,1713 @@ namespace Yaml
         *                               Ignored if equal to 0.
         * @param sequenceMapNewline     Put maps on a new line if parent node is a sequence.
         * @param mapScalarNewline       Put scalars on a new line if parent node is a map.
+        * @param style                  Output style. Indentation and newline configurations are ignored by flow styles.
+        * @param flowSequenceLength     Maximum length of sequences of scalars, written as flow sequences by block style.
+        *                               Applies to nodes, not C++ containers written by Encode.
+        *                               Ignored if equal to 0.
         *
         */
         SerializeConfig(const size_t spaceIndentation = 2,
                         const size_t scalarMaxLength = 64,
                         const bool sequenceMapNewline = false,
-                        const bool mapScalarNewline = false);
+                        const bool mapScalarNewline = false,
+                        const eStyle style = BlockStyle,
+                        const size_t flowSequenceLength = 0);
 
         size_t SpaceIndentation;    ///< Number of spaces per indentation.
         size_t ScalarMaxLength;     ///< Maximum length of scalars. Serialized as folder scalars if exceeded.
         bool SequenceMapNewline;    ///< Put maps on a new line if parent node is a sequence.
         bool MapScalarNewline;      ///< Put scalars on a new line if parent node is a map.
+        eStyle Style;               ///< Output style.
+        size_t FlowSequenceLength;  ///< Maximum length of sequences of scalars, written as flow sequences by block style.
     };
 
 
     /**
-    * @breif Serialization functions.
+    * @breif    File output configuration structure,
+    *           describing how serialized files are written.
     *
-    * @param root       Root node to serialize.
-    * @param filename   Path of output file.
+    */
+    struct FileConfig
+    {
+
+        /**
+        * @breif Constructor.
+        *
+        * @param bufferSize     Size of write buffer in bytes. Serialized data is streamed to file through it.
+        * @param atomicReplace  Write to temporary file, renamed to filename when complete.
+        *                       Readers of filename never see partially written data.
+        *                       The replaced file keeps mode and, if permitted, owner of the previous file.
+        *                       Otherwise an existing file is overwritten in place, and truncated when done.
+        *                       It is left unchanged if serializing fails before a full buffer is written.
+        *
+        */
+        FileConfig(const size_t bufferSize = 1048576,
+                   const bool atomicReplace = false);
+
+        size_t BufferSize;  ///< Size of write buffer in bytes.
+        bool AtomicReplace; ///< Write to temporary file, renamed to filename when complete.
+    };
+
+
+    /**
+    * @breif Output sink of serialized data.
+    *
+    */
+    class Sink
+    {
+
+    public:
+
+        /**
+        * @breif Destructor.
+        *
+        */
+        virtual ~Sink();
+
+        /**
+        * @breif Write data to sink.
+        *
+        */
+        virtual void Write(const char * data, const size_t size) = 0;
+        void Write(const std::string & string);
+
+        /**
+        * @breif Write single character to sink.
+        *
+        */
+        void Put(const char character);
+
+        /**
+        * @breif Write spaces to sink.
+        *
+        */
+        void Spaces(const size_t count);
+
+    };
+
+
+    /**
+    * @breif Sink writing to output stream.
+    *
+    */
+    class StreamSink : public Sink
+    {
+
+    public:
+
+        /**
+        * @breif Constructor.
+        *
+        */
+        StreamSink(std::ostream & stream);
+
+        using Sink::Write;
+        virtual void Write(const char * data, const size_t size);
+
+    private:
+
+        std::ostream & m_Stream; ///< Output stream.
+
+    };
+
+
+    /**
+    * @breif Sink appending to string.
+    *
+    */
+    class StringSink : public Sink
+    {
+
+    public:
+
+        /**
+        * @breif Constructor.
+        *
+        * @param string     Output string.
+        * @param reserve    Number of bytes to reserve in string, avoiding reallocations while writing.
+        *
+        */
+        StringSink(std::string & string, const size_t reserve = 0);
+
+        using Sink::Write;
+        virtual void Write(const char * data, const size_t size);
+
+    private:
+
+        std::string & m_String; ///< Output string.
+
+    };
+
+
+    /**
+    * @breif Sink writing to fixed buffer of caller, without allocations.
+    *        Data not fitting in buffer is discarded, but still counted by Size.
+    *
+    */
+    class BufferSink : public Sink
+    {
+
+    public:
+
+        /**
+        * @breif Constructor.
+        *
+        */
+        BufferSink(char * buffer, const size_t capacity);
+
+        using Sink::Write;
+        virtual void Write(const char * data, const size_t size);
+
+        /**
+        * @breif Get number of bytes written, including discarded bytes.
+        *
+        */
+        size_t Size() const;
+
+        /**
+        * @breif Check if any bytes were discarded, because of insufficient capacity.
+        *
+        */
+        bool Overflow() const;
+
+    private:
+
+        char *  m_pBuffer;  ///< Output buffer.
+        size_t  m_Capacity; ///< Size of buffer.
+        size_t  m_Size;     ///< Number of written bytes.
+
+    };
+
+
+    /**
+    * @breif Sink counting written bytes, without storing them.
+    *
+    */
+    class CountingSink : public Sink
+    {
+
+    public:
+
+        /**
+        * @breif Constructor.
+        *
+        */
+        CountingSink();
+
+        using Sink::Write;
+        virtual void Write(const char * data, const size_t size);
+
+        /**
+        * @breif Get number of written bytes.
+        *
+        */
+        size_t Size() const;
+
+    private:
+
+        size_t m_Size; ///< Number of written bytes.
+
+    };
+
+
+    /**
+    * @breif Sink writing to file descriptor, via internal buffer.
+    *        The buffer is flushed when full, by Flush and by the destructor.
+    *        The file descriptor is not closed.
+    *
+    */
+    class FileSink : public Sink
+    {
+
+    public:
+
+        /**
+        * @breif Constructor.
+        *
+        * @param fd         File descriptor to write to.
+        * @param bufferSize Size of write buffer in bytes.
+        *
+        */
+        FileSink(const int fd, const size_t bufferSize = 65536);
+
+        /**
+        * @breif Destructor, flushing buffered data. Errors are ignored, call Flush to detect them.
+        *
+        */
+        ~FileSink();
+
+        using Sink::Write;
+        virtual void Write(const char * data, const size_t size);
+
+        /**
+        * @breif Write buffered data to file descriptor.
+        *
+        * @throw OperationException If writing fails.
+        *
+        */
+        void Flush();
+
+        /**
+        * @breif Drop buffered data without writing it, e.g. after failed serialization.
+        *
+        */
+        void Discard();
+
+    private:
+
+        FileSink(const FileSink &) = delete;
+        FileSink & operator = (const FileSink &) = delete;
+
+        void WriteFile(const char * data, const size_t size);
+
+        int                 m_Fd;       ///< Output file descriptor.
+        std::vector<char>   m_Buffer;   ///< Write buffer.
+        size_t              m_Size;     ///< Number of buffered bytes.
+
+    };
+
+
+    /**
+    * @breif Serialization functions.
+    *
+    * @param root       Root node to serialize.
+    * @param filename   Path of output file.
     * @param stream     Output stream.
     * @param string     String of output data.
+    * @param sink       Output sink.
     * @param config     Serialization configurations.
+    * @param fileConfig File output configurations.
     *
     * @throw InternalException  An internal error occurred.
     * @throw OperationException If filename or buffer pointer is invalid.
     *                           If config is invalid.
+    *                           If file cannot be written.
     *
     */
-    void Serialize(const Node & root, const char * filename, const SerializeConfig & config = {2, 64, false, false});
+    void Serialize(const Node & root, const char * filename, const SerializeConfig & config = {2, 64, false, false},
+                   const FileConfig & fileConfig = {1048576, false});
     void Serialize(const Node & root, std::iostream & stream, const SerializeConfig & config = {2, 64, false, false});
     void Serialize(const Node & root, std::string & string, const SerializeConfig & config = {2, 64, false, false});
+    void Serialize(const Node & root, Sink & sink, const SerializeConfig & config = {2, 64, false, false});
 
-}
+    /**
+    * @breif Get exact number of bytes written by Serialize, without producing any output.
+    *        Counting stops as soon as limit is exceeded, bounding the work spent on
+    *        trees expanding to huge output, e.g. by nested aliases.
+    *
+    * @param root       Root node to measure.
+    * @param config     Serialization configurations.
+    * @param limit      Maximum number of bytes to count. Ignored if equal to 0.
+    *
+    * @return Number of bytes, or limit + 1 if limit is exceeded.
+    *
+    * @throw OperationException If config is invalid.
+    *
+    */
+    size_t SerializedSize(const Node & root, const SerializeConfig & config = {2, 64, false, false}, const size_t limit = 0);
+
+
+    /**
+    * @breif Binary snapshot functions, saving and loading trees in a compact and versioned format.
+    *        Keys are stored once in a key table, lengths as varints and typed scalars natively,
+    *        with original text stored only if differing from the formatted native value.
+    *        Nodes shared by aliases are saved once and referenced by number, and shared again when loaded.
+    *        Loading decodes the data in a single pass, but allocates every node separately,
+    *        as Parse does. Use MappedDocument for reading without building a tree.
+    *
+    * @param root   Root node to save, or to load into.
+    * @param sink   Output sink.
+    * @param string String of output data.
+    * @param data   Binary data, as written by SaveBinary.
+    * @param size   Size of binary data.
+    *
+    * @throw ParsingException If data is invalid, truncated, nested deeper than 1024 levels
+    *                          or of unsupported version. Root is cleared.
+    *
+    */
+    void SaveBinary(const Node & root, Sink & sink);
+    void SaveBinary(const Node & root, std::string & string);
+    void LoadBinary(Node & root, const char * data, const size_t size);
+    void LoadBinary(Node & root, const std::string & data);
+
+
+    /**
+    * @breif Save node tree in the mapped document format, readable in place by MappedDocument.
+    *        The format is offset based and position independent, with contiguous sequence items
+    *        and hash tables for map lookups. Data is in byte order of the host.
+    *        Nodes shared by aliases are saved as copies.
+    *
+    * @param root   Root node to save.
+    * @param sink   Output sink.
+    * @param string String of output data.
+    *
+    */
+    void SaveMapped(const Node & root, Sink & sink);
+    void SaveMapped(const Node & root, std::string & string);
+
+
+    /**
+    * @breif Read-only view of node in a mapped document, decoded on access.
+    *        Views are small values and valid as long as their document is open.
+    *        Accessing a missing item returns a none view.
+    *
+    */
+    class NodeView
+    {
+
+    public:
+
+        friend class MappedDocument;
+
+        /**
+        * @breif Default constructor, creating none view.
+        *
+        */
+        NodeView();
+
+        /**
+        * @breif Functions for checking type of viewed node.
+        *
+        */
+        Node::eType Type() const;
+        bool IsNone() const;
+        bool IsSequence() const;
+        bool IsMap() const;
+        bool IsScalar() const;
+
+        /**
+        * @breif Get size of sequence/map.
+        *
+        * @return 0 if type is none or scalar, else number of items.
+        *
+        */
+        size_t Size() const;
+
+        /**
+        * @breif Get sequence item in constant time, or map item by hashed key lookup.
+        *
+        * @return View of item, none view if not found.
+        *
+        * @throw ParsingException If document data is invalid.
+        *
+        */
+        NodeView operator [] (const size_t index) const;
+        NodeView operator [] (const std::string & key) const;
+        NodeView Find(const char * key, const size_t size) const;
+
+        /**
+        * @breif Get key and value of map entry, in order of keys.
+        *
+        * @throw OperationException If node is not a map or index is out of range.
+        *
+        */
+        std::string Key(const size_t index) const;
+        NodeView Value(const size_t index) const;
+
+        /**
+        * @breif Get null terminated scalar data, pointing into the document.
+        *
+        * @return Empty string if node is not a scalar.
+        *
+        */
+        const char * Data() const;
+        size_t DataSize() const;
+
+        /**
+        * @breif Get scalar data as string, or natively typed value.
+        *
+        */
+        std::string AsString() const;
+        impl::ScalarValue NativeValue() const;
+
+        /**
+        * @breif Get scalar as any type, converted as by Node::As.
+        *
+        */
+        template<typename T>
+        T As() const
+        {
+            T type;
+            if(impl::ValueConverter<T>::Enabled && impl::ValueConverter<T>::Get(NativeValue(), type))
+            {
+                return type;
+            }
+            return impl::StringConverter<T>::Get(AsString());
+        }
+
+        template<typename T>
+        T As(const T & defaultValue) const
+        {
+            T type;
+            if(impl::ValueConverter<T>::Enabled && impl::ValueConverter<T>::Get(NativeValue(), type))
+            {
+                return type;
+            }
+            return impl::StringConverter<T>::Get(AsString(), defaultValue);
+        }
+
+    private:
+
+        /**
+        * @breif Constructor of view of node record at offset.
+        *
+        */
+        NodeView(const char * pData, const size_t size, const size_t record);
+
+        const char *    m_pData;    ///< Document data.
+        size_t          m_Size;     ///< Size of document data.
+        size_t          m_Record;   ///< Offset of node record, 0 if none view.
+
+    };
+
+
+    /**
+    * @breif Read-only document in the mapped format of SaveMapped.
+    *        Files are memory mapped and traversed in place without decoding,
+    *        so processes mapping the same file share one page cache copy.
+    *        Only the header is validated when opening, offsets are checked on access.
+    *
+    */
+    class MappedDocument
+    {
+
+    public:
+
+        friend void AttachShared(MappedDocument & document, const char * name);
+
+        /**
+        * @breif Default constructor.
+        *
+        */
+        MappedDocument();
+
+        /**
+        * @breif Destructor, closing document.
+        *
+        */
+        ~MappedDocument();
+
+        MappedDocument(const MappedDocument &) = delete;
+        MappedDocument & operator = (const MappedDocument &) = delete;
+
+        /**
+        * @breif Open document by memory mapping file, or as view of data owned by caller.
+        *        Data must be 8 byte aligned and outlive the document.
+        *
+        * @throw OperationException If file cannot be opened or mapped.
+        * @throw ParsingException If header is invalid.
+        *
+        */
+        void Open(const char * filename);
+        void Open(const char * data, const size_t size);
+
+        /**
+        * @breif Close document, unmapping file. Views of document are invalidated.
+        *
+        */
+        void Close();
+
+        /**
+        * @breif Check if document is open.
+        *
+        */
+        bool IsOpen() const;
+
+        /**
+        * @breif Get view of root node. None view if document is not open.
+        *
+        */
+        NodeView Root() const;
+
+        /**
+        * @breif Get generation of shared memory document, see AttachShared.
+        *
+        * @return 0 if document is not attached to shared memory.
+        *
+        */
+        uint64_t Generation() const;
+
+    private:
+
+        const char *    m_pData;        ///< Document data.
+        size_t          m_Size;         ///< Size of document data.
+        void *          m_pMapping;     ///< Memory mapping of file, nullptr if not mapped.
+        size_t          m_MappingSize;  ///< Size of memory mapping.
+        uint64_t        m_Generation;   ///< Generation of shared memory document.
+
+    };
+
+
+    /**
+    * @breif Shared memory publication of documents, for readers in multiple processes.
+    *        Each publish reserves a new generation in the control segment called name, writes
+    *        its own POSIX shared memory segment in the mapped document format, and then makes
+    *        it current. The segment of the replaced generation is unlinked, while readers still
+    *        attached to it keep their mapping. Concurrent publishers never touch each other's
+    *        segments, a publish superseded by a newer generation is discarded.
+    *        Names follow shm_open rules, starting with '/'.
+    *
+    * @param root       Root node to publish.
+    * @param name       Name of control segment.
+    * @param mode       Permissions of created segments, before umask. Readable by owner only by default,
+    *                   readers of other users need a mode granting them read access.
+    * @param document   Document attached to current generation, readable until closed.
+    *
+    * @throw OperationException If shared memory cannot be created or mapped, nothing is published,
+    *                           or shared memory is not supported by the platform.
+    * @throw ParsingException If published data is invalid.
+    *
+    */
+    void PublishShared(const Node & root, const char * name, const unsigned int mode = 0600);
+    void AttachShared(MappedDocument & document, const char * name);
+
+    /**
+    * @breif Get current generation of shared memory document.
+    *        Readers attach again if it differs from MappedDocument::Generation.
+    *
+    * @return 0 if nothing is published.
+    *
+    */
+    uint64_t SharedGeneration(const char * name);
+
+    /**
+    * @breif Unlink shared memory segments of name. Attached readers are unaffected.
+    *
+    */
+    void RemoveShared(const char * name);
+
+
+    /**
+    * @breif Binding of struct fields to map keys, specialized by YAML_BIND.
+    *
+    */
+    template<typename T>
+    struct Binding
+    {
+        static const bool Enabled = false;
+    };
+
+
+    namespace impl
+    {
+
+        /**
+        * @breif Bound field of struct. Tables of fields are generated at compile time by YAML_BIND.
+        *
+        */
+        template<typename T>
+        struct BindField
+        {
+            const char *    Name;                                       ///< Key of field.
+            size_t          NameSize;                                   ///< Length of key.
+            void            (*Decode)(const Node & node, T & object);   ///< Decode function of field.
+            Node::eType     (*Type)(const T & object);                  ///< Node type of encoded field, None if skipped.
+            void            (*Encode)(const T & object, Sink & sink, const bool useLevel,
+                                      const size_t level, const SerializeConfig & config); ///< Encode function of field.
+        };
+
+        /**
+        * @breif Helper functionality, decoding node into bound structs, std containers or any type supported by As.
+        *        Fields, elements and values missing in node are left untouched,
+        *        values failing to convert keep their previous value.
+        *
+        */
+        template<typename T, typename Enable>
+        struct Decoder
+        {
+            static void Decode(const Node & node, T & object)
+            {
+                object = node.As<T>(object);
+            }
+        };
+
+        template<typename T>
+        struct Decoder<T, typename std::enable_if<Binding<T>::Enabled>::type>
+        {
+            static void Decode(const Node & node, T & object)
+            {
+                if(node.IsMap())
+                {
+                    node.VisitElements(&DecodeField, &object, node.Size());
+                }
+            }
+
+            static void DecodeField(void * pContext, const size_t, const std::string * pKey, const Node & element)
+            {
+                size_t count = 0;
+                const BindField<T> * pFields = Binding<T>::Fields(count);
+                for(size_t i = 0; i < count; i++)
+                {
+                    const BindField<T> & field = pFields[i];
+                    if(field.NameSize == pKey->size() && pKey->compare(0, field.NameSize, field.Name) == 0)
+                    {
+                        field.Decode(element, *static_cast<T*>(pContext));
+                        return;
+                    }
+                }
+            }
+        };
+
+        template<typename T>
+        struct Decoder<std::vector<T> >
+        {
+            static void Decode(const Node & node, std::vector<T> & object)
+            {
+                if(node.IsSequence() == false)
+                {
+                    return;
+                }
+                object.clear();
+                object.reserve(node.Size());
+                node.VisitElements(&DecodeElement, &object, node.Size());
+            }
+
+            static void DecodeElement(void * pContext, const size_t, const std::string *, const Node & element)
+            {
+                std::vector<T> & vector = *static_cast<std::vector<T>*>(pContext);
+                T value = T();
+                Decoder<T>::Decode(element, value);
+                vector.push_back(std::move(value));
+            }
+        };
+
+        template<typename T>
+        struct Decoder<std::map<std::string, T> >
+        {
+            static void Decode(const Node & node, std::map<std::string, T> & object)
+            {
+                if(node.IsMap() == false)
+                {
+                    return;
+                }
+                object.clear();
+                node.VisitElements(&DecodeElement, &object, node.Size());
+            }
+
+            static void DecodeElement(void * pContext, const size_t, const std::string * pKey, const Node & element)
+            {
+                std::map<std::string, T> & map = *static_cast<std::map<std::string, T>*>(pContext);
+                Decoder<T>::Decode(element, map[*pKey]);
+            }
+        };
+
+    }
+
+
+    /**
+    * @breif Decode node into object.
+    *        Objects are structs bound by YAML_BIND, std::vector, std::map<std::string, T>
+    *        or any type supported by Node::As. Each map and sequence is traversed once,
+    *        fields are dispatched by the compile time field table of the bound struct.
+    *        Fields missing in input data are left untouched, values failing to convert keep their previous value.
+    *
+    * @param node       Node to decode.
+    * @param string     String of input data, parsed before decoding.
+    * @param object     Object to populate.
+    *
+    * @throw ParsingException   Invalid input YAML data.
+    *
+    */
+    template<typename T>
+    void Decode(const Node & node, T & object)
+    {
+        impl::Decoder<T>::Decode(node, object);
+    }
+
+    template<typename T>
+    void Decode(const std::string & string, T & object)
+    {
+        Node root;
+        Parse(root, string);
+        impl::Decoder<T>::Decode(root, object);
+    }
+
+
+
+    namespace impl
+    {
+
+        /**
+        * @breif Encoding functions shared by Serialize and Encode, writing with equal indentation and quoting rules.
+        *
+        * @param plain      Write scalar as is, without quotes or block style. Used by numbers and booleans.
+        * @param useLevel   Indent first line of scalar.
+        * @param cite       Write single line scalar in double quotes. Used by string scalars quoted in parsed input data,
+        *                   looking like null, booleans or numbers.
+        *
+        */
+        void CheckSerializeConfig(const SerializeConfig & config);
+        void EncodeScalar(Sink & sink, const std::string & value, const bool plain, const bool useLevel,
+                          const size_t level, const SerializeConfig & config, const bool cite = false);
+        void EncodePlainScalar(Sink & sink, const char * data, const size_t size, const bool useLevel, const size_t level,
+                               const SerializeConfig & config);
+        void EncodeKey(Sink & sink, const char * key, const size_t size);
+        void EncodeNode(Sink & sink, const Node & node, const bool useLevel, const size_t level, const SerializeConfig & config);
+
+        /**
+        * @breif Encoding functions of flow styles, writing without newlines.
+        *        Scalars are quoted if needed by the style, or if cited, see EncodeScalar.
+        *        Plain JSON scalars not being numbers, booleans or null are quoted.
+        *
+        */
+        void EncodeFlowScalar(Sink & sink, const char * data, const size_t size, const bool plain, const SerializeConfig & config,
+                              const bool cite = false);
+        void EncodeFlowKey(Sink & sink, const char * key, const size_t size, const SerializeConfig & config);
+        void EncodeFlowSeparator(Sink & sink, const SerializeConfig & config);
+
+        /**
+        * @breif Format numbers locale independently, as plain scalars parsed back to equal values.
+        *        Floating point numbers are written with the least number of digits(15 to 17) needed.
+        *
+        * @param buffer     Output buffer, at least 32 characters.
+        *
+        * @return Number of written characters.
+        *
+        */
+        size_t FormatInteger(char * buffer, const int64_t value);
+        size_t FormatUnsignedInteger(char * buffer, const uint64_t value);
+        size_t FormatFloat(char * buffer, const double value);
+
+        /**
+        * @breif Helper functionality, encoding C++ types directly to sink, without building nodes.
+        *        Supported types are arithmetic types, strings, std::vector, std::map and std::unordered_map
+        *        with string keys, std::unique_ptr, std::shared_ptr, std::optional(C++17), Node and structs bound by YAML_BIND.
+        *        Empty pointers and optionals are skipped, as None nodes by Serialize.
+        *
+        */
+        template<typename T, typename Enable = void>
+        struct Encoder;
+
+        template<typename T>
+        struct Encoder<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value && !IsCharacter<T>::value>::type>
+        {
+            static Node::eType Type(const T &)
+            {
+                return Node::ScalarType;
+            }
+
+            static void Encode(const T & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                char buffer[32];
+                const size_t size = std::is_signed<T>::value ? FormatInteger(buffer, static_cast<int64_t>(value)) :
+                                                               FormatUnsignedInteger(buffer, static_cast<uint64_t>(value));
+                EncodePlainScalar(sink, buffer, size, useLevel, level, config);
+            }
+        };
+
+        template<typename T>
+        struct Encoder<T, typename std::enable_if<std::is_floating_point<T>::value>::type>
+        {
+            static Node::eType Type(const T &)
+            {
+                return Node::ScalarType;
+            }
+
+            static void Encode(const T & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                char buffer[32];
+                const size_t size = FormatFloat(buffer, static_cast<double>(value));
+                EncodePlainScalar(sink, buffer, size, useLevel, level, config);
+            }
+        };
+
+        template<>
+        struct Encoder<bool>
+        {
+            static Node::eType Type(const bool &)
+            {
+                return Node::ScalarType;
+            }
+
+            static void Encode(const bool & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                EncodePlainScalar(sink, value ? "true" : "false", value ? 4 : 5, useLevel, level, config);
+            }
+        };
+
+        template<>
+        struct Encoder<std::string>
+        {
+            static Node::eType Type(const std::string &)
+            {
+                return Node::ScalarType;
+            }
+
+            static void Encode(const std::string & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                EncodeScalar(sink, value, false, useLevel, level, config);
+            }
+        };
+
+        template<>
+        struct Encoder<const char *>
+        {
+            static Node::eType Type(const char * value)
+            {
+                return value ? Node::ScalarType : Node::None;
+            }
+
+            static void Encode(const char * value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                EncodeScalar(sink, value, false, useLevel, level, config);
+            }
+        };
+
+        template<size_t N>
+        struct Encoder<char[N]> : public Encoder<const char *>
+        {
+        };
+
+        template<>
+        struct Encoder<Node>
+        {
+            static Node::eType Type(const Node & value)
+            {
+                return value.Type();
+            }
+
+            static void Encode(const Node & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                EncodeNode(sink, value, useLevel, level, config);
+            }
+        };
+
+        template<typename T>
+        struct Encoder<std::vector<T> >
+        {
+            static Node::eType Type(const std::vector<T> &)
+            {
+                return Node::SequenceType;
+            }
+
+            static void Encode(const std::vector<T> & value, Sink & sink, const bool, const size_t level, const SerializeConfig & config)
+            {
+                if(config.Style != SerializeConfig::BlockStyle)
+                {
+                    sink.Put('[');
+                    size_t count = 0;
+                    for(auto it = value.begin(); it != value.end(); ++it)
+                    {
+                        if(Encoder<T>::Type(*it) == Node::None)
+                        {
+                            continue;
+                        }
+                        if(count++)
+                        {
+                            EncodeFlowSeparator(sink, config);
+                        }
+                        Encoder<T>::Encode(*it, sink, false, 0, config);
+                    }
+                    sink.Put(']');
+                    return;
+                }
+
+                for(auto it = value.begin(); it != value.end(); ++it)
+                {
+                    const Node::eType type = Encoder<T>::Type(*it);
+                    if(type == Node::None)
+                    {
+                        continue;
+                    }
+
+                    sink.Spaces(level);
+                    sink.Write("- ", 2);
+                    bool itemUseLevel = false;
+                    if(type == Node::SequenceType || (type == Node::MapType && config.SequenceMapNewline == true))
+                    {
+                        itemUseLevel = true;
+                        sink.Put('\n');
+                    }
+
+                    Encoder<T>::Encode(*it, sink, itemUseLevel, level + 2, config);
+                }
+            }
+        };
+
+        /**
+        * @breif Encode map entry, skipped if type of value is None.
+        *
+        */
+        template<typename T>
+        void EncodeEntry(const char * key, const size_t keySize, const T & value, Sink & sink,
+                         const bool useLevel, size_t & count, const size_t level, const SerializeConfig & config)
+        {
+            const Node::eType type = Encoder<T>::Type(value);
+            if(type == Node::None)
+            {
+                return;
+            }
+
+            if(config.Style != SerializeConfig::BlockStyle)
+            {
+                if(count > 0)
+                {
+                    EncodeFlowSeparator(sink, config);
+                }
+                EncodeFlowKey(sink, key, keySize, config);
+                Encoder<T>::Encode(value, sink, false, 0, config);
+                count++;
+                return;
+            }
+
+            if(useLevel || count > 0)
+            {
+                sink.Spaces(level);
+            }
+            EncodeKey(sink, key, keySize);
+
+            bool valueUseLevel = false;
+            if(type != Node::ScalarType || config.MapScalarNewline)
+            {
+                valueUseLevel = true;
+                sink.Put('\n');
+            }
+
+            Encoder<T>::Encode(value, sink, valueUseLevel, level + config.SpaceIndentation, config);
+            count++;
+        }
+
+        template<typename Map>
+        struct MapEncoder
+        {
+            static Node::eType Type(const Map &)
+            {
+                return Node::MapType;
+            }
+
+            static void Encode(const Map & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                const bool flow = config.Style != SerializeConfig::BlockStyle;
+                if(flow)
+                {
+                    sink.Put('{');
+                }
+
+                size_t count = 0;
+                for(auto it = value.begin(); it != value.end(); ++it)
+                {
+                    EncodeEntry(it->first.c_str(), it->first.size(), it->second, sink, useLevel, count, level, config);
+                }
+
+                if(flow)
+                {
+                    sink.Put('}');
+                }
+            }
+        };
+
+        template<typename T>
+        struct Encoder<std::map<std::string, T> > : public MapEncoder<std::map<std::string, T> >
+        {
+        };
+
+        template<typename T>
+        struct Encoder<std::unordered_map<std::string, T> > : public MapEncoder<std::unordered_map<std::string, T> >
+        {
+        };
+
+        template<typename Pointer, typename T>
+        struct PointerEncoder
+        {
+            static Node::eType Type(const Pointer & value)
+            {
+                return value ? Encoder<T>::Type(*value) : Node::None;
+            }
+
+            static void Encode(const Pointer & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                Encoder<T>::Encode(*value, sink, useLevel, level, config);
+            }
+        };
+
+        template<typename T>
+        struct Encoder<std::unique_ptr<T> > : public PointerEncoder<std::unique_ptr<T>, T>
+        {
+        };
+
+        template<typename T>
+        struct Encoder<std::shared_ptr<T> > : public PointerEncoder<std::shared_ptr<T>, T>
+        {
+        };
+
+#if YAML_HAS_OPTIONAL
+        template<typename T>
+        struct Encoder<std::optional<T> > : public PointerEncoder<std::optional<T>, T>
+        {
+        };
+#endif
+
+        template<typename T>
+        struct Encoder<T, typename std::enable_if<Binding<T>::Enabled>::type>
+        {
+            static Node::eType Type(const T &)
+            {
+                return Node::MapType;
+            }
+
+            static void Encode(const T & value, Sink & sink, const bool useLevel, const size_t level, const SerializeConfig & config)
+            {
+                size_t count = 0;
+                const BindField<T> * pFields = Binding<T>::Fields(count);
+                const bool flow = config.Style != SerializeConfig::BlockStyle;
+                if(flow)
+                {
+                    sink.Put('{');
+                }
+
+                size_t written = 0;
+                for(size_t i = 0; i < count; i++)
+                {
+                    const BindField<T> & field = pFields[i];
+                    const Node::eType type = field.Type(value);
+                    if(type == Node::None)
+                    {
+                        continue;
+                    }
+
+                    if(flow)
+                    {
+                        if(written > 0)
+                        {
+                            EncodeFlowSeparator(sink, config);
+                        }
+                        EncodeFlowKey(sink, field.Name, field.NameSize, config);
+                        field.Encode(value, sink, false, 0, config);
+                        written++;
+                        continue;
+                    }
+
+                    if(useLevel || written > 0)
+                    {
+                        sink.Spaces(level);
+                    }
+                    EncodeKey(sink, field.Name, field.NameSize);
+
+                    bool valueUseLevel = false;
+                    if(type != Node::ScalarType || config.MapScalarNewline)
+                    {
+                        valueUseLevel = true;
+                        sink.Put('\n');
+                    }
+
+                    field.Encode(value, sink, valueUseLevel, level + config.SpaceIndentation, config);
+                    written++;
+                }
+
+                if(flow)
+                {
+                    sink.Put('}');
+                }
+            }
+        };
+
+    }
+
+
+    /**
+    * @breif Encode object directly to sink, without building nodes.
+    *        Indentation and quoting rules are equal to Serialize.
+    *        Maps are written in iteration order and bound structs in field order.
+    *
+    * @param object     Object to encode. See impl::Encoder for supported types.
+    * @param sink       Output sink.
+    * @param config     Serialization configurations.
+    *
+    * @throw OperationException If config is invalid.
+    *
+    */
+    template<typename T>
+    void Encode(const T & object, Sink & sink, const SerializeConfig & config = {2, 64, false, false})
+    {
+        impl::CheckSerializeConfig(config);
+        if(impl::Encoder<T>::Type(object) != Node::None)
+        {
+            impl::Encoder<T>::Encode(object, sink, false, 0, config);
+            if(config.Style != SerializeConfig::BlockStyle)
+            {
+                sink.Put('\n');
+            }
+        }
+    }
+
+
+
+    /**
+    * @breif Streaming emitter, writing documents incrementally to sink without building nodes.
+    *        Output is equal to Serialize of the equal node tree, following the same configurations.
+    *        FlowSequenceLength is ignored, as sequences are written before their length is known.
+    *        Keys are written at once, making values of None type(e.g. empty pointers) written as null.
+    *        Memory use is bounded by the nesting depth.
+    *
+    *        Example:
+    *           Yaml::Emitter emitter(sink);
+    *           emitter.BeginMap();
+    *           emitter.Key("name");
+    *           emitter.Value("value");
+    *           emitter.Key("list");
+    *           emitter.BeginSeq();
+    *           emitter.Value(1);
+    *           emitter.End();
+    *           emitter.End();
+    *
+    */
+    class Emitter
+    {
+
+    public:
+
+        /**
+        * @breif Constructor.
+        *
+        * @throw OperationException If config is invalid.
+        *
+        */
+        Emitter(Sink & sink, const SerializeConfig & config = {2, 64, false, false});
+
+        /**
+        * @breif Begin map or sequence, as value of current key, item of current sequence or as root.
+        *
+        * @throw OperationException If a key is expected, or if the root is completed.
+        *
+        */
+        void BeginMap();
+        void BeginSeq();
+
+        /**
+        * @breif End current map or sequence.
+        *
+        * @throw OperationException If no map or sequence is begun, or if a value of a key is expected.
+        *
+        */
+        void End();
+
+        /**
+        * @breif Write key of next value in current map.
+        *
+        * @throw OperationException If current collection is not a map, or if a value of a key is expected.
+        *
+        */
+        void Key(const std::string & key);
+        void Key(const char * key, const size_t size);
+
+        /**
+        * @breif Write value, as value of current key, item of current sequence or as root.
+        *        See impl::Encoder for supported types.
+        *
+        * @throw OperationException If a key is expected, or if the root is completed.
+        *
+        */
+        template<typename T>
+        void Value(const T & value)
+        {
+            bool useLevel = false;
+            size_t level = 0;
+            if(BeginValue(impl::Encoder<T>::Type(value), useLevel, level))
+            {
+                impl::Encoder<T>::Encode(value, *m_pSink, useLevel, level, m_Config);
+            }
+            EndValue();
+        }
+
+        /**
+        * @breif Get number of begun maps and sequences.
+        *
+        */
+        size_t Depth() const;
+
+        /**
+        * @breif Check if root value is completely written.
+        *
+        */
+        bool IsComplete() const;
+
+    private:
+
+        /**
+        * @breif Begun map or sequence.
+        *
+        */
+        struct Frame
+        {
+            bool    IsMap;      ///< Map or sequence.
+            bool    UseLevel;   ///< Indent first entry.
+            size_t  Level;      ///< Indentation of entries.
+            size_t  Count;      ///< Number of written entries.
+            bool    HasKey;     ///< Key is written, expecting value.
+        };
+
+        void Begin(const bool isMap);
+        bool BeginValue(const Node::eType type, bool & useLevel, size_t & level);
+        void EndValue();
+
+        Sink *              m_pSink;    ///< Output sink.
+        SerializeConfig     m_Config;   ///< Serialization configurations.
+        std::vector<Frame>  m_Frames;   ///< Stack of begun maps and sequences.
+        bool                m_Complete; ///< Root value is written.
+
+    };
+
+
+
+    /**
+    * @breif    Parallel processing configuration structure.
+    *
+    */
+    struct ParallelConfig
+    {
+
+        /**
+        * @breif Constructor.
+        *
+        * @param threads    Number of threads, including the calling thread.
+        *                   Number of hardware threads is used if equal to 0.
+        * @param chunkSize  Number of elements per chunk taken by a thread at a time.
+        *                   Chosen from number of elements and threads if equal to 0.
+        *
+        */
+        ParallelConfig(const size_t threads = 0,
+                       const size_t chunkSize = 0);
+
+        size_t Threads;     ///< Number of threads, including the calling thread.
+        size_t ChunkSize;   ///< Number of elements per chunk taken by a thread at a time.
+    };
+
+
+    namespace impl
+    {
+
+        /**
+        * @breif Function called by ParallelChunks for each chunk.
+        *
+        * @param pContext   Context passed to ParallelChunks.
+        * @param first      Index of first element of chunk.
+        * @param last       Index past last element of chunk.
+        *
+        */
+        typedef void (*ChunkFunction)(void * pContext, const size_t first, const size_t last);
+
+        /**
+        * @breif Call function(pContext, first, last) for chunks of [0, count) in parallel.
+        *        Idle threads take the next chunk from a shared atomic counter, balancing uneven chunks.
+        *        The calling thread takes part, and the first exception thrown is rethrown after all threads are joined.
+        *        If a thread cannot be started, remaining chunks are taken by the threads already running.
+        *
+        */
+        void ParallelChunks(const size_t count, const ParallelConfig & config, ChunkFunction function, void * pContext);
+
+        template<typename Function>
+        void CallChunk(void * pContext, const size_t first, const size_t last)
+        {
+            (*static_cast<Function*>(pContext))(first, last);
+        }
+
+        /**
+        * @breif Call function(first, last) for chunks of [0, count) in parallel.
+        *
+        */
+        template<typename Function>
+        void ParallelChunks(const size_t count, const ParallelConfig & config, Function function)
+        {
+            ParallelChunks(count, config, &CallChunk<Function>, &function);
+        }
+
+    }
+
+
+    /**
+    * @breif Call function for each element of sequence or map in parallel.
+    *        Sequences are chunked by index, map entries are collected once before chunking.
+    *        Elements are accessed as constant nodes, making concurrent As calls safe.
+    *        No action if node is not a sequence or map.
+    *
+    * @param node       Sequence or map to process.
+    * @param function   Function or lambda, called as function(index, key, element),
+    *                   with key empty if node is a sequence.
+    * @param config     Parallel configurations.
+    *
+    * @throw Exceptions thrown by function, the first one is rethrown after all threads are done.
+    *
+    */
+    template<typename Function>
+    void ParallelForEach(const Node & node, Function function, const ParallelConfig & config = {0, 0})
+    {
+        if(node.IsSequence())
+        {
+            const ConstIterator begin = node.begin();
+            impl::ParallelChunks(node.Size(), config, [&](const size_t first, const size_t last)
+            {
+                ConstIterator it = begin + static_cast<ConstIterator::difference_type>(first);
+                for(size_t i = first; i < last; ++i, ++it)
+                {
+                    const ConstIterator::value_type item = *it;
+                    function(i, item.first, item.second);
+                }
+            });
+        }
+        else if(node.IsMap())
+        {
+            std::vector<ConstIterator> entries;
+            entries.reserve(node.Size());
+            for(ConstIterator it = node.begin(); it != node.end(); ++it)
+            {
+                entries.push_back(it);
+            }
+
+            impl::ParallelChunks(entries.size(), config, [&](const size_t first, const size_t last)
+            {
+                for(size_t i = first; i < last; ++i)
+                {
+                    const ConstIterator::value_type item = *entries[i];
+                    function(i, item.first, item.second);
+                }
+            });
+        }
+    }
+
+    /**
+    * @breif Transform each element of sequence or map in parallel, into output sequence.
+    *        Output is cleared and pre-sized to one None node per input element, before processing.
+    *
+    * @param input      Sequence or map to process.
+    * @param output     Output sequence. Must not be input or any of its elements.
+    * @param function   Function or lambda, called as function(index, key, element, outputElement).
+    * @param config     Parallel configurations.
+    *
+    * @throw Exceptions thrown by function, the first one is rethrown after all threads are done.
+    *
+    */
+    template<typename Function>
+    void Transform(const Node & input, Node & output, Function function, const ParallelConfig & config = {0, 0})
+    {
+        output.Clear();
+        if(input.IsSequence() == false && input.IsMap() == false)
+        {
+            return;
+        }
+        for(size_t i = 0; i < input.Size(); i++)
+        {
+            output.PushBack();
+        }
+
+        const Iterator outputBegin = output.begin();
+        ParallelForEach(input, [&](const size_t index, const std::string & key, const Node & element)
+        {
+            function(index, key, element, (*(outputBegin + static_cast<Iterator::difference_type>(index))).second);
+        }, config);
+    }
+
+
+
+    /**
+    * @breif Serialize in parallel.
+    *        Large sequences and maps are split into chunks of entries, serialized by separate threads
+    *        into buffers that are written to sink in order. Output is identical to sequential serialization.
+    *
+    * @param root           Root node to serialize.
+    * @param sink           Output sink.
+    * @param string         String of output data.
+    * @param config         Serialization configurations.
+    * @param parallelConfig Parallel configurations. Containers with more entries than ChunkSize are split,
+    *                       1024 entries are used if equal to 0. Entries of containers with at most ChunkSize
+    *                       entries are searched for larger containers to split.
+    *
+    * @throw OperationException If config is invalid.
+    *
+    */
+    void Serialize(const Node & root, Sink & sink, const SerializeConfig & config, const ParallelConfig & parallelConfig);
+    void Serialize(const Node & root, std::string & string, const SerializeConfig & config, const ParallelConfig & parallelConfig);
+
+
+    /**
+    * @breif Compiled path query.
+    *        Path syntax:
+    *           key                 Map value of key.
+    *           ["key"], ['key']    Map value of quoted key, which may contain any character.
+    *           [3]                 Sequence element of index.
+    *           *, [*]              All elements of sequence or values of map.
+    *           [?key]              Elements of sequence or values of map, being maps containing key.
+    *           [?key==value]       Elements of sequence or values of map, being maps with scalar value at key.
+    *           [?key!=value]       Elements of sequence or values of map, being maps without scalar value at key.
+    *        Segments are separated by '.', or follow each other directly if bracketed.
+    *        Example: "clusters[*].nodes[?role==db].addr"
+    *
+    */
+    class Path
+    {
+
+    public:
+
+        /**
+        * @breif Compile path.
+        *
+        * @throw OperationException If path syntax is invalid.
+        *
+        */
+        static Path Compile(const std::string & path);
+
+        /**
+        * @breif Default constructor, empty path matching the root node.
+        *
+        */
+        Path();
+
+        /**
+        * @breif Evaluate path.
+        *        Map keys, indices and filters are compiled, making steps free of allocations.
+        *        Nodes are not modified.
+        *
+        * @param root   Root node of query.
+        * @param config Parallel configurations. Branches of the first wildcard or filter are evaluated in parallel.
+        *
+        * @return Matching nodes, in document order.
+        *
+        */
+        std::vector<const Node *> Evaluate(const Node & root) const;
+        std::vector<const Node *> Evaluate(const Node & root, const ParallelConfig & config) const;
+
+        /**
+        * @breif Get number of compiled segments.
+        *
+        */
+        size_t Size() const;
+
+    private:
+
+        /**
+        * @breif Compiled path segment.
+        *
+        */
+        struct Segment
+        {
+            enum eType
+            {
+                KeyType,
+                IndexType,
+                WildcardType,
+                FilterExistsType,
+                FilterEqualType,
+                FilterNotEqualType
+            };
+
+            eType       Type;   ///< Type of segment.
+            std::string Key;    ///< Map key of KeyType, or filtered key.
+            std::string Value;  ///< Filtered value.
+            size_t      Index;  ///< Sequence index of IndexType.
+        };
+
+        void EvaluateSegment(const Node & node, const size_t segment, std::vector<const Node *> & result) const;
+        void EvaluateBranch(const Node & node, const size_t segment, std::vector<const Node *> & result) const;
+
+        std::vector<Segment> m_Segments;    ///< Compiled segments.
+
+    };
+
+
+    /**
+    * @breif Hash index of sequence elements, by values of map fields.
+    *        Single field indexes are keyed by the scalar value of the field.
+    *        Compound indexes are keyed by the values of all fields.
+    *        Fields of sequences with scalars are multi-valued, indexing the element once per value.
+    *        Elements missing a field, or with a field of a map, are not indexed.
+    *
+    *        The index is outdated once elements are inserted or erased from the sequence,
+    *        making lookups throw until Rebuild is called. Changes of field values are not detected.
+    *        The indexed sequence must outlive the index.
+    *
+    */
+    class Index
+    {
+
+    public:
+
+        /**
+        * @breif Default constructor, empty index.
+        *
+        */
+        Index();
+
+        /**
+        * @breif Build index.
+        *
+        * @param sequence   Sequence of maps to index.
+        * @param fields     Fields of compound key, in order.
+        * @param config     Parallel configurations.
+        *
+        * @throw OperationException If fields is empty.
+        *
+        */
+        Index(const Node & sequence, const std::vector<std::string> & fields, const ParallelConfig & config = {0, 0});
+
+        /**
+        * @breif Find first element of sequence, by field value.
+        *
+        * @return Pointer to element, nullptr if not found.
+        *
+        * @throw OperationException If index is outdated or compound.
+        *
+        */
+        const Node * Find(const std::string & value) const;
+
+        /**
+        * @breif Find first element of sequence, by values of compound key.
+        *
+        * @return Pointer to element, nullptr if not found.
+        *
+        * @throw OperationException If index is outdated or number of values is incorrect.
+        *
+        */
+        const Node * Find(const std::vector<std::string> & values) const;
+
+        /**
+        * @breif Find all elements of sequence, by field value, in sequence order.
+        *
+        * @throw OperationException If index is outdated or compound.
+        *
+        */
+        std::vector<const Node *> FindAll(const std::string & value) const;
+
+        /**
+        * @breif Find all elements of sequence, by values of compound key, in sequence order.
+        *
+        * @throw OperationException If index is outdated or number of values is incorrect.
+        *
+        */
+        std::vector<const Node *> FindAll(const std::vector<std::string> & values) const;
+
+        /**
+        * @breif Get number of distinct keys.
+        *
+        */
+        size_t Size() const;
+
+        /**
+        * @breif Check if sequence is unchanged since the index was built.
+        *
+        */
+        bool IsValid() const;
+
+        /**
+        * @breif Rebuild index from current elements of sequence.
+        *
+        */
+        void Rebuild(const ParallelConfig & config = {0, 0});
+
+    private:
+
+        /**
+        * @breif Range of entries of key, linked by Entry::Next.
+        *
+        */
+        struct Bucket
+        {
+            size_t First;
+            size_t Last;
+        };
+
+        /**
+        * @breif Indexed element.
+        *
+        */
+        struct Entry
+        {
+            const Node *    pNode;
+            size_t          Next;
+        };
+
+        size_t FindFirst(const std::string & key) const;
+        std::string CompoundKey(const std::vector<std::string> & values) const;
+
+        const Node *                                m_pSequence;    ///< Indexed sequence.
+        std::vector<std::string>                    m_Fields;       ///< Fields of key.
+        uint64_t                                    m_Version;      ///< Version of sequence, when index was built.
+        std::unordered_map<std::string, Bucket>     m_Buckets;      ///< Entry ranges by key.
+        std::vector<Entry>                          m_Entries;      ///< Indexed elements.
+
+    };
+
+    /**
+    * @breif Build index of sequence elements, by single field or compound key.
+    *
+    * @see Index
+    *
+    */
+    Index BuildIndex(const Node & sequence, const std::string & field, const ParallelConfig & config = {0, 0});
+    Index BuildIndex(const Node & sequence, const std::vector<std::string> & fields, const ParallelConfig & config = {0, 0});
+
+}
+
+
+/**
+* @breif Bind fields of struct to map keys of equal names, enabling Yaml::Decode and Yaml::Encode of the struct.
+*        Must be used in the global namespace, with a fully qualified struct name.
+*        Up to 32 fields are supported.
+*
+* @example struct Limits { int read; int write; };
+*          YAML_BIND(Limits, read, write)
+*
+*/
+#define YAML_BIND(Type, ...) \
+    namespace Yaml \
+    { \
+        template<> \
+        struct Binding<Type> \
+        { \
+            typedef Type BoundType; \
+            static const bool Enabled = true; \
+            static const impl::BindField<Type> * Fields(size_t & count) \
+            { \
+                static const impl::BindField<Type> fields[] = { YAML_BIND_FIELDS(__VA_ARGS__) }; \
+                count = sizeof(fields) / sizeof(fields[0]); \
+                return fields; \
+            } \
+        }; \
+    }
+
+#define YAML_BIND_FIELD(field) \
+    { #field, sizeof(#field) - 1, \
+      [](const ::Yaml::Node & node, BoundType & object) \
+        { ::Yaml::impl::Decoder<decltype(object.field)>::Decode(node, object.field); }, \
+      [](const BoundType & object) \
+        { return ::Yaml::impl::Encoder<decltype(object.field)>::Type(object.field); }, \
+      [](const BoundType & object, ::Yaml::Sink & sink, const bool useLevel, const size_t level, const ::Yaml::SerializeConfig & config) \
+        { ::Yaml::impl::Encoder<decltype(object.field)>::Encode(object.field, sink, useLevel, level, config); } },
+
+#define YAML_BIND_EXPAND(x) x
+#define YAML_BIND_CONCAT(a, b) YAML_BIND_CONCAT_IMP(a, b)
+#define YAML_BIND_CONCAT_IMP(a, b) a##b
+#define YAML_BIND_COUNT(...) YAML_BIND_EXPAND(YAML_BIND_COUNT_IMP(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define YAML_BIND_COUNT_IMP(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define YAML_BIND_FIELDS(...) YAML_BIND_EXPAND(YAML_BIND_CONCAT(YAML_BIND_FIELDS_, YAML_BIND_COUNT(__VA_ARGS__))(__VA_ARGS__))
+#define YAML_BIND_FIELDS_1(f) YAML_BIND_FIELD(f)
+#define YAML_BIND_FIELDS_2(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_1(__VA_ARGS__))
+#define YAML_BIND_FIELDS_3(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_2(__VA_ARGS__))
+#define YAML_BIND_FIELDS_4(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_3(__VA_ARGS__))
+#define YAML_BIND_FIELDS_5(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_4(__VA_ARGS__))
+#define YAML_BIND_FIELDS_6(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_5(__VA_ARGS__))
+#define YAML_BIND_FIELDS_7(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_6(__VA_ARGS__))
+#define YAML_BIND_FIELDS_8(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_7(__VA_ARGS__))
+#define YAML_BIND_FIELDS_9(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_8(__VA_ARGS__))
+#define YAML_BIND_FIELDS_10(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_9(__VA_ARGS__))
+#define YAML_BIND_FIELDS_11(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_10(__VA_ARGS__))
+#define YAML_BIND_FIELDS_12(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_11(__VA_ARGS__))
+#define YAML_BIND_FIELDS_13(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_12(__VA_ARGS__))
+#define YAML_BIND_FIELDS_14(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_13(__VA_ARGS__))
+#define YAML_BIND_FIELDS_15(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_14(__VA_ARGS__))
+#define YAML_BIND_FIELDS_16(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_15(__VA_ARGS__))
+#define YAML_BIND_FIELDS_17(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_16(__VA_ARGS__))
+#define YAML_BIND_FIELDS_18(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_17(__VA_ARGS__))
+#define YAML_BIND_FIELDS_19(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_18(__VA_ARGS__))
+#define YAML_BIND_FIELDS_20(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_19(__VA_ARGS__))
+#define YAML_BIND_FIELDS_21(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_20(__VA_ARGS__))
+#define YAML_BIND_FIELDS_22(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_21(__VA_ARGS__))
+#define YAML_BIND_FIELDS_23(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_22(__VA_ARGS__))
+#define YAML_BIND_FIELDS_24(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_23(__VA_ARGS__))
+#define YAML_BIND_FIELDS_25(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_24(__VA_ARGS__))
+#define YAML_BIND_FIELDS_26(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_25(__VA_ARGS__))
+#define YAML_BIND_FIELDS_27(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_26(__VA_ARGS__))
+#define YAML_BIND_FIELDS_28(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_27(__VA_ARGS__))
+#define YAML_BIND_FIELDS_29(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_28(__VA_ARGS__))
+#define YAML_BIND_FIELDS_30(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_29(__VA_ARGS__))
+#define YAML_BIND_FIELDS_31(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_30(__VA_ARGS__))
+#define YAML_BIND_FIELDS_32(f, ...) YAML_BIND_FIELD(f) YAML_BIND_EXPAND(YAML_BIND_FIELDS_31(__VA_ARGS__))